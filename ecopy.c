@@ -0,0 +1,177 @@
+/*
+ * This file is part of the EtherDFS project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * ecopy copies a file. When both the source and the destination are on the
+ * same EtherDFS drive, it asks EtherDFS for a server-side copy (see the
+ * MPX_SRVCOPY call in mplex.h), so data does not have to travel through the
+ * network twice. Otherwise (or if the server does not support it) the file
+ * is copied the usual way.
+ */
+
+#include <dos.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include "mplex.h"
+#include "version.h"
+
+/* size of the buffer used when copying the usual way */
+#define BUFFSZ 16384
+
+static unsigned char buff[BUFFSZ];
+
+
+/* returns the multiplex id of EtherDFS, or 0 if EtherDFS is not loaded */
+static unsigned char findetherdfs(void) {
+  unsigned char id = 0, res = 0;
+  _asm {
+    mov id, 0C0h /* EtherDFS ids are in range C0..FF */
+    checkid:
+    xor al, al   /* subfunction is 'installation check' (00h) */
+    mov ah, id
+    int 2Fh
+    /* is it EtherDFS? (AL=FF + BX=4D86 CX=7E1 [MV 2017]) */
+    cmp al, 0ffh
+    jne checknextid
+    cmp bx, 4d86h
+    jne checknextid
+    cmp cx, 7e1h
+    jne checknextid
+    mov ah, id
+    mov res, ah
+    jmp gameover
+    checknextid:
+    inc id
+    jnz checkid /* if id is zero, then all range has been covered (C0..FF) */
+    gameover:
+  }
+  return(res);
+}
+
+
+/* returns a pointer to the SFT entry of the DOS file handle h, or NULL if it
+ * cannot be found */
+static void far *getsft(int h) {
+  unsigned short sftseg = 0, sftoff = 0;
+  unsigned char fail = 0;
+  _asm {
+    push es
+    push di
+    mov ax, 1220h   /* get the JFT entry of handle BX (at ES:DI) */
+    mov bx, h
+    int 2Fh
+    jc failed
+    xor bx, bx
+    mov bl, es:[di] /* the JFT entry is the index of the SFT entry */
+    cmp bl, 0ffh
+    je failed
+    mov ax, 1216h   /* get the address of SFT entry BX (at ES:DI) */
+    int 2Fh
+    jc failed
+    mov sftseg, es
+    mov sftoff, di
+    jmp done
+    failed:
+    mov fail, 1
+    done:
+    pop di
+    pop es
+  }
+  if (fail != 0) return(NULL);
+  return(MK_FP(sftseg, sftoff));
+}
+
+
+/* asks EtherDFS (multiplex id mpxid) to copy data as described by p, returns
+ * the AX value it returned (0 on success) */
+static unsigned short srvcopy(unsigned char mpxid, struct mpxcopy *p) {
+  unsigned short res, sig = MPXSIG;
+  _asm {
+    push es
+    push di
+    mov ah, mpxid
+    mov al, MPX_SRVCOPY
+    mov cx, sig
+    push ds
+    pop es
+    mov di, p    /* ES:DI = p (small memory model, p is in DS) */
+    int 2Fh
+    mov res, ax
+    pop di
+    pop es
+  }
+  return(res);
+}
+
+
+int main(int argc, char **argv) {
+  int src, dst;
+  unsigned short ftime, fdate, res = 1;
+  unsigned int rlen, wlen;
+  unsigned char mpxid;
+  unsigned long total = 0;
+  struct mpxcopy p;
+
+  if (argc != 3) {
+    puts("ecopy " PVER " - copies a file, server-side if on an EtherDFS drive\n"
+         "\n"
+         "Usage: ecopy source destination");
+    return(1);
+  }
+
+  if (_dos_open(argv[1], O_RDONLY, &src) != 0) {
+    printf("Error: failed to open %s\n", argv[1]);
+    return(1);
+  }
+  if (_dos_creat(argv[2], _A_NORMAL, &dst) != 0) {
+    printf("Error: failed to create %s\n", argv[2]);
+    _dos_close(src);
+    return(1);
+  }
+  _dos_getftime(src, &fdate, &ftime);
+
+  /* try a server-side copy first (EtherDFS checks that both files are on the
+   * same drive of its own, and answers 1 if it can't help) */
+  mpxid = findetherdfs();
+  if (mpxid != 0) {
+    p.src = getsft(src);
+    p.dst = getsft(dst);
+    p.len = 0xFFFFFFFFlu; /* everything, up to the end of the source file */
+    if ((p.src != NULL) && (p.dst != NULL)) {
+      res = srvcopy(mpxid, &p);
+      /* anything else than 0 or a DOS error code means that EtherDFS is too
+       * old to know about MPX_SRVCOPY */
+      if (res > 0xFF) res = 1;
+      if (res != 1) total = p.len;
+    }
+  }
+
+  /* copy the file the usual way, if needed */
+  if (res == 1) {
+    for (res = 0;;) {
+      if (_dos_read(src, buff, BUFFSZ, &rlen) != 0) {
+        res = 0xFFFFu;
+        break;
+      }
+      if (rlen == 0) break;
+      if ((_dos_write(dst, buff, rlen, &wlen) != 0) || (wlen != rlen)) {
+        res = 0xFFFFu;
+        break;
+      }
+      total += rlen;
+    }
+  }
+
+  _dos_setftime(dst, fdate, ftime);
+  _dos_close(dst);
+  _dos_close(src);
+
+  if (res != 0) {
+    printf("Error: copy failed after %lu bytes\n", total);
+    return(1);
+  }
+  printf("%lu bytes copied\n", total);
+  return(0);
+}
@@ -1,1946 +1,4820 @@
-/*
- * ethdrive - a network drive for DOS running over raw ethernet
- * http://etherdfs.sourceforge.net
- *
- * Copyright (C) 2017 Mateusz Viste
- *
- * Permission is hereby granted, free of charge, to any person obtaining a
- * copy of this software and associated documentation files (the "Software"),
- * to deal in the Software without restriction, including without limitation
- * the rights to use, copy, modify, merge, publish, distribute, sublicense,
- * and/or sell copies of the Software, and to permit persons to whom the
- * Software is furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
- * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
- * DEALINGS IN THE SOFTWARE.
- */
-
-#include <i86.h>     /* union INTPACK */
-#include "chint.h"   /* _mvchain_intr() */
-#include "version.h" /* program & protocol version */
-
-/* set DEBUGLEVEL to 0, 1 or 2 to turn on debug mode with desired verbosity */
-#define DEBUGLEVEL 0
-
-/* define the maximum size of a frame, as sent or received by etherdfs.
- * example: value 1084 accomodates payloads up to 1024 bytes +all headers */
-#define FRAMESIZE 1090
-
-#include "dosstruc.h" /* definitions of structures used by DOS */
-#include "globals.h"  /* global variables used by etherdfs */
-
-/* define NULL, for readability of the code */
-#ifndef NULL
-  #define NULL (void *)0
-#endif
-
-/* all the resident code goes to segment 'BEGTEXT' */
-#pragma code_seg(BEGTEXT, CODE)
-
-
-/* copies l bytes from *s to *d */
-static void copybytes(void far *d, void far *s, unsigned int l) {
-  while (l != 0) {
-    l--;
-    *(unsigned char far *)d = *(unsigned char far *)s;
-    d = (unsigned char far *)d + 1;
-    s = (unsigned char far *)s + 1;
-  }
-}
-
-static unsigned short mystrlen(void far *s) {
-  unsigned short res = 0;
-  while (*(unsigned char far *)s != 0) {
-    res++;
-    s = ((unsigned char far *)s) + 1;
-  }
-  return(res);
-}
-
-/* returns -1 if the NULL-terminated s string contains any wildcard (?, *)
- * character. otherwise returns the length of the string. */
-static int len_if_no_wildcards(char far *s) {
-  int r = 0;
-  for (;;) {
-    switch (*s) {
-      case 0: return(r);
-      case '?':
-      case '*': return(-1);
-    }
-    r++;
-    s++;
-  }
-}
-
-/* this function is called two times by the packet driver. One time for
- * telling that a packet is incoming, and how big it is, so the application
- * can prepare a buffer for it and hand it back to the packet driver. the
- * second call is just to let know that the frame has been copied into the
- * buffer. This is a naked function - I don't need the compiler to get into
- * the way when dealing with packet driver callbacks.
- * IMPORTANT: this function must take care to modify ONLY the registers
- * ES and DI - packet drivers can be easily confused should anything else
- * be modified. */
-void __declspec(naked) far pktdrv_recv(void) {
-  _asm {
-    jmp skip
-    SIG db 'p','k','t','r'
-    skip:
-    /* save DS and flags to stack */
-    push ds  /* save old ds (I will change it) */
-    push bx  /* save bx (I use it as a temporary register) */
-    pushf    /* save flags */
-    /* set my custom DS (not 0, it has been patched at runtime already) */
-    mov bx, 0
-    mov ds, bx
-    /* handle the call */
-    cmp ax, 0
-    jne secondcall /* if ax != 0, then packet driver just filled my buffer */
-    /* first call: the packet driver needs a buffer of CX bytes */
-    cmp cx, FRAMESIZE /* is cx > FRAMESIZE ? (unsigned) */
-    ja nobufferavail  /* it is too small (that's what she said!) */
-    /* see if buffer not filled already... */
-    cmp glob_pktdrv_recvbufflen, 0 /* is bufflen > 0 ? (signed) */
-    jg nobufferavail  /* if signed > 0, then we are busy already */
-
-    /* buffer is available, set its seg:off in es:di */
-    push ds /* set es:di to recvbuff */
-    pop es
-    mov di, offset glob_pktdrv_recvbuff
-    /* set bufferlen to expected len and switch it to neg until data comes */
-    mov glob_pktdrv_recvbufflen, cx
-    neg glob_pktdrv_recvbufflen
-    /* restore flags, bx and ds, then return */
-    jmp restoreandret
-
-  nobufferavail: /* no buffer available, or it's too small -> fail */
-    xor bx,bx      /* set bx to zero... */
-    push bx        /* and push it to the stack... */
-    push bx        /* twice */
-    pop es         /* zero out es and di - this tells the */
-    pop di         /* packet driver 'sorry no can do'     */
-    /* restore flags, bx and ds, then return */
-    jmp restoreandret
-
-  secondcall: /* second call: I've just got data in buff */
-    /* I switch back bufflen to positive so the app can see that something is there now */
-    neg glob_pktdrv_recvbufflen
-    /* restore flags, bx and ds, then return */
-  restoreandret:
-    popf   /* restore flags */
-    pop bx /* restore bx */
-    pop ds /* restore ds */
-    retf
-  }
-}
-
-
-/* translates a drive letter (either upper- or lower-case) into a number (A=0,
- * B=1, C=2, etc) */
-#define DRIVETONUM(x) (((x) >= 'a') && ((x) <= 'z')?x-'a':x-'A')
-
-
-/* all the calls I support are in the range AL=0..2Eh - the list below serves
- * as a convenience to compare AL (subfunction) values */
-enum AL_SUBFUNCTIONS {
-  AL_INSTALLCHK = 0x00,
-  AL_RMDIR      = 0x01,
-  AL_MKDIR      = 0x03,
-  AL_CHDIR      = 0x05,
-  AL_CLSFIL     = 0x06,
-  AL_CMMTFIL    = 0x07,
-  AL_READFIL    = 0x08,
-  AL_WRITEFIL   = 0x09,
-  AL_LOCKFIL    = 0x0A,
-  AL_UNLOCKFIL  = 0x0B,
-  AL_DISKSPACE  = 0x0C,
-  AL_SETATTR    = 0x0E,
-  AL_GETATTR    = 0x0F,
-  AL_RENAME     = 0x11,
-  AL_DELETE     = 0x13,
-  AL_OPEN       = 0x16,
-  AL_CREATE     = 0x17,
-  AL_FINDFIRST  = 0x1B,
-  AL_FINDNEXT   = 0x1C,
-  AL_SKFMEND    = 0x21,
-  AL_UNKNOWN_2D = 0x2D,
-  AL_SPOPNFIL   = 0x2E,
-  AL_UNKNOWN    = 0xFF
-};
-
-/* this table makes it easy to figure out if I want a subfunction or not */
-static unsigned char supportedfunctions[0x2F] = {
-  AL_INSTALLCHK,  /* 0x00 */
-  AL_RMDIR,       /* 0x01 */
-  AL_UNKNOWN,     /* 0x02 */
-  AL_MKDIR,       /* 0x03 */
-  AL_UNKNOWN,     /* 0x04 */
-  AL_CHDIR,       /* 0x05 */
-  AL_CLSFIL,      /* 0x06 */
-  AL_CMMTFIL,     /* 0x07 */
-  AL_READFIL,     /* 0x08 */
-  AL_WRITEFIL,    /* 0x09 */
-  AL_LOCKFIL,     /* 0x0A */
-  AL_UNLOCKFIL,   /* 0x0B */
-  AL_DISKSPACE,   /* 0x0C */
-  AL_UNKNOWN,     /* 0x0D */
-  AL_SETATTR,     /* 0x0E */
-  AL_GETATTR,     /* 0x0F */
-  AL_UNKNOWN,     /* 0x10 */
-  AL_RENAME,      /* 0x11 */
-  AL_UNKNOWN,     /* 0x12 */
-  AL_DELETE,      /* 0x13 */
-  AL_UNKNOWN,     /* 0x14 */
-  AL_UNKNOWN,     /* 0x15 */
-  AL_OPEN,        /* 0x16 */
-  AL_CREATE,      /* 0x17 */
-  AL_UNKNOWN,     /* 0x18 */
-  AL_UNKNOWN,     /* 0x19 */
-  AL_UNKNOWN,     /* 0x1A */
-  AL_FINDFIRST,   /* 0x1B */
-  AL_FINDNEXT,    /* 0x1C */
-  AL_UNKNOWN,     /* 0x1D */
-  AL_UNKNOWN,     /* 0x1E */
-  AL_UNKNOWN,     /* 0x1F */
-  AL_UNKNOWN,     /* 0x20 */
-  AL_SKFMEND,     /* 0x21 */
-  AL_UNKNOWN,     /* 0x22 */
-  AL_UNKNOWN,     /* 0x23 */
-  AL_UNKNOWN,     /* 0x24 */
-  AL_UNKNOWN,     /* 0x25 */
-  AL_UNKNOWN,     /* 0x26 */
-  AL_UNKNOWN,     /* 0x27 */
-  AL_UNKNOWN,     /* 0x28 */
-  AL_UNKNOWN,     /* 0x29 */
-  AL_UNKNOWN,     /* 0x2A */
-  AL_UNKNOWN,     /* 0x2B */
-  AL_UNKNOWN,     /* 0x2C */
-  AL_UNKNOWN_2D,  /* 0x2D */
-  AL_SPOPNFIL     /* 0x2E */
-};
-
-/*
-an INTPACK struct contains following items:
-regs.w.gs
-regs.w.fs
-regs.w.es
-regs.w.ds
-regs.w.di
-regs.w.si
-regs.w.bp
-regs.w.sp
-regs.w.bx
-regs.w.dx
-regs.w.cx
-regs.w.ax
-regs.w.ip
-regs.w.cs
-regs.w.flags (AND with INTR_CF to fetch the CF flag - INTR_CF is defined as 0x0001)
-
-regs.h.bl
-regs.h.bh
-regs.h.dl
-regs.h.dh
-regs.h.cl
-regs.h.ch
-regs.h.al
-regs.h.ah
-*/
-
-
-/* sends query out, as found in glob_pktdrv_sndbuff, and awaits for an answer.
- * this function returns the length of replyptr, or 0xFFFF on error. */
-static unsigned short sendquery(unsigned char query, unsigned char drive, unsigned short bufflen, unsigned char **replyptr, unsigned short **replyax, unsigned int updatermac) {
-  static unsigned char seq;
-  unsigned short count;
-  unsigned char t;
-  unsigned char volatile far *rtc = (unsigned char far *)0x46C; /* this points to a char, while the rtc timer is a word - but I care only about the lowest 8 bits. Be warned that this location won't increment while interrupts are disabled! */
-
-  /* resolve remote drive - no need to validate it, it has been validated
-   * already by inthandler() */
-  drive = glob_data.ldrv[drive];
-
-  /* if query too long then quit */
-  if (bufflen > (sizeof(glob_pktdrv_sndbuff) - 60)) return(0);
-  /* inc seq */
-  seq++;
-  /* I do not fill in ethernet headers (src mac, dst mac, ethertype), nor
-   * PROTOVER, since all these have been inited already at transient time */
-  /* padding (42 bytes) */
-  glob_pktdrv_sndbuff[57] = seq;   /* seq number */
-  glob_pktdrv_sndbuff[58] = drive;
-  glob_pktdrv_sndbuff[59] = query; /* AL value (query) */
-  /* I do not copy anything more into glob_pktdrv_sndbuff - the caller is
-   * expected to have already copied all relevant data into glob_pktdrv_sndbuff+60
-   * copybytes((unsigned char far *)glob_pktdrv_sndbuff + 60, (unsigned char far *)buff, bufflen);
-   */
-
-  /* send the query frame and wait for an answer for about 100ms. then, resend
-   * the query again and again, up to 5 times. the RTC clock at 0x46C is used
-   * as a timing reference. */
-  glob_pktdrv_recvbufflen = 0; /* mark the receiving buffer empty */
-  for (count = 5; count != 0; count--) { /* faster than count=0; count<5; count++ */
-    /* send the query frame out */
-    _asm {
-      /* save registers */
-      push ax
-      push cx
-      push dx /* may be changed by the packet driver (set to errno) */
-      push si
-      pushf /* must be last register pushed (expected by 'call') */
-      /* */
-      mov ah, 4h   /* SendPkt */
-      mov cx, bufflen
-      add cx, 60   /* I send 60 bytes more than what bufflen indicates */
-      mov si, offset glob_pktdrv_sndbuff /* DS:SI points to buff, I do not
-                                 modify DS because the buffer should already
-                                 be in my data segment (small memory model) */
-      /* int to variable vector is a mess, so I have fetched its vector myself
-       * and pushf + cli + call far it now to simulate a regular int */
-      /* pushf -- already on the stack */
-      cli
-      call dword ptr glob_pktdrv_pktcall
-      /* restore registers (but not pushf, already restored by call) */
-      pop si
-      pop dx
-      pop cx
-      pop ax
-    }
-
-    /* wait for (and validate) the answer frame */
-    t = *rtc;
-    for (;;) {
-      int i;
-      if ((t != *rtc) && (t+1 != *rtc) && (*rtc != 0)) break; /* timeout, retry */
-      if (glob_pktdrv_recvbufflen < 1) continue;
-      /* I've got something! */
-      /* is the frame long enough for me to care? */
-      if (glob_pktdrv_recvbufflen < 60) goto ignoreframe;
-      /* is it for me? (correct src mac & dst mac) */
-      for (i = 0; i < 6; i++) {
-        if (glob_pktdrv_recvbuff[i] != GLOB_LMAC[i]) goto ignoreframe;
-        if ((updatermac == 0) && (glob_pktdrv_recvbuff[i+6] != GLOB_RMAC[i])) goto ignoreframe;
-      }
-      /* is the ethertype and seq what I expect? */
-      if ((((unsigned short *)glob_pktdrv_recvbuff)[6] != 0xF5EDu) || (glob_pktdrv_recvbuff[57] != seq)) goto ignoreframe;
-      /* return buffer (without headers and seq) */
-      *replyptr = glob_pktdrv_recvbuff + 60;
-      *replyax = (unsigned short *)(glob_pktdrv_recvbuff + 58);
-      /* update glob_rmac if needed, then return */
-      if (updatermac != 0) copybytes(GLOB_RMAC, glob_pktdrv_recvbuff + 6, 6);
-      return(glob_pktdrv_recvbufflen - 60);
-      ignoreframe: /* ignore this frame and wait for the next one */
-      glob_pktdrv_recvbufflen = 0; /* mark the buffer empty */
-    }
-  }
-  return(0xFFFFu); /* return error */
-}
-
-
-/* reset CF (set on error only) and AX (expected to contain the error code,
- * I might set it later) - I assume a success */
-#define SUCCESSFLAG glob_intregs.w.ax = 0; glob_intregs.w.flags &= ~(INTR_CF);
-#define FAILFLAG(x) {glob_intregs.w.ax = x; glob_intregs.w.flags |= INTR_CF;}
-
-/* this function contains the logic behind INT 2F processing */
-void process2f(void) {
-#if DEBUGLEVEL > 0
-  char far *dbg_msg = NULL;
-#endif
-  short i;
-  unsigned char *answer;
-  unsigned char *buff; /* pointer to the "query arguments" part of glob_pktdrv_sndbuff */
-  unsigned char subfunction;
-  unsigned short *ax; /* used to collect the resulting value of AX */
-  buff = glob_pktdrv_sndbuff + 60;
-
-  /* DEBUG output (RED) */
-#if DEBUGLEVEL > 0
-  dbg_xpos &= 511;
-  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x4e00 | ' ';
-  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x4e00 | (dbg_hexc[(glob_intregs.h.al >> 4) & 0xf]);
-  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x4e00 | (dbg_hexc[glob_intregs.h.al & 0xf]);
-  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x4e00 | ' ';
-#endif
-
-  /* remember the AL register (0x2F subfunction id) */
-  subfunction = glob_intregs.h.al;
-
-  /* if we got here, then the call is definitely for us. set AX and CF to */
-  /* 'success' (being a natural optimist I assume success) */
-  SUCCESSFLAG;
-
-  /* look what function is called exactly and process it */
-  switch (subfunction) {
-    case AL_RMDIR: /*** 01h: RMDIR ******************************************/
-      /* RMDIR is like MKDIR, but I need to check if dir is not current first */
-      for (i = 0; glob_sdaptr->fn1[i] != 0; i++) {
-        if (glob_sdaptr->fn1[i] != glob_sdaptr->drive_cdsptr[i]) goto proceedasmkdir;
-      }
-      FAILFLAG(16); /* err 16 = "attempted to remove current directory" */
-      break;
-      proceedasmkdir:
-    case AL_MKDIR: /*** 03h: MKDIR ******************************************/
-      i = mystrlen(glob_sdaptr->fn1);
-      /* fn1 must be at least 2 bytes long */
-      if (i < 2) {
-        FAILFLAG(3); /* "path not found" */
-        break;
-      }
-      /* copy fn1 to buff (but skip drive part) */
-      i -= 2;
-      copybytes(buff, glob_sdaptr->fn1 + 2, i);
-      /* send query providing fn1 */
-      if (sendquery(subfunction, glob_reqdrv, i, &answer, &ax, 0) == 0) {
-        glob_intregs.w.ax = *ax;
-        if (*ax != 0) glob_intregs.w.flags |= INTR_CF;
-      } else {
-        FAILFLAG(2);
-      }
-      break;
-    case AL_CHDIR: /*** 05h: CHDIR ******************************************/
-      /* The INT 2Fh/1105h redirector callback is executed by DOS when
-       * changing directories. The Phantom authors (and RBIL contributors)
-       * clearly thought that it was the redirector's job to update the CDS,
-       * but in fact the callback is only meant to validate that the target
-       * directory exists; DOS subsequently updates the CDS. */
-      /* fn1 must be at least 2 bytes long */
-      i = mystrlen(glob_sdaptr->fn1);
-      if (i < 2) {
-        FAILFLAG(3); /* "path not found" */
-        break;
-      }
-      /* copy fn1 to buff (but skip the drive: part) */
-      i -= 2;
-      copybytes(buff, glob_sdaptr->fn1 + 2, i);
-      /* send query providing fn1 */
-      if (sendquery(AL_CHDIR, glob_reqdrv, i, &answer, &ax, 0) == 0) {
-        glob_intregs.w.ax = *ax;
-        if (*ax != 0) glob_intregs.w.flags |= INTR_CF;
-      } else {
-        FAILFLAG(3); /* "path not found" */
-      }
-      break;
-    case AL_CLSFIL: /*** 06h: CLSFIL ****************************************/
-      /* my only job is to decrement the SFT's handle count (which I didn't
-       * have to increment during OPENFILE since DOS does it... talk about
-       * consistency. I also inform the server about this, just so it knows */
-      /* ES:DI points to the SFT */
-      {
-      struct sftstruct far *sftptr = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
-      if (sftptr->handle_count > 0) sftptr->handle_count--;
-      ((unsigned short *)buff)[0] = sftptr->start_sector;
-      if (sendquery(AL_CLSFIL, glob_reqdrv, 2, &answer, &ax, 0) == 0) {
-        if (*ax != 0) FAILFLAG(*ax);
-      }
-      }
-      break;
-    case AL_CMMTFIL: /*** 07h: CMMTFIL **************************************/
-      /* I have nothing to do here */
-      break;
-    case AL_READFIL: /*** 08h: READFIL **************************************/
-      { /* ES:DI points to the SFT (whose file_pos needs to be updated) */
-        /* CX = number of bytes to read (to be updated with number of bytes actually read) */
-        /* SDA DTA = read buffer */
-      struct sftstruct far *sftptr = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
-      unsigned short totreadlen;
-      /* is the file open for write-only? */
-      if (sftptr->open_mode & 1) {
-        FAILFLAG(5); /* "access denied" */
-        break;
-      }
-      /* return immediately if the caller wants to read 0 bytes */
-      if (glob_intregs.x.cx == 0) break;
-      /* do multiple read operations so chunks can fit in my eth frames */
-      totreadlen = 0;
-      for (;;) {
-        int chunklen, len;
-        if ((glob_intregs.x.cx - totreadlen) < (FRAMESIZE - 60)) {
-          chunklen = glob_intregs.x.cx - totreadlen;
-        } else {
-          chunklen = FRAMESIZE - 60;
-        }
-        /* query is OOOOSSLL (offset, start sector, lenght to read) */
-        ((unsigned long *)buff)[0] = sftptr->file_pos + totreadlen;
-        ((unsigned short *)buff)[2] = sftptr->start_sector;
-        ((unsigned short *)buff)[3] = chunklen;
-        len = sendquery(AL_READFIL, glob_reqdrv, 8, &answer, &ax, 0);
-        if (len == 0xFFFFu) { /* network error */
-          FAILFLAG(2);
-          break;
-        } else if (*ax != 0) { /* backend error */
-          FAILFLAG(*ax);
-          break;
-        } else { /* success */
-          copybytes(glob_sdaptr->curr_dta + totreadlen, answer, len);
-          totreadlen += len;
-          if ((len < chunklen) || (totreadlen == glob_intregs.x.cx)) { /* EOF - update SFT and break out */
-            sftptr->file_pos += totreadlen;
-            glob_intregs.x.cx = totreadlen;
-            break;
-          }
-        }
-      }
-      }
-      break;
-    case AL_WRITEFIL: /*** 09h: WRITEFIL ************************************/
-      { /* ES:DI points to the SFT (whose file_pos needs to be updated) */
-        /* CX = number of bytes to write (to be updated with number of bytes actually written) */
-        /* SDA DTA = read buffer */
-      struct sftstruct far *sftptr = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
-      unsigned short bytesleft, chunklen, written = 0;
-      /* is the file open for read-only? */
-      if ((sftptr->open_mode & 3) == 0) {
-        FAILFLAG(5); /* "access denied" */
-        break;
-      }
-      /* TODO FIXME I should update the file's time in the SFT here */
-      /* do multiple write operations so chunks can fit in my eth frames */
-      bytesleft = glob_intregs.x.cx;
-
-      while (bytesleft > 0) {
-        unsigned short len;
-        chunklen = bytesleft;
-        if (chunklen > FRAMESIZE - 66) chunklen = FRAMESIZE - 66;
-        /* query is OOOOSS (file offset, start sector/fileid) */
-        ((unsigned long *)buff)[0] = sftptr->file_pos;
-        ((unsigned short *)buff)[2] = sftptr->start_sector;
-        copybytes(buff + 6, glob_sdaptr->curr_dta + written, chunklen);
-        len = sendquery(AL_WRITEFIL, glob_reqdrv, chunklen + 6, &answer, &ax, 0);
-        if (len == 0xFFFFu) { /* network error */
-          FAILFLAG(2);
-          break;
-        } else if ((*ax != 0) || (len != 2)) { /* backend error */
-          FAILFLAG(*ax);
-          break;
-        } else { /* success - write amount of bytes written into CX and update SFT */
-          len = ((unsigned short *)answer)[0];
-          written += len;
-          bytesleft -= len;
-          glob_intregs.x.cx = written;
-          sftptr->file_pos += len;
-          if (sftptr->file_pos > sftptr->file_size) sftptr->file_size = sftptr->file_pos;
-          if (len != chunklen) break; /* something bad happened on the other side */
-        }
-      }
-
-      }
-      break;
-    case AL_LOCKFIL: /*** 0Ah: LOCKFIL **************************************/
-      /* TODO */
-      FAILFLAG(2);
-      break;
-    case AL_UNLOCKFIL: /*** 0Bh: UNLOCKFIL **********************************/
-      /* TODO */
-      FAILFLAG(2);
-      break;
-    case AL_DISKSPACE: /*** 0Ch: get disk information ***********************/
-      if (sendquery(AL_DISKSPACE, glob_reqdrv, 0, &answer, &ax, 0) == 6) {
-        glob_intregs.w.ax = *ax; /* sectors per cluster */
-        glob_intregs.w.bx = ((unsigned short *)answer)[0]; /* total clusters */
-        glob_intregs.w.cx = ((unsigned short *)answer)[1]; /* bytes per sector */
-        glob_intregs.w.dx = ((unsigned short *)answer)[2]; /* num of available clusters */
-      } else {
-        FAILFLAG(2);
-      }
-      break;
-    case AL_SETATTR: /*** 0Eh: SETATTR **************************************/
-      /* sdaptr->fn1 -> file to set attributes for
-         stack word -> new attributes (stack must not be changed!) */
-      /* fn1 must be at least 2 characters long */
-      i = mystrlen(glob_sdaptr->fn1);
-      if (i < 2) {
-        FAILFLAG(2);
-        break;
-      }
-      /* */
-      buff[0] = glob_reqstkword;
-      /* copy fn1 to buff (but without the drive part) */
-      copybytes(buff + 1, glob_sdaptr->fn1 + 2, i - 2);
-    #if DEBUGLEVEL > 0
-      dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x1000 | dbg_hexc[(glob_reqstkword >> 4) & 15];
-      dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x1000 | dbg_hexc[glob_reqstkword & 15];
-    #endif
-      i = sendquery(AL_SETATTR, glob_reqdrv, i - 1, &answer, &ax, 0);
-      if (i != 0) {
-        FAILFLAG(2);
-      } else if (*ax != 0) {
-        FAILFLAG(*ax);
-      }
-      break;
-    case AL_GETATTR: /*** 0Fh: GETATTR **************************************/
-      i = mystrlen(glob_sdaptr->fn1);
-      if (i < 2) {
-        FAILFLAG(2);
-        break;
-      }
-      i -= 2;
-      copybytes(buff, glob_sdaptr->fn1 + 2, i);
-      i = sendquery(AL_GETATTR, glob_reqdrv, i, &answer, &ax, 0);
-      if ((unsigned short)i == 0xffffu) {
-        FAILFLAG(2);
-      } else if ((i != 9) || (*ax != 0)) {
-        FAILFLAG(*ax);
-      } else { /* all good */
-        /* CX = timestamp
-         * DX = datestamp
-         * BX:DI = fsize
-         * AX = attr
-         * NOTE: Undocumented DOS talks only about setting AX, no fsize, time
-         *       and date, these are documented in RBIL and used by SHSUCDX */
-        glob_intregs.w.cx = ((unsigned short *)answer)[0]; /* time */
-        glob_intregs.w.dx = ((unsigned short *)answer)[1]; /* date */
-        glob_intregs.w.bx = ((unsigned short *)answer)[3]; /* fsize hi word */
-        glob_intregs.w.di = ((unsigned short *)answer)[2]; /* fsize lo word */
-        glob_intregs.w.ax = answer[8];                     /* file attribs */
-      }
-      break;
-    case AL_RENAME: /*** 11h: RENAME ****************************************/
-      /* sdaptr->fn1 = old name
-       * sdaptr->fn2 = new name */
-      /* is the operation for the SAME drive? */
-      if (glob_sdaptr->fn1[0] != glob_sdaptr->fn2[0]) {
-        FAILFLAG(2);
-        break;
-      }
-      /* prepare the query (LSSS...DDD...) */
-      i = mystrlen(glob_sdaptr->fn1);
-      if (i < 2) {
-        FAILFLAG(2);
-        break;
-      }
-      i -= 2; /* trim out the drive: part (C:\FILE --> \FILE) */
-      buff[0] = i;
-      copybytes(buff + 1, glob_sdaptr->fn1 + 2, i);
-      i = len_if_no_wildcards(glob_sdaptr->fn2);
-      if (i < 2) {
-        FAILFLAG(3);
-        break;
-      }
-      i -= 2; /* trim out the drive: part (C:\FILE --> \FILE) */
-      copybytes(buff + 1 + buff[0], glob_sdaptr->fn2 + 2, i);
-      /* send the query out */
-      i = sendquery(AL_RENAME, glob_reqdrv, 1 + buff[0] + i, &answer, &ax, 0);
-      if (i != 0) {
-        FAILFLAG(2);
-      } else if (*ax != 0) {
-        FAILFLAG(*ax);
-      }
-      break;
-    case AL_DELETE: /*** 13h: DELETE ****************************************/
-    #if DEBUGLEVEL > 0
-      dbg_msg = glob_sdaptr->fn1;
-    #endif
-      /* compute length of fn1 and copy it to buff (w/o the 'drive:' part) */
-      i = mystrlen(glob_sdaptr->fn1);
-      if (i < 2) {
-        FAILFLAG(2);
-        break;
-      }
-      i -= 2;
-      copybytes(buff, glob_sdaptr->fn1 + 2, i);
-      /* send query */
-      i = sendquery(AL_DELETE, glob_reqdrv, i, &answer, &ax, 0);
-      if ((unsigned short)i == 0xffffu) {
-        FAILFLAG(2);
-      } else if ((i != 0) || (*ax != 0)) {
-        FAILFLAG(*ax);
-      }
-      break;
-    case AL_OPEN: /*** 16h: OPEN ********************************************/
-    case AL_CREATE: /*** 17h: CREATE ****************************************/
-    case AL_SPOPNFIL: /*** 2Eh: SPOPNFIL ************************************/
-    #if DEBUGLEVEL > 0
-      dbg_msg = glob_sdaptr->fn1;
-    #endif
-      /* fail if fn1 contains any wildcard, otherwise get len of fn1 */
-      i = len_if_no_wildcards(glob_sdaptr->fn1);
-      if (i < 2) {
-        FAILFLAG(3);
-        break;
-      }
-      i -= 2;
-      /* prepare and send query (SSCCMMfff...) */
-      ((unsigned short *)buff)[0] = glob_reqstkword; /* WORD from the stack */
-      ((unsigned short *)buff)[1] = glob_sdaptr->spop_act; /* action code (SPOP only) */
-      ((unsigned short *)buff)[2] = glob_sdaptr->spop_mode; /* open mode (SPOP only) */
-      copybytes(buff + 6, glob_sdaptr->fn1 + 2, i);
-      i = sendquery(subfunction, glob_reqdrv, i + 6, &answer, &ax, 0);
-      if ((unsigned short)i == 0xffffu) {
-        FAILFLAG(2);
-      } else if ((i != 25) || (*ax != 0)) {
-        FAILFLAG(*ax);
-      } else {
-        /* ES:DI contains an uninitialized SFT */
-        struct sftstruct far *sftptr = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
-        /* special treatment for SPOP, (set open_mode and return CX, too) */
-        if (subfunction == AL_SPOPNFIL) {
-          glob_intregs.w.cx = ((unsigned short *)answer)[11];
-        }
-        if (sftptr->open_mode & 0x8000) { /* if bit 15 is set, then it's a "FCB open", and requires the internal DOS "Set FCB Owner" function to be called */
-          /* TODO FIXME set_sft_owner() */
-        #if DEBUGLEVEL > 0
-          dbg_VGA[25*80] = 0x1700 | '$';
-        #endif
-        }
-        sftptr->file_attr = answer[0];
-        sftptr->dev_info_word = 0x8040 | glob_reqdrv; /* mark device as network drive */
-        sftptr->dev_drvr_ptr = NULL;
-        sftptr->start_sector = ((unsigned short *)answer)[10];
-        sftptr->file_time = ((unsigned long *)answer)[3];
-        sftptr->file_size = ((unsigned long *)answer)[4];
-        sftptr->file_pos = 0;
-        sftptr->open_mode &= 0xff00u;
-        sftptr->open_mode |= answer[24];
-        sftptr->rel_sector = 0xffff;
-        sftptr->abs_sector = 0xffff;
-        sftptr->dir_sector = 0;
-        sftptr->dir_entry_no = 0xff; /* why such value? no idea, PHANTOM.C uses that, too */
-        copybytes(sftptr->file_name, answer + 1, 11);
-      }
-      break;
-    case AL_FINDFIRST: /*** 1Bh: FINDFIRST **********************************/
-    case AL_FINDNEXT:  /*** 1Ch: FINDNEXT ***********************************/
-      {
-      /* AX = 111Bh
-      SS = DS = DOS DS
-      [DTA] = uninitialized 21-byte findfirst search data
-      (see #01626 at INT 21/AH=4Eh)
-      SDA first filename pointer (FN1, 9Eh) -> fully-qualified search template
-      SDA CDS pointer -> current directory structure for drive with file
-      SDA search attribute = attribute mask for search
-
-      Return:
-      CF set on error
-      AX = DOS error code (see #01680 at INT 21/AH=59h/BX=0000h)
-           -> http://www.ctyme.com/intr/rb-3012.htm
-      CF clear if successful
-      [DTA] = updated findfirst search data
-      (bit 7 of first byte must be set)
-      [DTA+15h] = standard directory entry for file (see #01352)
-
-      FindNext is the same, but only DTA should be used to fetch search params
-      */
-      struct sdbstruct far *dta;
-
-#if DEBUGLEVEL > 0
-      dbg_msg = glob_sdaptr->fn1;
-#endif
-      /* prepare the query buffer (i must provide query's length) */
-      if (subfunction == AL_FINDFIRST) {
-        dta = (struct sdbstruct far *)(glob_sdaptr->curr_dta);
-        /* FindFirst needs to fetch search arguments from SDA */
-        buff[0] = glob_sdaptr->srch_attr; /* file attributes to look for */
-        /* copy fn1 (w/o drive) to buff */
-        for (i = 2; glob_sdaptr->fn1[i] != 0; i++) buff[i-1] = glob_sdaptr->fn1[i];
-        i--; /* adjust i because its one too much otherwise */
-      } else { /* FindNext needs to fetch search arguments from DTA (es:di) */
-        dta = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
-        ((unsigned short *)buff)[0] = dta->par_clstr;
-        ((unsigned short *)buff)[1] = dta->dir_entry;
-        buff[4] = dta->srch_attr;
-        /* copy search template to buff */
-        for (i = 0; i < 11; i++) buff[i+5] = dta->srch_tmpl[i];
-        i += 5; /* i must provide the exact query's length */
-      }
-      /* send query to remote peer and wait for answer */
-      i = sendquery(subfunction, glob_reqdrv, i, &answer, &ax, 0);
-      if (i == 0xffffu) {
-        if (subfunction == AL_FINDFIRST) {
-          FAILFLAG(2); /* a failed findfirst returns error 2 (file not found) */
-        } else {
-          FAILFLAG(18); /* a failed findnext returns error 18 (no more files) */
-        }
-        break;
-      } else if ((*ax != 0) || (i != 24)) {
-        FAILFLAG(*ax);
-        break;
-      }
-      /* fill in the directory entry 'found_file' (32 bytes)
-       * 00h unsigned char fname[11]
-       * 0Bh unsigned char fattr (1=RO 2=HID 4=SYS 8=VOL 16=DIR 32=ARCH 64=DEV)
-       * 0Ch unsigned char f1[10]
-       * 16h unsigned short time_lstupd
-       * 18h unsigned short date_lstupd
-       * 1Ah unsigned short start_clstr  *optional*
-       * 1Ch unsigned long fsize
-       */
-      copybytes(glob_sdaptr->found_file.fname, answer+1, 11); /* found file name */
-      glob_sdaptr->found_file.fattr = answer[0]; /* found file attributes */
-      glob_sdaptr->found_file.time_lstupd = ((unsigned short *)answer)[6]; /* time (word) */
-      glob_sdaptr->found_file.date_lstupd = ((unsigned short *)answer)[7]; /* date (word) */
-      glob_sdaptr->found_file.start_clstr = 0; /* start cluster (I don't care) */
-      glob_sdaptr->found_file.fsize = ((unsigned long *)answer)[4]; /* fsize (word) */
-
-      /* put things into DTA so I can understand where I left should FindNext
-       * be called - this shall be a valid FindFirst structure (21 bytes):
-       * 00h unsigned char drive letter (7bits, MSB must be set for remote drives)
-       * 01h unsigned char search_tmpl[11]
-       * 0Ch unsigned char search_attr (1=RO 2=HID 4=SYS 8=VOL 16=DIR 32=ARCH 64=DEV)
-       * 0Dh unsigned short entry_count_within_directory
-       * 0Fh unsigned short cluster number of start of parent directory
-       * 11h unsigned char reserved[4]
-       * -- RBIL says: [DTA+15h] = standard directory entry for file
-       * 15h 11-bytes (FCB-style) filename+ext ("FILE0000TXT")
-       * 20h unsigned char attr. of file found (1=RO 2=HID 4=SYS 8=VOL 16=DIR 32=ARCH 64=DEV)
-       * 21h 10-bytes reserved
-       * 2Bh unsigned short file time
-       * 2Dh unsigned short file date
-       * 2Fh unsigned short cluster
-       * 31h unsigned long file size
-       */
-      /* init some stuff only on FindFirst (FindNext contains valid values already) */
-      if (subfunction == AL_FINDFIRST) {
-        dta->drv_lett = glob_reqdrv | 128; /* bit 7 set means 'network drive' */
-        copybytes(dta->srch_tmpl, glob_sdaptr->fcb_fn1, 11);
-        dta->srch_attr = glob_sdaptr->srch_attr;
-      }
-      dta->par_clstr = ((unsigned short *)answer)[10];
-      dta->dir_entry = ((unsigned short *)answer)[11];
-      /* then 32 bytes as in the found_file record */
-      copybytes(dta + 0x15, &(glob_sdaptr->found_file), 32);
-      }
-      break;
-    case AL_SKFMEND: /*** 21h: SKFMEND **************************************/
-    {
-      struct sftstruct far *sftptr = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
-      ((unsigned short *)buff)[0] = glob_intregs.x.dx;
-      ((unsigned short *)buff)[1] = glob_intregs.x.cx;
-      ((unsigned short *)buff)[2] = sftptr->start_sector;
-      /* send query to remote peer and wait for answer */
-      i = sendquery(AL_SKFMEND, glob_reqdrv, 6, &answer, &ax, 0);
-      if (i == 0xffffu) {
-        FAILFLAG(2);
-      } else if ((*ax != 0) || (i != 4)) {
-        FAILFLAG(*ax);
-      } else { /* put new position into DX:AX */
-        glob_intregs.w.ax = ((unsigned short *)answer)[0];
-        glob_intregs.w.dx = ((unsigned short *)answer)[1];
-      }
-      break;
-    }
-    case AL_UNKNOWN_2D: /*** 2Dh: UNKNOWN_2D ********************************/
-      /* this is only called in MS-DOS v4.01, its purpose is unknown. MSCDEX
-       * returns AX=2 there, and so do I. */
-      glob_intregs.w.ax = 2;
-      break;
-  }
-
-  /* DEBUG */
-#if DEBUGLEVEL > 0
-  while ((dbg_msg != NULL) && (*dbg_msg != 0)) dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x4f00 | *(dbg_msg++);
-#endif
-}
-
-/* this function is hooked on INT 2Fh */
-void __interrupt __far inthandler(union INTPACK r) {
-  /* insert a static code signature so I can reliably patch myself later,
-   * this will also contain the DS segment to use and actually set it */
-  _asm {
-    jmp SKIPTSRSIG
-    TSRSIG DB 'M','V','e','t'
-    SKIPTSRSIG:
-    /* save AX */
-    push ax
-    /* switch to new (patched) DS */
-    mov ax, 0
-    mov ds, ax
-    /* save one word from the stack (might be used by SETATTR later)
-     * The original stack should be at SS:BP+30 */
-    mov ax, ss:[BP+30]
-    mov glob_reqstkword, ax
-
-    /* uncomment the debug code below to insert a stack's dump into snd eth
-     * frame - debugging ONLY! */
-    /*
-    mov ax, ss:[BP+20]
-    mov word ptr [glob_pktdrv_sndbuff+16], ax
-    mov ax, ss:[BP+22]
-    mov word ptr [glob_pktdrv_sndbuff+18], ax
-    mov ax, ss:[BP+24]
-    mov word ptr [glob_pktdrv_sndbuff+20], ax
-    mov ax, ss:[BP+26]
-    mov word ptr [glob_pktdrv_sndbuff+22], ax
-    mov ax, ss:[BP+28]
-    mov word ptr [glob_pktdrv_sndbuff+24], ax
-    mov ax, ss:[BP+30]
-    mov word ptr [glob_pktdrv_sndbuff+26], ax
-    mov ax, ss:[BP+32]
-    mov word ptr [glob_pktdrv_sndbuff+28], ax
-    mov ax, ss:[BP+34]
-    mov word ptr [glob_pktdrv_sndbuff+30], ax
-    mov ax, ss:[BP+36]
-    mov word ptr [glob_pktdrv_sndbuff+32], ax
-    mov ax, ss:[BP+38]
-    mov word ptr [glob_pktdrv_sndbuff+34], ax
-    mov ax, ss:[BP+40]
-    mov word ptr [glob_pktdrv_sndbuff+36], ax
-    */
-    /* restore AX */
-    pop ax
-  }
-
-  /* DEBUG output (BLUE) */
-#if DEBUGLEVEL > 1
-  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x1e00 | (dbg_hexc[(r.h.ah >> 4) & 0xf]);
-  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x1e00 | (dbg_hexc[r.h.ah & 0xf]);
-  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x1e00 | (dbg_hexc[(r.h.al >> 4) & 0xf]);
-  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x1e00 | (dbg_hexc[r.h.al & 0xf]);
-  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0;
-#endif
-
-  /* is it a multiplex call for me? */
-  if (r.h.ah == glob_multiplexid) {
-    if (r.h.al == 0) { /* install check */
-      r.h.al = 0xff;    /* 'installed' */
-      r.w.bx = 0x4d86;  /* MV          */
-      r.w.cx = 0x7e1;   /* 2017        */
-      return;
-    }
-    if ((r.h.al == 1) && (r.x.cx == 0x4d86)) { /* get shared data ptr (AX=0, ptr under BX:CX) */
-      _asm {
-        push ds
-        pop glob_reqstkword
-      }
-      r.w.ax = 0; /* zero out AX */
-      r.w.bx = glob_reqstkword; /* ptr returned at BX:CX */
-      r.w.cx = FP_OFF(&glob_data);
-      return;
-    }
-  }
-
-  /* if not related to a redirector function (AH=11h), or the function is
-   * an 'install check' (0), or the function is over our scope (2Eh), or it's
-   * an otherwise unsupported function (as pointed out by supportedfunctions),
-   * then call the previous INT 2F handler immediately */
-  if ((r.h.ah != 0x11) || (r.h.al == AL_INSTALLCHK) || (r.h.al > 0x2E) || (supportedfunctions[r.h.al] == AL_UNKNOWN)) goto CHAINTOPREVHANDLER;
-
-  /* DEBUG output (GREEN) */
-#if DEBUGLEVEL > 0
-  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x2e00 | (dbg_hexc[(r.h.al >> 4) & 0xf]);
-  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x2e00 | (dbg_hexc[r.h.al & 0xf]);
-  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0;
-#endif
-
-  /* determine whether or not the query is meant for a drive I control,
-   * and if not - chain to the previous INT 2F handler */
-  if (((r.h.al >= AL_CLSFIL) && (r.h.al <= AL_UNLOCKFIL)) || (r.h.al == AL_SKFMEND) || (r.h.al == AL_UNKNOWN_2D)) {
-  /* ES:DI points to the SFT: if the bottom 6 bits of the device information
-   * word in the SFT are > last drive, then it relates to files not associated
-   * with drives, such as LAN Manager named pipes. */
-    struct sftstruct far *sft = MK_FP(r.w.es, r.w.di);
-    glob_reqdrv = sft->dev_info_word & 0x3F;
-  } else {
-    switch (r.h.al) {
-      case AL_FINDNEXT:
-        glob_reqdrv = glob_sdaptr->sdb.drv_lett & 0x1F;
-        break;
-      case AL_SETATTR:
-      case AL_GETATTR:
-      case AL_DELETE:
-      case AL_OPEN:
-      case AL_CREATE:
-      case AL_SPOPNFIL:
-      case AL_MKDIR:
-      case AL_RMDIR:
-      case AL_CHDIR:
-      case AL_RENAME: /* check sda.fn1 for drive */
-        glob_reqdrv = DRIVETONUM(glob_sdaptr->fn1[0]);
-        break;
-      default: /* otherwise check out the CDS (at ES:DI) */
-        {
-        struct cdsstruct far *cds = MK_FP(r.w.es, r.w.di);
-        glob_reqdrv = DRIVETONUM(cds->current_path[0]);
-      #if DEBUGLEVEL > 0 /* DEBUG output (ORANGE) */
-        dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x6e00 | ('A' + glob_reqdrv);
-        dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x6e00 | ':';
-      #endif
-        }
-        break;
-    }
-  }
-  /* validate drive */
-  if ((glob_reqdrv > 25) || (glob_data.ldrv[glob_reqdrv] == 0xff)) {
-    goto CHAINTOPREVHANDLER;
-  }
-
-  /* This should not be necessary. DOS usually generates an FCB-style name in
-   * the appropriate SDA area. However, in the case of user input such as
-   * 'CD ..' or 'DIR ..' it leaves the fcb area all spaces, hence the need to
-   * normalize the fcb area every time. */
-  if (r.h.al != AL_DISKSPACE) {
-    unsigned short i;
-    unsigned char far *path = glob_sdaptr->fn1;
-
-    /* fast forward 'path' to first character of the filename */
-    for (i = 0;; i++) {
-      if (glob_sdaptr->fn1[i] == '\\') path = glob_sdaptr->fn1 + i + 1;
-      if (glob_sdaptr->fn1[i] == 0) break;
-    }
-
-    /* clear out fcb_fn1 by filling it with spaces */
-    for (i = 0; i < 11; i++) glob_sdaptr->fcb_fn1[i] = ' ';
-
-    /* copy 'path' into fcb_name using the fcb syntax ("FILE    TXT") */
-    for (i = 0; *path != 0; path++) {
-      if (*path == '.') {
-        i = 8;
-      } else {
-        glob_sdaptr->fcb_fn1[i++] = *path;
-      }
-    }
-  }
-
-  /* copy interrupt registers into glob_intregs so the int handler can access them without using any stack */
-  copybytes(&glob_intregs, &r, sizeof(union INTPACK));
-  /* set stack to my custom memory */
-  _asm {
-    cli /* make sure to disable interrupts, so nobody gets in the way while I'm fiddling with the stack */
-    mov glob_oldstack_seg, SS
-    mov glob_oldstack_off, SP
-    /* set SS to DS */
-    mov ax, ds
-    mov ss, ax
-    /* set SP to the end of my DATASEGSZ (-2) */
-    mov sp, DATASEGSZ
-    dec sp
-    dec sp
-    sti
-  }
-  /* call the actual INT 2F processing function */
-  process2f();
-  /* switch stack back */
-  _asm {
-    cli
-    mov SS, glob_oldstack_seg
-    mov SP, glob_oldstack_off
-    sti
-  }
-  /* copy all registers back so watcom will set them as required 'for real' */
-  copybytes(&r, &glob_intregs, sizeof(union INTPACK));
-  return;
-
-  /* hand control to the previous INT 2F handler */
-  CHAINTOPREVHANDLER:
-  _mvchain_intr(MK_FP(glob_data.prev_2f_handler_seg, glob_data.prev_2f_handler_off));
-}
-
-
-/*********************** HERE ENDS THE RESIDENT PART ***********************/
-
-#pragma code_seg("_TEXT", "CODE");
-
-/* this function obviously does nothing - but I need it because it is a
- * 'low-water' mark for the end of my resident code (so I know how much memory
- * exactly I can trim when going TSR) */
-void begtextend(void) {
-}
-
-/* registers a packet driver handle to use on subsequent calls */
-static int pktdrv_accesstype(void) {
-  unsigned char cflag = 0;
-
-  _asm {
-    mov ax, 201h        /* AH=subfunction access_type(), AL=if_class=1(eth) */
-    mov bx, 0ffffh      /* if_type = 0xffff means 'all' */
-    mov dl, 0           /* if_number: 0 (first interface) */
-    /* DS:SI should point to the ethertype value in network byte order */
-    mov si, offset glob_pktdrv_sndbuff + 12 /* I don't set DS, it's good already */
-    mov cx, 2           /* typelen (ethertype is 16 bits) */
-    /* ES:DI points to the receiving routine */
-    push cs /* write segment of pktdrv_recv into es */
-    pop es
-    mov di, offset pktdrv_recv
-    mov cflag, 1        /* pre-set the cflag variable to failure */
-    /* int to variable vector is a mess, so I have fetched its vector myself
-     * and pushf + cli + call far it now to simulate a regular int */
-    pushf
-    cli
-    call dword ptr glob_pktdrv_pktcall
-    /* get CF state - reset cflag if CF clear, and get pkthandle from AX */
-    jc badluck   /* Jump if Carry */
-    mov word ptr [glob_data + GLOB_DATOFF_PKTHANDLE], ax /* Pkt handle should be in AX */
-    mov cflag, 0
-    badluck:
-  }
-
-  if (cflag != 0) return(-1);
-  return(0);
-}
-
-/* get my own MAC addr. target MUST point to a space of at least 6 chars */
-static void pktdrv_getaddr(unsigned char *dst) {
-  _asm {
-    mov ah, 6                       /* subfunction: get_addr() */
-    mov bx, word ptr [glob_data + GLOB_DATOFF_PKTHANDLE];  /* handle */
-    push ds                         /* write segment of dst into es */
-    pop es
-    mov di, dst                     /* offset of dst (in small mem model dst IS an offset) */
-    mov cx, 6                       /* expected length (ethernet = 6 bytes) */
-    /* int to variable vector is a mess, so I have fetched its vector myself
-     * and pushf + cli + call far it now to simulate a regular int */
-    pushf
-    cli
-    call dword ptr glob_pktdrv_pktcall
-  }
-}
-
-
-static int pktdrv_init(unsigned short pktintparam) {
-  unsigned short far *intvect = (unsigned short far *)MK_FP(0, pktintparam << 2);
-  unsigned short pktdrvfuncoffs = *intvect;
-  unsigned short pktdrvfuncseg = *(intvect+1);
-  unsigned short rseg = 0, roff = 0;
-  char far *pktdrvfunc = (char far *)MK_FP(pktdrvfuncseg, pktdrvfuncoffs);
-  int i;
-  char sig[8];
-  /* preload sig with "PKT DRVR" -- I could it just as well with
-   * char sig[] = "PKT DRVR", but I want to avoid this landing in
-   * my DATA segment so it doesn't pollute the TSR memory space. */
-  sig[0] = 'P';
-  sig[1] = 'K';
-  sig[2] = 'T';
-  sig[3] = ' ';
-  sig[4] = 'D';
-  sig[5] = 'R';
-  sig[6] = 'V';
-  sig[7] = 'R';
-
-  /* set my ethertype to 0xF5ED (EDF5 in network byte order) */
-  glob_pktdrv_sndbuff[12] = 0xED;
-  glob_pktdrv_sndbuff[13] = 0xF5;
-  /* set the protover field in send buffer (I won't touch it again) */
-  glob_pktdrv_sndbuff[56] = PROTOVER; /* protocol version */
-
-  pktdrvfunc += 3; /* skip three bytes of executable code */
-  for (i = 0; i < 8; i++) if (sig[i] != pktdrvfunc[i]) return(-1);
-
-  glob_data.pktint = pktintparam;
-
-  /* fetch the vector of the pktdrv interrupt and save it for later */
-  _asm {
-    mov ah, 35h /* AH=GetVect */
-    mov al, byte ptr [glob_data] + GLOB_DATOFF_PKTINT; /* AL=int number */
-    push es /* save ES and BX (will be overwritten) */
-    push bx
-    int 21h
-    mov rseg, es
-    mov roff, bx
-    pop bx
-    pop es
-  }
-  glob_pktdrv_pktcall = rseg;
-  glob_pktdrv_pktcall <<= 16;
-  glob_pktdrv_pktcall |= roff;
-
-  return(pktdrv_accesstype());
-}
-
-
-static void pktdrv_free(unsigned long pktcall) {
-  _asm {
-    mov ah, 3
-    mov bx, word ptr [glob_data + GLOB_DATOFF_PKTHANDLE]
-    /* int to variable vector is a mess, so I have fetched its vector myself
-     * and pushf + cli + call far it now to simulate a regular int */
-    pushf
-    cli
-    call dword ptr glob_pktdrv_pktcall
-  }
-  /* if (regs.x.cflag != 0) return(-1);
-  return(0);*/
-}
-
-static struct sdastruct far *getsda(void) {
-  /* DOS 3.0+ - GET ADDRESS OF SDA (Swappable Data Area)
-   * AX = 5D06h
-   *
-   * CF set on error (AX=error code)
-   * DS:SI -> sda pointer
-   */
-  unsigned short rds = 0, rsi = 0;
-  _asm {
-    mov ax, 5d06h
-    push ds
-    push si
-    int 21h
-    mov bx, ds
-    mov cx, si
-    pop si
-    pop ds
-    mov rds, bx
-    mov rsi, cx
-  }
-  return(MK_FP(rds, rsi));
-}
-
-/* returns the CDS struct for drive. requires DOS 4+ */
-static struct cdsstruct far *getcds(unsigned int drive) {
-  /* static to preserve state: only do init once */
-  static unsigned char far *dir;
-  static int ok = -1;
-  static unsigned char lastdrv;
-  /* init of never inited yet */
-  if (ok == -1) {
-    /* DOS 3.x+ required - no CDS in earlier versions */
-    ok = 1;
-    /* offsets of CDS and lastdrv in the List of Lists depends on the DOS version:
-     * DOS < 3   no CDS at all
-     * DOS 3.0   lastdrv at 1Bh, CDS pointer at 17h
-     * DOS 3.1+  lastdrv at 21h, CDS pointer at 16h */
-    /* fetch lastdrv and CDS through a little bit of inline assembly */
-    _asm {
-      push si /* SI needs to be preserved */
-      /* get the List of Lists into ES:BX */
-      mov ah, 52h
-      int 21h
-      /* get the LASTDRIVE value */
-      mov si, 21h /* 21h for DOS 3.1+, 1Bh on DOS 3.0 */
-      mov ah, byte ptr es:[bx+si]
-      mov lastdrv, ah
-      /* get the CDS */
-      mov si, 16h /* 16h for DOS 3.1+, 17h on DOS 3.0 */
-      les bx, es:[bx+si]
-      mov word ptr dir+2, es
-      mov word ptr dir, bx
-      /* restore the original SI value*/
-      pop si
-    }
-    /* some OSes (at least OS/2) set the CDS pointer to FFFF:FFFF */
-    if (dir == (unsigned char far *) -1l) ok = 0;
-  } /* end of static initialization */
-  if (ok == 0) return(NULL);
-  if (drive > lastdrv) return(NULL);
-  /* return the CDS array entry for drive - note that currdir_size depends on
-   * DOS version: 0x51 on DOS 3.x, and 0x58 on DOS 4+ */
-  return((struct cdsstruct __far *)((unsigned char __far *)dir + (drive * 0x58 /*currdir_size*/)));
-}
-/******* end of CDS-related stuff *******/
-
-/* primitive BIOS-based message output used instead of printf() to limit
- * memory usage and binary size */
-static void outmsg(char *s) {
-  _asm {
-    mov ah, 9h  /* DOS 1+ - WRITE STRING TO STANDARD OUTPUT */
-    mov dx, s   /* small memory model: no need to set DS, 's' is an offset */
-    int 21h
-  }
-}
-
-/* zero out an object of l bytes */
-static void zerobytes(void *obj, unsigned short l) {
-  unsigned char *o = obj;
-  while (l-- != 0) {
-    *o = 0;
-    o++;
-  }
-}
-
-/* expects a hex string of exactly two chars "XX" and returns its value, or -1
- * if invalid */
-static int hexpair2int(char *hx) {
-  unsigned char h[2];
-  unsigned short i;
-  /* translate hx[] to numeric values and validate */
-  for (i = 0; i < 2; i++) {
-    if ((hx[i] >= 'A') && (hx[i] <= 'F')) {
-      h[i] = hx[i] - ('A' - 10);
-    } else if ((hx[i] >= 'a') && (hx[i] <= 'f')) {
-      h[i] = hx[i] - ('a' - 10);
-    } else if ((hx[i] >= '0') && (hx[i] <= '9')) {
-      h[i] = hx[i] - '0';
-    } else { /* invalid */
-      return(-1);
-    }
-  }
-  /* compute the end result and return it */
-  i = h[0];
-  i <<= 4;
-  i |= h[1];
-  return(i);
-}
-
-/* translates an ASCII MAC address into a 6-bytes binary string */
-static int string2mac(unsigned char *d, char *mac) {
-  int i, v;
-  /* is it exactly 17 chars long? */
-  for (i = 0; mac[i] != 0; i++);
-  if (i != 17) return(-1);
-  /* are nibble pairs separated by colons? */
-  for (i = 2; i < 16; i += 3) if (mac[i] != ':') return(-1);
-  /* translate each byte to its numeric value */
-  for (i = 0; i < 16; i += 3) {
-    v = hexpair2int(mac + i);
-    if (v < 0) return(-1);
-    *d = v;
-    d++;
-  }
-  return(0);
-}
-
-
-#define ARGFL_QUIET 1
-#define ARGFL_AUTO 2
-#define ARGFL_UNLOAD 4
-
-/* a structure used to pass and decode arguments between main() and parseargv() */
-struct argstruct {
-  int argc;    /* original argc */
-  char **argv; /* original argv */
-  unsigned short pktint; /* custom packet driver interrupt */
-  unsigned char flags; /* ARGFL_QUIET, ARGFL_AUTO */
-};
-
-
-/* parses (and applies) command-line arguments. returns 0 on success,
- * non-zero otherwise */
-static int parseargv(struct argstruct *args) {
-  /* Syntax: etherdfs SRVMAC rdrive:ldrive [options] */
-  int i, drivemapflag = 0;
-  /* if only one argument given, it must be /u */
-  if (args->argc == 2) {
-    /* must be two characters long, and start with a '/' */
-    if ((args->argv[1][0] != '/') || (args->argv[1][1] == 0)  || (args->argv[1][2] != 0)) return(-1);
-    /* is it /u ? */
-    if ((args->argv[1][1] == 'u') || (args->argv[1][1] == 'U')) {
-      args->flags = ARGFL_UNLOAD;
-      return(0);
-    }
-    /* otherwise I don't care */
-    return(-1);
-  }
-
-  /* I require at least 2 arguments */
-  if (args->argc < 3) return(-1);
-  /* read the srv mac address, unless it's "::" (auto) */
-  if ((args->argv[1][0] == ':') && (args->argv[1][1] == ':') && (args->argv[1][2] == 0)) {
-    args->flags |= ARGFL_AUTO;
-  } else {
-    if (string2mac(GLOB_RMAC, args->argv[1]) != 0) return(-1);
-  }
-
-  /* iterate through options, if any */
-  for (i = 2; i < args->argc; i++) {
-    char opt;
-    char *arg;
-    /* is it a drive mapping, like "c-x"? */
-    if ((args->argv[i][0] >= 'A') && (args->argv[i][1] == '-') && (args->argv[i][2] >= 'A') && (args->argv[i][3] == 0)) {
-      unsigned char ldrv, rdrv;
-      rdrv = DRIVETONUM(args->argv[i][0]);
-      ldrv = DRIVETONUM(args->argv[i][2]);
-      if ((ldrv > 25) || (rdrv > 25)) return(-2);
-      if (glob_data.ldrv[ldrv] != 0xff) return(-2);
-      glob_data.ldrv[ldrv] = rdrv;
-      drivemapflag = 1;
-      continue;
-    }
-    /* not a drive mapping -> check for options */
-    if ((args->argv[i][0] != '/') || (args->argv[i][1] == 0)) return(-3);
-    opt = args->argv[i][1];
-    /* fetch option's argument, if any */
-    if (args->argv[i][2] == 0) { /* single option */
-      arg = NULL;
-    } else if (args->argv[i][2] == '=') { /* trailing argument */
-      arg = args->argv[i] + 3;
-    } else {
-      return(-3);
-    }
-    /* normalize the option char to lower case */
-    if ((opt >= 'A') && (opt <= 'Z')) opt += ('a' - 'A');
-    /* what is the option about? */
-    switch (opt) {
-      case 'q':
-        if (arg != NULL) return(-4);
-        args->flags |= ARGFL_QUIET;
-        break;
-      case 'p':
-        if (arg == NULL) return(-4);
-        /* I expect an exactly 2-characters string */
-        if ((arg[0] == 0) || (arg[1] == 0) || (arg[2] != 0)) return(-1);
-        if ((args->pktint = hexpair2int(arg)) < 1) return(-4);
-        break;
-      default: /* invalid parameter */
-        return(-5);
-    }
-  }
-  /* did I get at least one drive mapping? */
-  if (drivemapflag == 0) return(-6);
-  return(0);
-}
-
-/* translates an unsigned byte into a 2-characters string containing its hex
- * representation. s needs to be at least 3 bytes long. */
-static void byte2hex(char *s, unsigned char b) {
-  char h[16];
-  unsigned short i;
-  /* pre-compute h[] with a string 0..F -- I could do the same thing easily
-   * with h[] = "0123456789ABCDEF", but then this would land inside the DATA
-   * segment, while I want to keep it in stack to avoid polluting the TSR's
-   * memory space */
-  for (i = 0; i < 10; i++) h[i] = '0' + i;
-  for (; i < 16; i++) h[i] = ('A' - 10) + i;
-  /* */
-  s[0] = h[b >> 4];
-  s[1] = h[b & 15];
-  s[2] = 0;
-}
-
-/* allocates sz bytes of memory and returns the segment to allocated memory or
- * 0 on error. the allocation strategy is 'highest possible' (last fit) to
- * avoid memory fragmentation */
-static unsigned short allocseg(unsigned short sz) {
-  unsigned short volatile res = 0;
-  /* sz should contains number of 16-byte paragraphs instead of bytes */
-  sz += 15; /* make sure to allocate enough paragraphs */
-  sz >>= 4;
-  /* ask DOS for memory */
-  _asm {
-    push cx /* save cx */
-    /* set strategy to 'last fit' */
-    mov ah, 58h
-    xor al, al  /* al = 0 means 'get strategy' */
-    int 21h     /* now current strategy is in ax */
-    mov cx, ax  /* copy current strategy to cx */
-    mov ah, 58h
-    mov al, 1   /* al = 1 means 'set strategy' */
-    mov bl, 2   /* 2 or greater means 'last fit' */
-    int 21h
-    /* do the allocation now */
-    mov ah, 48h     /* alloc memory (DOS 2+) */
-    mov bx, sz      /* number of paragraphs to allocate */
-    mov res, 0      /* pre-set res to failure (0) */
-    int 21h         /* returns allocated segment in AX */
-    /* check CF */
-    jc failed
-    mov res, ax     /* set res to actual result */
-    failed:
-    /* set strategy back to its initial setting */
-    mov ah, 58h
-    mov al, 1
-    mov bx, cx
-    int 21h
-    pop cx    /* restore cx */
-  }
-  return(res);
-}
-
-/* free segment previously allocated through allocseg() */
-static void freeseg(unsigned short segm) {
-  _asm {
-    mov ah, 49h   /* free memory (DOS 2+) */
-    mov es, segm  /* put segment to free into ES */
-    int 21h
-  }
-}
-
-/* patch the TSR routine and packet driver handler so they use my new DS.
- * return 0 on success, non-zero otherwise */
-static int updatetsrds(void) {
-  unsigned short newds;
-  unsigned char far *ptr;
-  unsigned short far *sptr;
-  newds = 0;
-  _asm {
-    push ds
-    pop newds
-  }
-
-  /* first patch the TSR routine */
-  ptr = (unsigned char far *)inthandler + 24; /* the interrupt handler's signature appears at offset 23 (this might change at each source code modification and/or optimization settings) */
-  /*{
-    int x;
-    unsigned short far *VGA = (unsigned short far *)(0xB8000000l);
-    for (x = 0; x < 128; x++) VGA[80*12 + ((x >> 6) * 80) + (x & 63)] = 0x1f00 | ptr[x];
-  }*/
-  sptr = (unsigned short far *)ptr;
-  /* check for the routine's signature first ("MVet") */
-  if ((ptr[0] != 'M') || (ptr[1] != 'V') || (ptr[2] != 'e') || (ptr[3] != 't')) return(-1);
-  sptr[3] = newds;
-  /* now patch the pktdrv_recv() routine */
-  ptr = (unsigned char far *)pktdrv_recv + 3;
-  sptr = (unsigned short far *)ptr;
-  /*{
-    int x;
-    unsigned short far *VGA = (unsigned short far *)(0xB8000000l);
-    for (x = 0; x < 128; x++) VGA[80*12 + ((x >> 6) * 80) + (x & 63)] = 0x1f00 | ptr[x];
-  }*/
-  /* check for the routine's signature first */
-  if ((ptr[0] != 'p') || (ptr[1] != 'k') || (ptr[2] != 't') || (ptr[3] != 'r')) return(-1);
-  sptr[4] = newds;
-  /*{
-    int x;
-    unsigned short far *VGA = (unsigned short far *)(0xB8000000l);
-    for (x = 0; x < 128; x++) VGA[80*20 + ((x >> 6) * 80) + (x & 63)] = 0x1f00 | ptr[x];
-  }*/
-  return(0);
-}
-
-/* scans the 2Fh interrupt for some available 'multiplex id' in the range
- * C0..FF. also checks for EtherDFS presence at the same time. returns:
- *  - the available id if found
- *  - the id of the already-present etherdfs instance
- *  - 0 if no available id found
- * presentflag set to 0 if no etherdfs found loaded, non-zero otherwise. */
-static unsigned char findfreemultiplex(unsigned char *presentflag) {
-  unsigned char id = 0, freeid = 0, pflag = 0;
-  _asm {
-    mov id, 0C0h /* start scanning at C0h */
-    checkid:
-    xor al, al   /* subfunction is 'installation check' (00h) */
-    mov ah, id
-    int 2Fh
-    /* is it free? (AL == 0) */
-    test al, al
-    jnz notfree    /* not free - is it me perhaps? */
-    mov freeid, ah /* it's free - remember it, I may use it myself soon */
-    jmp checknextid
-    notfree:
-    /* is it me? (AL=FF + BX=4D86 CX=7E1 [MV 2017]) */
-    cmp al, 0ffh
-    jne checknextid
-    cmp bx, 4d86h
-    jne checknextid
-    cmp cx, 7e1h
-    jne checknextid
-    /* if here, then it's me... */
-    mov ah, id
-    mov freeid, ah
-    mov pflag, 1
-    jmp gameover
-    checknextid:
-    /* if not me, then check next id */
-    inc id
-    jnz checkid /* if id is zero, then all range has been covered (C0..FF) */
-    gameover:
-  }
-  *presentflag = pflag;
-  return(freeid);
-}
-
-int main(int argc, char **argv) {
-  struct argstruct args;
-  struct cdsstruct far *cds;
-  unsigned char tmpflag = 0;
-  int i;
-  unsigned short volatile newdataseg; /* 'volatile' just in case the compiler would try to optimize it out, since I set it through in-line assembly */
-
-  /* set all drive mappings as 'unused' */
-  for (i = 0; i < 26; i++) glob_data.ldrv[i] = 0xff;
-
-  /* parse command-line arguments */
-  zerobytes(&args, sizeof(args));
-  args.argc = argc;
-  args.argv = argv;
-  if (parseargv(&args) != 0) {
-    #include "msg/help.c"
-    return(1);
-  }
-
-  /* check DOS version - I require DOS 5.0+ */
-  _asm {
-    mov ax, 3306h
-    int 21h
-    mov tmpflag, bl
-    inc al /* if AL was 0xFF ("unsupported function"), it is 0 now */
-    jnz done
-    mov tmpflag, 0 /* if AL is 0 (hence was 0xFF), set dosver to 0 */
-    done:
-  }
-  if (tmpflag < 5) { /* tmpflag contains DOS version or 0 for 'unknown' */
-    #include "msg\\unsupdos.c"
-    return(1);
-  }
-
-  /* look whether or not it's ok to install a network redirector at int 2F */
-  _asm {
-    mov tmpflag, 0
-    mov ax, 1100h
-    int 2Fh
-    dec ax /* if AX was set to 1 (ie. "not ok to install"), it's zero now */
-    jnz goodtogo
-    mov tmpflag, 1
-    goodtogo:
-  }
-  if (tmpflag != 0) {
-    #include "msg\\noredir.c"
-    return(1);
-  }
-
-  /* is it all about unloading myself? */
-  if ((args.flags & ARGFL_UNLOAD) != 0) {
-    unsigned char etherdfsid, pktint;
-    unsigned short myseg, myoff, myhandle, mydataseg;
-    unsigned long pktdrvcall;
-    struct tsrshareddata far *tsrdata;
-    unsigned char far *int2fptr;
-
-    /* am I loaded at all? */
-    etherdfsid = findfreemultiplex(&tmpflag);
-    if (tmpflag == 0) { /* not loaded, cannot unload */
-      #include "msg\\notload.c"
-      return(1);
-    }
-    /* am I still at the top of the int 2Fh chain? */
-    _asm {
-      /* save AX, BX and ES */
-      push ax
-      push bx
-      push es
-      /* fetch int vector */
-      mov ax, 352Fh  /* AH=35h 'GetVect' for int 2Fh */
-      int 21h
-      mov myseg, es
-      mov myoff, bx
-      /* restore AX, BX and ES */
-      pop es
-      pop bx
-      pop ax
-    }
-    int2fptr = (unsigned char far *)MK_FP(myseg, myoff) + 24; /* the interrupt handler's signature appears at offset 24 (this might change at each source code modification) */
-    /* look for the "MVet" signature */
-    if ((int2fptr[0] != 'M') || (int2fptr[1] != 'V') || (int2fptr[2] != 'e') || (int2fptr[3] != 't')) {
-      #include "msg\\othertsr.c";
-      return(1);
-    }
-    /* get the ptr to TSR's data */
-    _asm {
-      push ax
-      push bx
-      push cx
-      pushf
-      mov ah, etherdfsid
-      mov al, 1
-      mov cx, 4d86h
-      mov myseg, 0ffffh
-      int 2Fh /* AX should be 0, and BX:CX contains the address */
-      test ax, ax
-      jnz fail
-      mov myseg, bx
-      mov myoff, cx
-      mov mydataseg, dx
-      fail:
-      popf
-      pop cx
-      pop bx
-      pop ax
-    }
-    if (myseg == 0xffffu) {
-      #include "msg\\tsrcomfa.c"
-      return(1);
-    }
-    tsrdata = MK_FP(myseg, myoff);
-    mydataseg = myseg;
-    /* restore previous int 2f handler (under DS:DX, AH=25h, INT 21h)*/
-    myseg = tsrdata->prev_2f_handler_seg;
-    myoff = tsrdata->prev_2f_handler_off;
-    _asm {
-      /* save AX, DS and DX */
-      push ax
-      push ds
-      push dx
-      /* set DS:DX */
-      mov ax, myseg
-      push ax
-      pop ds
-      mov dx, myoff
-      /* call INT 21h,25h for int 2Fh */
-      mov ax, 252Fh
-      int 21h
-      /* restore AX, DS and DX */
-      pop dx
-      pop ds
-      pop ax
-    }
-    /* get the address of the packet driver routine */
-    pktint = tsrdata->pktint;
-    _asm {
-      /* save AX, BX and ES */
-      push ax
-      push bx
-      push es
-      /* fetch int vector */
-      mov ah, 35h  /* AH=35h 'GetVect' */
-      mov al, pktint /* interrupt */
-      int 21h
-      mov myseg, es
-      mov myoff, bx
-      /* restore AX, BX and ES */
-      pop es
-      pop bx
-      pop ax
-    }
-    pktdrvcall = myseg;
-    pktdrvcall <<= 16;
-    pktdrvcall |= myoff;
-    /* unregister packet driver */
-    myhandle = tsrdata->pkthandle;
-    _asm {
-      /* save AX and BX */
-      push ax
-      push bx
-      /* prepare the release_type() call */
-      mov ah, 3 /* release_type() */
-      mov bx, myhandle
-      /* call the pktdrv int */
-      /* int to variable vector is a mess, so I have fetched its vector myself
-       * and pushf + cli + call far it now to simulate a regular int */
-      pushf
-      cli
-      call dword ptr pktdrvcall
-      /* restore AX and BX */
-      pop bx
-      pop ax
-    }
-    /* set all mapped drives as 'not available' */
-    for (i = 0; i < 26; i++) {
-      if (tsrdata->ldrv[i] == 0xff) continue;
-      cds = getcds(i);
-      if (cds != NULL) cds->flags = 0;
-    }
-    /* free TSR's data/stack seg and its PSP */
-    freeseg(mydataseg);
-    freeseg(tsrdata->pspseg);
-    /* all done */
-    #include "msg\\unloaded.c"
-    return(0);
-  }
-
-  /* remember current int 2f handler, we might over-write it soon (also I
-   * use it to see if I'm already loaded) */
-  _asm {
-    mov ax, 352fh; /* AH=GetVect AL=2F */
-    push es /* save ES and BX (will be overwritten) */
-    push bx
-    int 21h
-    mov word ptr [glob_data + GLOB_DATOFF_PREV2FHANDLERSEG], es
-    mov word ptr [glob_data + GLOB_DATOFF_PREV2FHANDLEROFF], bx
-    pop bx
-    pop es
-  }
-
-  /* is the TSR installed already? */
-  glob_multiplexid = findfreemultiplex(&tmpflag);
-  if (tmpflag != 0) { /* already loaded */
-    #include "msg\\alrload.c"
-    return(1);
-  } else if (glob_multiplexid == 0) { /* no free multiplex id found */
-    #include "msg\\nomultpx.c"
-    return(1);
-  }
-
-  /* if any of the to-be-mapped drives is already active, fail */
-  for (i = 0; i < 26; i++) {
-    if (glob_data.ldrv[i] == 0xff) continue;
-    cds = getcds(i);
-    if (cds == NULL) {
-      #include "msg\\mapfail.c"
-      return(1);
-    }
-    if (cds->flags != 0) {
-      #include "msg\\drvactiv.c"
-      return(1);
-    }
-  }
-
-  /* allocate a new segment for all my internal needs, and use it right away
-   * as DS */
-  newdataseg = allocseg(DATASEGSZ);
-  if (newdataseg == 0) {
-    #include "msg\\memfail.c"
-    return(1);
-  }
-
-  /* copy current DS into the new segment and switch to new DS/SS */
-  _asm {
-    /* save registers on the stack */
-    push es
-    push cx
-    push si
-    push di
-    pushf
-    /* copy the memory block */
-    mov cx, DATASEGSZ  /* copy cx bytes */
-    xor si, si         /* si = 0*/
-    xor di, di         /* di = 0 */
-    cld                /* clear direction flag (increment si/di) */
-    mov es, newdataseg /* load es with newdataseg */
-    rep movsb          /* execute copy DS:SI -> ES:DI */
-    /* restore registers (but NOT es, instead save it into AX for now) */
-    popf
-    pop di
-    pop si
-    pop cx
-    pop ax
-    /* switch to the new DS _AND_ SS now */
-    push es
-    push es
-    pop ds
-    pop ss
-    /* restore ES */
-    push ax
-    pop es
-  }
-
-  /* patch the TSR and pktdrv_recv() so they use my new DS */
-  if (updatetsrds() != 0) {
-    #include "msg\\relfail.c"
-    freeseg(newdataseg);
-    return(1);
-  }
-
-  /* remember the SDA address (will be useful later) */
-  glob_sdaptr = getsda();
-
-  /* init the packet driver interface */
-  glob_data.pktint = 0;
-  if (args.pktint == 0) { /* detect first packet driver within int 60h..80h */
-    for (i = 0x60; i <= 0x80; i++) {
-      if (pktdrv_init(i) == 0) break;
-    }
-  } else { /* use the pktdrvr interrupt passed through command line */
-    pktdrv_init(args.pktint);
-  }
-  /* has it succeeded? */
-  if (glob_data.pktint == 0) {
-    #include "msg\\pktdfail.c"
-    freeseg(newdataseg);
-    return(1);
-  }
-  pktdrv_getaddr(GLOB_LMAC);
-
-  /* should I auto-discover the server? */
-  if ((args.flags & ARGFL_AUTO) != 0) {
-    unsigned short *ax;
-    unsigned char *answer;
-    /* set (temporarily) glob_rmac to broadcast */
-    for (i = 0; i < 6; i++) GLOB_RMAC[i] = 0xff;
-    for (i = 0; glob_data.ldrv[i] == 0xff; i++); /* find first mapped disk */
-    /* send a discovery frame that will update glob_rmac */
-    if (sendquery(AL_DISKSPACE, i, 0, &answer, &ax, 1) != 6) {
-      #include "msg\\nosrvfnd.c"
-      pktdrv_free(glob_pktdrv_pktcall); /* free the pkt drv and quit */
-      freeseg(newdataseg);
-      return(1);
-    }
-  }
-
-  /* set all drives as being 'network' drives (also add the PHYSICAL bit,
-   * otherwise MS-DOS 6.0 will ignore the drive) */
-  for (i = 0; i < 26; i++) {
-    if (glob_data.ldrv[i] == 0xff) continue;
-    cds = getcds(i);
-    cds->flags = CDSFLAG_NET | CDSFLAG_PHY;
-    /* set 'current path' to root, to avoid inheriting any garbage */
-    cds->current_path[0] = 'A' + i;
-    cds->current_path[1] = ':';
-    cds->current_path[2] = '\\';
-    cds->current_path[3] = 0;
-  }
-
-  if ((args.flags & ARGFL_QUIET) == 0) {
-    char buff[20];
-    #include "msg\\instlled.c"
-    for (i = 0; i < 6; i++) {
-      byte2hex(buff + i + i + i, GLOB_LMAC[i]);
-    }
-    for (i = 2; i < 16; i += 3) buff[i] = ':';
-    buff[17] = '$';
-    outmsg(buff);
-    #include "msg\\pktdrvat.c"
-    byte2hex(buff, glob_data.pktint);
-    buff[2] = ')';
-    buff[3] = '\r';
-    buff[4] = '\n';
-    buff[5] = '$';
-    outmsg(buff);
-    for (i = 0; i < 26; i++) {
-      int z;
-      if (glob_data.ldrv[i] == 0xff) continue;
-      buff[0] = ' ';
-      buff[1] = 'A' + i;
-      buff[2] = ':';
-      buff[3] = ' ';
-      buff[4] = '-';
-      buff[5] = '>';
-      buff[6] = ' ';
-      buff[7] = '[';
-      buff[8] = 'A' + glob_data.ldrv[i];
-      buff[9] = ':';
-      buff[10] = ']';
-      buff[11] = ' ';
-      buff[12] = 'o';
-      buff[13] = 'n';
-      buff[14] = ' ';
-      buff[15] = '$';
-      outmsg(buff);
-      for (z = 0; z < 6; z++) {
-        byte2hex(buff + z + z + z, GLOB_RMAC[z]);
-      }
-      for (z = 2; z < 16; z += 3) buff[z] = ':';
-      buff[17] = '\r';
-      buff[18] = '\n';
-      buff[19] = '$';
-      outmsg(buff);
-    }
-  }
-
-  /* get the segment of the PSP (might come handy later) */
-  _asm {
-    mov ah, 62h          /* get current PSP address */
-    int 21h              /* returns the segment of PSP in BX */
-    mov word ptr [glob_data + GLOB_DATOFF_PSPSEG], bx  /* copy PSP segment to glob_pspseg */
-  }
-
-  /* free the environment (env segment is at offset 2C of the PSP) */
-  _asm {
-    mov es, word ptr [glob_data + GLOB_DATOFF_PSPSEG] /* load ES with PSP's segment */
-    mov es, es:[2Ch]    /* get segment of the env block */
-    mov ah, 49h         /* free memory (DOS 2+) */
-    int 21h
-  }
-
-  /* set up the TSR (INT 2F catching) */
-  _asm {
-    cli
-    mov ax, 252fh /* AH=set interrupt vector  AL=2F */
-    push ds /* preserve DS and DX */
-    push dx
-    push cs /* set DS to current CS, that is provide the */
-    pop ds  /* int handler's segment */
-    mov dx, offset inthandler /* int handler's offset */
-    int 21h
-    pop dx /* restore DS and DX to previous values */
-    pop ds
-    sti
-  }
-
-  /* Turn self into a TSR and free memory I won't need any more. That is, I
-   * free all the libc startup code and my init functions by passing the
-   * number of paragraphs to keep resident to INT 21h, AH=31h. How to compute
-   * the number of paragraphs? Simple: look at the memory map and note down
-   * the size of the BEGTEXT segment (that's where I store all TSR routines).
-   * then: (sizeof(BEGTEXT) + sizeof(PSP) + 15) / 16
-   * PSP is 256 bytes of course. And +15 is needed to avoid truncating the
-   * last (partially used) paragraph. */
-  _asm {
-    mov ax, 3100h  /* AH=31 'terminate+stay resident', AL=0 exit code */
-    mov dx, offset begtextend /* DX = offset of resident code end     */
-    add dx, 256    /* add size of PSP (256 bytes)                     */
-    add dx, 15     /* add 15 to avoid truncating last paragraph       */
-    shr dx, 1      /* convert bytes to number of 16-bytes paragraphs  */
-    shr dx, 1      /* the 8086/8088 CPU supports only a 1-bit version */
-    shr dx, 1      /* of SHR, so I have to repeat it as many times as */
-    shr dx, 1      /* many bits I need to shift.                      */
-    int 21h
-  }
-
-  return(0); /* never reached, but compiler complains if not present */
-}
+/*
+ * ethdrive - a network drive for DOS running over raw ethernet
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* HOSTBUILD is defined when the resident core is compiled natively on a
+ * development machine (see host/hostcore.c). Everything that talks to the
+ * hardware, to the packet driver or to DOS itself is left out then, and the
+ * host build provides a simulation of it instead */
+#ifndef HOSTBUILD
+#include <i86.h>     /* union INTPACK */
+#include "chint.h"   /* _mvchain_intr() */
+#endif
+#include "version.h" /* program & protocol version */
+#include "mplex.h"   /* multiplex interface */
+
+/* set DEBUGLEVEL to 0, 1 or 2 to turn on debug mode with desired verbosity */
+#define DEBUGLEVEL 0
+
+/* define the default size of a frame, as sent or received by etherdfs. this
+ * is used with servers that do not tell what frame size they can handle.
+ * example: value 1084 accomodates payloads up to 1024 bytes +all headers */
+#define FRAMESIZE 1090
+
+/* bounds of the frame size, whatever the packet driver, the server or the
+ * user may say (frame buffers are allocated at runtime, see main()) */
+#define FRAMESIZEMIN 576
+#define FRAMESIZEMAX 9216
+
+/* biggest data segment, frame (and read-ahead, write-back) buffers and caches
+ * included - they are all addressed through near pointers */
+#define DATASEGMAX 0xFFF0u
+
+/* default (and maximum) amount of slots in the receive ring */
+#define RXSLOTS 4
+#define RXSLOTSMAX 8
+
+/* default (and maximum) amount of read-ahead buffers, and the size of each
+ * buffer expressed in frames */
+#define RACACHES 2
+#define RACACHEMAX 4
+#define RAFRAMES 2
+
+/* default (and maximum) amount of write-back buffers, the size of each buffer
+ * expressed in WRITESTREAM frames, and for how long (in BIOS ticks) data may
+ * wait in a buffer once the system is idle */
+#define WBCACHES 1
+#define WBCACHEMAX 4
+#define WBFRAMES 4
+#define WBIDLE 18
+
+/* maximum amount of directory entries asked for in a single FINDBATCH query
+ * (and kept in the directory cache) */
+#define DIRBATCHMAX 64
+
+/* amount of entries in the metadata cache, the longest path (drive excluded)
+ * an entry can hold, and the default (and maximum) time a result may be
+ * reused for, in seconds (/a=N) */
+#define MDCACHES 12
+#define MDPATHMAX 64
+#define MDTTL 2
+#define MDTTLMAX 60
+
+/* how long (in BIOS ticks, no longer than the metadata cache TTL) a "file not
+ * found" or "path not found" result may be reused, and the flag that marks
+ * such negative results in the metadata cache */
+#define NEGTTL 18
+#define MDNEG 0x80
+
+/* maximum amount of distinct servers drives can be mapped to (replicas
+ * included), how often (in BIOS ticks) a primary server that stopped
+ * answering is probed once DOS is idle, and for how long (in pit_now()
+ * units) the answer to a probe is awaited */
+#define SRVMAX 4
+#define PROBEIVAL 91
+#define PROBEWAIT 1024
+
+/* maximum amount of records in the trace ring (/t=N) */
+#define TRACEMAX 1000
+
+/* room taken by latency histograms (/l) */
+#define HISTSZ (0x2F * sizeof(struct mpxhist))
+
+/* maximum amount of READFIL queries that may be in flight simultaneously */
+#define READWINDOW 4
+
+/* maximum amount of WRITESTREAM frames sent in a single burst (16 max) */
+#define WRITEWINDOW 8
+
+/* longest read that fits in the 64 fragments of a single READBULK query */
+#define READBULKMAX ((glob_framesize > 1085)?0xFFFFu:(64 * (glob_framesize - 62)))
+
+/* retransmission timeouts, in units of 1/1024th of a BIOS tick (about 54us,
+ * see pit_now()). RTOINIT is used until a first round-trip is measured, and
+ * a query is given up once its timeouts add up to QUERYPATIENCE (which gives
+ * any query at least 3 attempts, since RTOMAX is 4 ticks) */
+#define RTOINIT 2048
+#define RTOMIN 96
+#define RTOMAX 4096
+#define QUERYPATIENCE 10240
+
+#include "dosstruc.h" /* definitions of structures used by DOS */
+#include "globals.h"  /* global variables used by etherdfs */
+
+/* define NULL, for readability of the code */
+#ifndef NULL
+  #define NULL (void *)0
+#endif
+
+/* all the resident code goes to segment 'BEGTEXT' */
+#pragma code_seg(BEGTEXT, CODE)
+
+
+/* copies l bytes from *s to *d, a word at a time. On a 386+ this gets
+ * patched at startup so it goes a dword at a time instead (see cpupatch()):
+ * the two NOPs become a second SHR CX,1, the third one becomes an operand
+ * size prefix (REP MOVSW -> REP MOVSD), and the final AND takes 3 bytes
+ * left over instead of 1 */
+#ifndef HOSTBUILD
+static void copybytes(void far *d, void far *s, unsigned int l) {
+  _asm {
+    push ds
+    push es
+    push si
+    push di
+    push cx
+    push bx
+    mov cx, l
+    les di, d
+    lds si, s
+    mov bx, cx
+    cld
+    jmp SKIPCPYSIG
+    CPYSIG db 'M','V','c','p'
+    SKIPCPYSIG:
+    shr cx, 1
+    nop
+    nop
+    nop
+    rep movsw
+    mov cx, bx
+    db 83h, 0E1h, 01h /* and cx, 1 */
+    rep movsb
+    pop bx
+    pop cx
+    pop di
+    pop si
+    pop es
+    pop ds
+  }
+}
+
+/* returns the length of the NULL-terminated string s */
+static unsigned short mystrlen(void far *s) {
+  unsigned short res = 0;
+  _asm {
+    push es
+    push di
+    push cx
+    push ax
+    les di, s
+    xor al, al
+    mov cx, 0FFFFh
+    cld
+    repne scasb
+    not cx /* cx = bytes scanned, terminator included */
+    dec cx
+    mov res, cx
+    pop ax
+    pop cx
+    pop di
+    pop es
+  }
+  return(res);
+}
+#endif
+
+/* returns -1 if the NULL-terminated s string contains any wildcard (?, *)
+ * character. otherwise returns the length of the string. */
+static int len_if_no_wildcards(char far *s) {
+  int r = 0;
+  for (;;) {
+    switch (*s) {
+      case 0: return(r);
+      case '?':
+      case '*': return(-1);
+    }
+    r++;
+    s++;
+  }
+}
+
+/* this function is called two times by the packet driver. One time for
+ * telling that a packet is incoming, and how big it is, so the application
+ * can prepare a buffer for it and hand it back to the packet driver. the
+ * second call is just to let know that the frame has been copied into the
+ * buffer. This is a naked function - I don't need the compiler to get into
+ * the way when dealing with packet driver callbacks.
+ * Frames are stored in a ring of receive slots: the packet driver is always
+ * handed the buffer of the slot at glob_rxhead, and the head moves on to the
+ * next slot once the frame is there, unless the frame is obviously not an
+ * answer to any of my pending queries (not from/to the right MAC, not EDF5 or
+ * with a seq that I do not expect) - such frames are dropped right away so
+ * they do not waste a slot. When the slot at the head is not free, the ring
+ * is full and the frame is refused.
+ * If a direct receive target is armed (see directrecv()) and the frame's
+ * payload fits into it, then the packet driver is handed a pointer that is
+ * glob_directhdr bytes before the target, so the payload lands right where
+ * it belongs (typically the caller's DTA) and doesn't need to be copied
+ * later. The bytes that get overwritten by headers are saved beforehand in
+ * the slot's buffer, and swapped back on the second call, so headers end
+ * up in the slot as usual. The target is disarmed as soon as a frame goes
+ * there, so it never receives more than one frame.
+ * IMPORTANT: this function must take care to modify ONLY the registers
+ * ES and DI - packet drivers can be easily confused should anything else
+ * be modified. */
+#ifndef HOSTBUILD
+void __declspec(naked) far pktdrv_recv(void) {
+  _asm {
+    jmp skip
+    SIG db 'p','k','t','r'
+    skip:
+    /* save DS and flags to stack */
+    push ds  /* save old ds (I will change it) */
+    push bx  /* save bx (I use it as a pointer to the head slot) */
+    pushf    /* save flags */
+    /* set my custom DS (not 0, it has been patched at runtime already) */
+    mov bx, 0
+    mov ds, bx
+    mov bx, glob_rxhead
+    /* handle the call */
+    cmp ax, 0
+    jne secondcall /* if ax != 0, then packet driver just filled my buffer */
+    /* first call: the packet driver needs a buffer of CX bytes */
+    cmp cx, glob_framesize /* is cx > glob_framesize ? (unsigned) */
+    ja nobufferavail  /* it is too small (that's what she said!) */
+    /* see if the head slot is free (otherwise the ring is full) */
+    cmp word ptr [bx + RXSLOT_LEN], 0
+    jne nobufferavail
+    /* set slot's len to expected len and switch it to neg until data comes */
+    mov [bx + RXSLOT_LEN], cx
+    neg word ptr [bx + RXSLOT_LEN]
+    mov byte ptr [bx + RXSLOT_HIT], 0
+
+    /* can the payload go straight to the direct receive target? it must be
+     * armed (non-zero len) and the payload must not be longer than that */
+    push cx
+    sub cx, glob_directhdr
+    jbe usebuff       /* frame not longer than headers */
+    cmp cx, glob_directlen
+    ja usebuff        /* payload too long (or target not armed) */
+    /* save the bytes that are about to be overwritten by headers */
+    push si
+    mov cx, glob_directhdr
+    mov si, glob_directoff
+    sub si, cx
+    push ds /* set es:di to the slot's buffer */
+    pop es
+    mov di, [bx + RXSLOT_BUFF]
+    push ds                  /* remember my DS */
+    mov ds, glob_directseg   /* DS:SI points to target - headers */
+    cld
+    rep movsb
+    pop ds                   /* switch back to my DS */
+    pop si
+    pop cx
+    /* hand out the target minus headers in es:di */
+    mov es, glob_directseg
+    mov di, glob_directoff
+    sub di, glob_directhdr
+    mov byte ptr [bx + RXSLOT_HIT], 1
+    mov glob_directlen, 0    /* the target is good for one frame only */
+    jmp restoreandret
+
+  usebuff: /* the frame goes to the slot's buffer */
+    pop cx
+    push ds /* set es:di to the slot's buffer */
+    pop es
+    mov di, [bx + RXSLOT_BUFF]
+    /* restore flags, bx and ds, then return */
+    jmp restoreandret
+
+  nobufferavail: /* no buffer available, or it's too small -> fail */
+    add word ptr [glob_stats + GLOB_STATOFF_RXBUSY], 1
+    adc word ptr [glob_stats + GLOB_STATOFF_RXBUSY + 2], 0
+    xor bx,bx      /* set bx to zero... */
+    push bx        /* and push it to the stack... */
+    push bx        /* twice */
+    pop es         /* zero out es and di - this tells the */
+    pop di         /* packet driver 'sorry no can do'     */
+    /* restore flags, bx and ds, then return */
+    jmp restoreandret
+
+  secondcall: /* second call: I've just got data in the head slot */
+    /* I switch back slot's len to positive */
+    neg word ptr [bx + RXSLOT_LEN]
+    push ax
+    push cx
+    push si
+    cld
+    /* if the frame went to the direct target, swap its headers with the
+     * bytes I saved in the slot's buffer during the first call */
+    cmp byte ptr [bx + RXSLOT_HIT], 0
+    je validate
+    mov cx, glob_directhdr
+    mov di, glob_directoff
+    sub di, cx
+    mov es, glob_directseg
+    mov si, [bx + RXSLOT_BUFF]
+  swaphdr:
+    mov al, es:[di]
+    xchg al, [si]
+    stosb /* es:[di] = al, then di++ */
+    inc si
+    loop swaphdr
+
+  validate: /* is it an answer to one of my pending queries? */
+    cmp word ptr [bx + RXSLOT_LEN], 60 /* long enough? (signed) */
+    jl dropframe
+    push ds
+    pop es
+    mov si, [bx + RXSLOT_BUFF]
+    cmp word ptr [si + 12], 0F5EDh /* is the ethertype what I expect? */
+    jne dropframe
+    /* is the seq within glob_rxseqlo..glob_seq? */
+    mov al, [si + 57]
+    sub al, glob_rxseqlo
+    mov ah, glob_seq
+    sub ah, glob_rxseqlo
+    cmp al, ah
+    ja dropframe
+    /* is it for me? (dst mac = my mac) */
+    mov di, glob_pktdrv_sndbuff
+    add di, 6
+    mov cx, 3
+    repe cmpsw
+    jne dropframe
+    /* is it from my server? (src mac = remote mac, unless I accept any) */
+    cmp glob_rxanysrc, 0
+    jne keepframe
+    sub di, 12     /* es:di = remote mac, while ds:si = src mac already */
+    mov cx, 3
+    repe cmpsw
+    jne dropframe
+  keepframe: /* frame is good - move the head to the next slot */
+    add word ptr [glob_stats + GLOB_STATOFF_RXFRAMES], 1
+    adc word ptr [glob_stats + GLOB_STATOFF_RXFRAMES + 2], 0
+    add bx, RXSLOTSZ
+    cmp bx, glob_rxend
+    jb headok
+    mov bx, offset glob_rxslot
+  headok:
+    mov glob_rxhead, bx
+    jmp secondret
+  dropframe: /* frame is of no interest - free the slot right away */
+    mov word ptr [bx + RXSLOT_LEN], 0
+    add word ptr [glob_stats + GLOB_STATOFF_RXIGNORED], 1
+    adc word ptr [glob_stats + GLOB_STATOFF_RXIGNORED + 2], 0
+  secondret:
+    pop si
+    pop cx
+    pop ax
+    /* restore flags, bx and ds, then return */
+  restoreandret:
+    popf   /* restore flags */
+    pop bx /* restore bx */
+    pop ds /* restore ds */
+    retf
+  }
+}
+#endif
+
+
+/* arms the direct receive path of pktdrv_recv(), so the next frame carrying
+ * hdr bytes of headers and no more than len bytes of payload gets its payload
+ * written by the packet driver straight at dst. The target is left disarmed
+ * if dst is too close to a segment boundary for headers or payload to fit.
+ * Disarming is done by setting glob_directlen to 0 - this MUST be done
+ * whenever the target is about to become invalid, and also before returning
+ * to the application. pktdrv_recv() disarms the target by itself once a
+ * frame went there. The target must be armed only while the receive ring is
+ * empty, so the payload of a frame still waiting in the ring can be found at
+ * glob_directseg:glob_directoff. */
+static void directrecv(unsigned char far *dst, unsigned short len, unsigned short hdr) {
+  unsigned short seg = FP_SEG(dst), off = FP_OFF(dst);
+  glob_directlen = 0; /* disarm first, so pktdrv_recv() never sees a half-set target */
+  /* make sure headers can be written right before dst */
+  if (off < hdr) {
+    if (seg < 4) return;
+    seg -= 4;
+    off += 64;
+  }
+  if (off > 0xFFFFu - len) return; /* payload would wrap around the segment */
+  glob_directseg = seg;
+  glob_directoff = off;
+  glob_directhdr = hdr;
+  glob_directlen = len;
+}
+
+
+/* translates a drive letter (either upper- or lower-case) into a number (A=0,
+ * B=1, C=2, etc) */
+#define DRIVETONUM(x) (((x) >= 'a') && ((x) <= 'z')?x-'a':x-'A')
+
+
+/* all the calls I support are in the range AL=0..2Eh - the list below serves
+ * as a convenience to compare AL (subfunction) values */
+enum AL_SUBFUNCTIONS {
+  AL_INSTALLCHK = 0x00,
+  AL_RMDIR      = 0x01,
+  AL_MKDIR      = 0x03,
+  AL_CHDIR      = 0x05,
+  AL_CLSFIL     = 0x06,
+  AL_CMMTFIL    = 0x07,
+  AL_READFIL    = 0x08,
+  AL_WRITEFIL   = 0x09,
+  AL_LOCKFIL    = 0x0A,
+  AL_UNLOCKFIL  = 0x0B,
+  AL_DISKSPACE  = 0x0C,
+  AL_SETATTR    = 0x0E,
+  AL_GETATTR    = 0x0F,
+  AL_RENAME     = 0x11,
+  AL_DELETE     = 0x13,
+  AL_OPEN       = 0x16,
+  AL_CREATE     = 0x17,
+  AL_FINDFIRST  = 0x1B,
+  AL_FINDNEXT   = 0x1C,
+  AL_SKFMEND    = 0x21,
+  AL_UNKNOWN_2D = 0x2D,
+  AL_SPOPNFIL   = 0x2E,
+  AL_UNKNOWN    = 0xFF
+};
+
+/* EDF5 protocol extensions - these are not INT 2F subfunctions, but queries
+ * that only ever travel between EtherDFS and the server (see protocol.txt).
+ * Extensions are used only if the server announced them through GETCAPS. */
+enum EXT_SUBFUNCTIONS {
+  EXT_GETCAPS     = 0x40,
+  EXT_WRITESTREAM = 0x41,
+  EXT_READBULK    = 0x42,
+  EXT_FINDBATCH   = 0x43,
+  EXT_SRVCOPY     = 0x44
+};
+
+/* capability bits, as exchanged through EXT_GETCAPS */
+#define CAP_WRITESTREAM 0x0001u
+#define CAP_READBULK    0x0002u
+#define CAP_FINDBATCH   0x0004u
+#define CAP_COMPRESS    0x0008u
+#define CAP_SRVCOPY     0x0010u
+
+/* flags that may be set in the high bits of the D byte of a query (the low
+ * 5 bits being the remote drive). These are used only if CAP_COMPRESS has
+ * been negotiated. */
+#define DFLAG_ZDATA     0x80 /* data carried by the query is compressed */
+#define DFLAG_ZANSWER   0x40 /* a compressed answer is welcome */
+
+/* this table makes it easy to figure out if I want a subfunction or not */
+static unsigned char supportedfunctions[0x2F] = {
+  AL_INSTALLCHK,  /* 0x00 */
+  AL_RMDIR,       /* 0x01 */
+  AL_UNKNOWN,     /* 0x02 */
+  AL_MKDIR,       /* 0x03 */
+  AL_UNKNOWN,     /* 0x04 */
+  AL_CHDIR,       /* 0x05 */
+  AL_CLSFIL,      /* 0x06 */
+  AL_CMMTFIL,     /* 0x07 */
+  AL_READFIL,     /* 0x08 */
+  AL_WRITEFIL,    /* 0x09 */
+  AL_LOCKFIL,     /* 0x0A */
+  AL_UNLOCKFIL,   /* 0x0B */
+  AL_DISKSPACE,   /* 0x0C */
+  AL_UNKNOWN,     /* 0x0D */
+  AL_SETATTR,     /* 0x0E */
+  AL_GETATTR,     /* 0x0F */
+  AL_UNKNOWN,     /* 0x10 */
+  AL_RENAME,      /* 0x11 */
+  AL_UNKNOWN,     /* 0x12 */
+  AL_DELETE,      /* 0x13 */
+  AL_UNKNOWN,     /* 0x14 */
+  AL_UNKNOWN,     /* 0x15 */
+  AL_OPEN,        /* 0x16 */
+  AL_CREATE,      /* 0x17 */
+  AL_UNKNOWN,     /* 0x18 */
+  AL_UNKNOWN,     /* 0x19 */
+  AL_UNKNOWN,     /* 0x1A */
+  AL_FINDFIRST,   /* 0x1B */
+  AL_FINDNEXT,    /* 0x1C */
+  AL_UNKNOWN,     /* 0x1D */
+  AL_UNKNOWN,     /* 0x1E */
+  AL_UNKNOWN,     /* 0x1F */
+  AL_UNKNOWN,     /* 0x20 */
+  AL_SKFMEND,     /* 0x21 */
+  AL_UNKNOWN,     /* 0x22 */
+  AL_UNKNOWN,     /* 0x23 */
+  AL_UNKNOWN,     /* 0x24 */
+  AL_UNKNOWN,     /* 0x25 */
+  AL_UNKNOWN,     /* 0x26 */
+  AL_UNKNOWN,     /* 0x27 */
+  AL_UNKNOWN,     /* 0x28 */
+  AL_UNKNOWN,     /* 0x29 */
+  AL_UNKNOWN,     /* 0x2A */
+  AL_UNKNOWN,     /* 0x2B */
+  AL_UNKNOWN,     /* 0x2C */
+  AL_UNKNOWN_2D,  /* 0x2D */
+  AL_SPOPNFIL     /* 0x2E */
+};
+
+/*
+an INTPACK struct contains following items:
+regs.w.gs
+regs.w.fs
+regs.w.es
+regs.w.ds
+regs.w.di
+regs.w.si
+regs.w.bp
+regs.w.sp
+regs.w.bx
+regs.w.dx
+regs.w.cx
+regs.w.ax
+regs.w.ip
+regs.w.cs
+regs.w.flags (AND with INTR_CF to fetch the CF flag - INTR_CF is defined as 0x0001)
+
+regs.h.bl
+regs.h.bh
+regs.h.dl
+regs.h.dh
+regs.h.cl
+regs.h.ch
+regs.h.al
+regs.h.ah
+*/
+
+
+/* returns the current time, in units of 1/1024th of a BIOS tick (wraps every
+ * 64 ticks, ie. about 3.5s). The BIOS tick counter gives the high part, and
+ * the counter of PIT channel 0 (running in mode 2, see pit_init()) tells how
+ * much of the current tick elapsed already. A program that reprograms the PIT
+ * (square wave mode, or a faster rate) makes this counter go backwards within
+ * a tick, so the time returned never goes below the last one of the same
+ * tick: it stalls for the rest of the tick instead of timing out early. */
+#ifndef HOSTBUILD
+static unsigned short pit_now(void) {
+  unsigned short res;
+  _asm {
+    push bx
+    push cx
+    push es
+    pushf
+    cli
+    xor al, al     /* latch the counter of PIT channel 0 */
+    out 43h, al
+    in al, 40h     /* read it (low byte first) */
+    mov bl, al
+    in al, 40h
+    mov bh, al
+    neg bx         /* it counts down from 65536: bx = PIT clocks since last IRQ0 */
+    mov cl, 6
+    shr bx, cl     /* bx = 1/1024th of tick since last IRQ0 */
+    xor ax, ax
+    mov es, ax
+    mov cx, es:[46Ch] /* cx = BIOS tick counter (low word) */
+    /* if IRQ0 is pending (I have interrupts disabled) then the BIOS counter
+     * is late by one tick - unless the counter wrapped after being latched */
+    mov al, 0Ah    /* OCW3: next read from port 20h returns the PIC's IRR */
+    out 20h, al
+    in al, 20h
+    test al, 1
+    jz notlate
+    cmp bx, 512
+    jae notlate
+    inc cx
+    notlate:
+    mov ax, cx
+    mov cl, 10
+    shl ax, cl
+    or ax, bx
+    mov res, ax
+    popf
+    pop es
+    pop cx
+    pop bx
+  }
+  if (((res ^ glob_pitlast) & 0xFC00u) == 0) {
+    if (res < glob_pitlast) res = glob_pitlast;
+  }
+  glob_pitlast = res;
+  return(res);
+}
+#endif
+
+/* feeds a round-trip time (in pit_now() units) measured with server srv into
+ * its smoothed RTT and RTT variance estimators, and derives a new
+ * retransmission timeout from them (RTO = SRTT + 4 * RTTVAR, as TCP does).
+ * glob_srtt is kept scaled by 8 and glob_rttvar by 4, so it all works on
+ * integers. Only answers to queries that have not been retransmitted may be
+ * measured (Karn's rule). */
+static void rttsample(unsigned char srv, unsigned short m) {
+  signed short delta;
+  if (m > 8191) m = 8191; /* glob_srtt must not overflow */
+  if (glob_srtt[srv] == 0) { /* first measurement */
+    glob_srtt[srv] = m << 3;
+    glob_rttvar[srv] = m << 1;
+  } else {
+    delta = m - (glob_srtt[srv] >> 3);
+    glob_srtt[srv] += delta;
+    if (delta < 0) delta = -delta;
+    glob_rttvar[srv] += delta - (glob_rttvar[srv] >> 2);
+  }
+  glob_rto[srv] = (glob_srtt[srv] >> 3) + glob_rttvar[srv];
+  if (glob_rto[srv] < RTOMIN) glob_rto[srv] = RTOMIN;
+  if (glob_rto[srv] > RTOMAX) glob_rto[srv] = RTOMAX;
+}
+
+/* returns the timeout to use after rto expired with server srv (exponential
+ * backoff). The backed off value is kept for next queries to srv until a new
+ * RTT is measured. */
+static unsigned short rtobackoff(unsigned char srv, unsigned short rto) {
+  glob_stats.rexmits++;
+  rto = (rto > RTOMAX / 2)?RTOMAX:(rto << 1);
+  if (rto > glob_rto[srv]) glob_rto[srv] = rto;
+  return(rto);
+}
+
+
+/* sends the frame currently stored in glob_pktdrv_sndbuff out. frmlen is the
+ * length of the whole frame, headers included. */
+#ifndef HOSTBUILD
+static void pktdrv_send(unsigned short frmlen) {
+  glob_stats.txframes++;
+  _asm {
+    /* save registers */
+    push ax
+    push cx
+    push dx /* may be changed by the packet driver (set to errno) */
+    push si
+    pushf /* must be last register pushed (expected by 'call') */
+    /* */
+    mov ah, 4h   /* SendPkt */
+    mov cx, frmlen
+    mov si, glob_pktdrv_sndbuff /* DS:SI points to buff, I do not modify DS
+                               because the buffer should already be in my
+                               data segment (small memory model) */
+    /* int to variable vector is a mess, so I have fetched its vector myself
+     * and pushf + cli + call far it now to simulate a regular int */
+    /* pushf -- already on the stack */
+    cli
+    call dword ptr glob_pktdrv_pktcall
+    /* restore registers (but not pushf, already restored by call) */
+    pop si
+    pop dx
+    pop cx
+    pop ax
+  }
+}
+#endif
+
+
+/* frees the slot of the oldest frame in the receive ring, so the next frame
+ * (if any) becomes available through glob_rxtail and glob_pktdrv_recvbuff */
+static void rxrelease(void) {
+  glob_rxtail->len = 0;
+  glob_rxtail++;
+  if (glob_rxtail == glob_rxend) glob_rxtail = glob_rxslot;
+  glob_pktdrv_recvbuff = glob_rxtail->buff;
+}
+
+
+/* drops all frames waiting in the receive ring */
+static void rxflush(void) {
+  while (glob_rxtail->len > 0) rxrelease();
+}
+
+
+/* addresses the next queries to the server that holds local drive drv -
+ * answers are expected to come from that same server */
+static void selectsrv(unsigned char drv) {
+  copybytes(GLOB_RMAC, glob_srvmac[glob_drvsrv[drv]], 6);
+}
+
+
+/* moves local drive drv to server srv. Files open on drv have been opened on
+ * the previous server, and the file ids it gave them mean nothing to srv:
+ * these files can't be used any more (see sftstale()), so whatever is read
+ * ahead or waits to be written for them is forgotten */
+static void srvswitch(unsigned char drv, unsigned char srv) {
+  struct racache *ra;
+  struct wbcache *wb;
+  if (glob_drvsrv[drv] == srv) return;
+  glob_drvsrv[drv] = srv;
+  glob_drvgen[drv]++;
+  for (ra = glob_racache; ra != glob_raend; ra++) {
+    if (ra->drive == drv) ra->drive = 0xff;
+  }
+  for (wb = glob_wbcache; wb != glob_wbend; wb++) {
+    if (wb->drive == drv) wb->drive = 0xff;
+  }
+}
+
+
+/* returns non-zero if the file of SFT entry sft has been opened before its
+ * drive switched servers (the switch count of the drive at open time is
+ * kept in dir_sector, that DOS leaves to redirectors) */
+static int sftstale(struct sftstruct far *sft) {
+  return(sft->dir_sector != glob_drvgen[sft->dev_info_word & 0x3F]);
+}
+
+
+/* gives up on server srv, that did not answer in time: every drive that
+ * uses it switches to the next replica of srv, or back to its primary server
+ * if srv was the last replica (drives without replicas stay where they are).
+ * srvprobe() takes care of coming back to the primary server later. */
+static void srvfailover(unsigned char srv) {
+  unsigned char d, next;
+  for (d = 0; d < 26; d++) {
+    if ((glob_data.ldrv[d] == 0xff) || (glob_drvsrv[d] != srv)) continue;
+    next = glob_srvnext[srv];
+    if (next == 0xff) next = glob_drvpri[d];
+    srvswitch(d, next);
+    if (next != glob_drvpri[d]) glob_failover = 1;
+  }
+}
+
+
+/* flags of sendquery(): SQ_UPDATERMAC accepts an answer from any server and
+ * remembers its address (server discovery), SQ_NOFAILOVER gives up as soon
+ * as the server does not answer, instead of trying its replicas. SQ_OPENFILE
+ * marks queries about an open file, that only the server it has been opened
+ * on knows: the drive still moves on to the next replica when the server
+ * does not answer, but the query is not resent there */
+#define SQ_UPDATERMAC 1
+#define SQ_NOFAILOVER 2
+#define SQ_OPENFILE 4
+
+/* sends query out, as found in glob_pktdrv_sndbuff, and awaits for an answer.
+ * if the server does not answer, the query is tried on its replicas (if any,
+ * and unless flags say otherwise). this function returns the length of
+ * replyptr, or 0xFFFF on error. */
+static unsigned short sendquery(unsigned char query, unsigned char drive, unsigned short bufflen, unsigned char **replyptr, unsigned short **replyax, unsigned char flags) {
+  unsigned short t, rto, spent = 0;
+  unsigned char drv = drive & 0x1F;
+  unsigned char firstsrv = glob_drvsrv[drv];
+
+  /* resolve remote drive - no need to validate it, it has been validated
+   * already by inthandler(). DFLAG_xxx flags, if any, are kept as-is */
+  selectsrv(drv);
+  drive = glob_data.ldrv[drv] | (drive & 0xE0);
+
+  /* if query too long then quit */
+  if (bufflen > glob_framesize - 60) return(0);
+  /* inc seq, and tell pktdrv_recv() that only answers to it are of interest */
+  glob_seq++;
+  glob_rxseqlo = glob_seq;
+  glob_rxanysrc = flags & SQ_UPDATERMAC;
+  /* I do not fill in ethernet headers (src mac, dst mac, ethertype), nor
+   * PROTOVER, since all these have been inited already at transient time */
+  /* padding (42 bytes) */
+  glob_pktdrv_sndbuff[57] = glob_seq; /* seq number */
+  glob_pktdrv_sndbuff[58] = drive;
+  glob_pktdrv_sndbuff[59] = query; /* AL value (query) */
+  /* I do not copy anything more into glob_pktdrv_sndbuff - the caller is
+   * expected to have already copied all relevant data into glob_pktdrv_sndbuff+60
+   * copybytes((unsigned char far *)glob_pktdrv_sndbuff + 60, (unsigned char far *)buff, bufflen);
+   */
+
+  /* send the query frame and wait for an answer for the current RTO. then,
+   * resend the query again and again, doubling the timeout each time, until
+   * QUERYPATIENCE is exhausted. */
+  rxflush(); /* drop any stale frame */
+  rto = glob_rto[glob_drvsrv[drv]];
+  for (;;) {
+    /* send the query frame out (I send 60 bytes more than what bufflen
+     * indicates, that's the headers) */
+    pktdrv_send(bufflen + 60);
+
+    /* wait for (and validate) the answer frame */
+    t = pit_now();
+    for (;;) {
+      if ((unsigned short)(pit_now() - t) >= rto) break; /* timeout, retry */
+      if (glob_rxtail->len < 1) continue;
+      /* I've got something! (pktdrv_recv() validated it already) */
+      glob_netwait += pit_now() - t;
+      /* measure the round-trip, unless the query has been sent more than once */
+      if (spent == 0) rttsample(glob_drvsrv[drv], pit_now() - t);
+      /* return buffer (without headers and seq) */
+      *replyptr = glob_pktdrv_recvbuff + 60;
+      *replyax = (unsigned short *)(glob_pktdrv_recvbuff + 58);
+      /* remember the address of the server if needed, then return */
+      if ((flags & SQ_UPDATERMAC) != 0) copybytes(glob_srvmac[glob_drvsrv[drv]], glob_pktdrv_recvbuff + 6, 6);
+      return(glob_rxtail->len - 60);
+    }
+    glob_netwait += rto;
+    spent += rto;
+    rto = rtobackoff(glob_drvsrv[drv], rto);
+    if (spent >= QUERYPATIENCE) {
+      /* the server is unreachable - move on to its next replica, and give up
+       * once all of them have been tried */
+      glob_stats.timeouts++;
+      if ((flags & SQ_NOFAILOVER) != 0) return(0xFFFFu);
+      srvfailover(glob_drvsrv[drv]);
+      if ((flags & SQ_OPENFILE) != 0) return(0xFFFFu);
+      if (glob_drvsrv[drv] == firstsrv) return(0xFFFFu); /* return error */
+      selectsrv(drv);
+      spent = 0;
+      rto = glob_rto[glob_drvsrv[drv]];
+    }
+  }
+}
+
+
+/* asks the server of local drive drv (that server only, not its replicas)
+ * about the protocol extensions it supports and the biggest frame it
+ * handles, and sticks to what it agrees on along with servers asked before.
+ * a server that does not know EXT_GETCAPS supports no extension, and gets
+ * frames of glob_framedef bytes (unless it is 0). returns 0 on success, or
+ * -1 if the server did not answer */
+static int srvgetcaps(unsigned char drv) {
+  unsigned short *ax;
+  unsigned short len, srvframe = 0;
+  unsigned char *answer;
+  ((unsigned short *)(glob_pktdrv_sndbuff + 60))[0] = glob_srvcaps;
+  ((unsigned short *)(glob_pktdrv_sndbuff + 60))[1] = glob_framesize;
+  len = sendquery(EXT_GETCAPS, drv, 4, &answer, &ax, SQ_NOFAILOVER);
+  if (len == 0xFFFFu) return(-1);
+  glob_srvunknown &= ~(1 << glob_drvsrv[drv]);
+  if ((len >= 2) && (*ax == 0)) {
+    glob_srvcaps &= ((unsigned short *)answer)[0];
+    if (len >= 4) srvframe = ((unsigned short *)answer)[1];
+  } else {
+    glob_srvcaps = 0;
+  }
+  if (srvframe == 0) {
+    srvframe = glob_framedef;
+  } else if (srvframe < FRAMESIZEMIN) {
+    srvframe = FRAMESIZEMIN;
+  }
+  if ((srvframe != 0) && (srvframe < glob_framesize)) glob_framesize = srvframe;
+  return(0);
+}
+
+
+/* makes sure that the extensions of the server local drive drv is about to
+ * use are known. servers that did not answer at load time are asked when
+ * they are first used, and what they do not support is given up on for all
+ * drives. a server that still does not answer is given up on, too: the
+ * drive moves on to the next replica, as sendquery() would do */
+static void srvcapscheck(unsigned char drv) {
+  unsigned char first = glob_drvsrv[drv];
+  while ((glob_srvunknown & (1 << glob_drvsrv[drv])) != 0) {
+    if (srvgetcaps(drv) == 0) {
+      if ((glob_srvcaps & CAP_COMPRESS) == 0) glob_lzhash = NULL;
+      if ((glob_srvcaps & CAP_FINDBATCH) == 0) glob_dirmax = 0;
+      if (glob_dirmax > (glob_framesize - 61) / 24) glob_dirmax = (glob_framesize - 61) / 24;
+      return;
+    }
+    srvfailover(glob_drvsrv[drv]);
+    if (glob_drvsrv[drv] == first) return;
+  }
+}
+
+
+/* decompresses the srclen bytes of LZ data at src into dst (see protocol.txt
+ * for the format). returns the length of decompressed data, or 0xFFFF if src
+ * is malformed or would not fit in dstlen bytes */
+static unsigned short lzunpack(unsigned char far *dst, unsigned char *src, unsigned short srclen, unsigned short dstlen) {
+  unsigned short out = 0, n, back;
+  unsigned char *end = src + srclen;
+  while (src != end) {
+    if (*src < 0x80) { /* literal run of 1..128 bytes */
+      n = *src + 1;
+      src++;
+      if ((n > (unsigned short)(end - src)) || (n > dstlen - out)) return(0xFFFFu);
+      copybytes(dst + out, src, n);
+      src += n;
+      out += n;
+    } else { /* match of 3..130 bytes, followed by its backward distance */
+      if ((unsigned short)(end - src) < 3) return(0xFFFFu);
+      n = (*src & 0x7F) + 3;
+      back = src[1] | ((unsigned short)(src[2]) << 8);
+      src += 3;
+      if ((back == 0) || (back > out) || (n > dstlen - out)) return(0xFFFFu);
+      /* byte after byte, since the match may overlap with itself */
+      for (; n != 0; n--, out++) dst[out] = dst[out - back];
+    }
+  }
+  return(out);
+}
+
+
+/* compresses len bytes from src into dst (see protocol.txt for the format),
+ * looking for matches through a tiny hash table of 3-bytes sequences. This is
+ * greedy and simple rather than tight, an 8086 has no time to spare. Returns
+ * the length of compressed data, or 0 if it would not be shorter than maxlen
+ * (or if compression is disabled) */
+static unsigned short lzpack(unsigned char *dst, unsigned char far *src, unsigned short len, unsigned short maxlen) {
+  unsigned short pos = 0, out = 0, lit = 0, mlen, cand = 0;
+  unsigned char h;
+  if (glob_lzhash == NULL) return(0);
+  for (;;) {
+    /* look for an earlier occurrence of the next 3 bytes. the hash table
+     * is never cleared, stale entries simply do not match */
+    mlen = 0;
+    if (len - pos >= 3) {
+      h = (src[pos] << 4) ^ (src[pos + 1] << 2) ^ src[pos + 2];
+      cand = glob_lzhash[h];
+      glob_lzhash[h] = pos;
+      if (cand < pos) {
+        while ((pos + mlen < len) && (mlen < 130) && (src[cand + mlen] == src[pos + mlen])) mlen++;
+      }
+    }
+    /* emit the pending literal run if it cannot grow any more */
+    if ((lit != 0) && ((mlen >= 3) || (pos == len) || (lit == 128))) {
+      if (out + lit + 1 >= maxlen) return(0);
+      dst[out++] = lit - 1;
+      copybytes(dst + out, src + pos - lit, lit);
+      out += lit;
+      lit = 0;
+    }
+    if (pos == len) break;
+    if (mlen < 3) { /* no match - the byte joins the literal run */
+      lit++;
+      pos++;
+      continue;
+    }
+    if (out + 3 >= maxlen) return(0);
+    dst[out++] = 0x80 | (mlen - 3);
+    dst[out++] = (pos - cand) & 0xff;
+    dst[out++] = (pos - cand) >> 8;
+    pos += mlen;
+  }
+  return(out);
+}
+
+
+/* reads len bytes of the file identified by fileid at offset offs into dst.
+ * The read is split into chunks that fit in my eth frames, and up to
+ * READWINDOW such chunks are queried at the same time, each with its own
+ * seq, so the round-trip time is paid (more or less) only once per window
+ * instead of once per chunk. Answers can come back in any order, they are
+ * copied straight at the right place of dst. A chunk that times out
+ * is resent on its own, with the same backoff and patience as sendquery().
+ * returns the amount of bytes read, 0xFFFF on network error. On backend
+ * error 0xFFFE is returned and *errax is set to the server's AX value. */
+static unsigned short readfilwin(unsigned long offs, unsigned short fileid, unsigned char far *dst, unsigned short len, unsigned short *errax) {
+  struct {
+    unsigned char chunk; /* chunk id, 0xff if slot is free */
+    unsigned char seq;   /* seq of the query sent for this chunk */
+    unsigned short sent; /* pit_now() at the time the query was sent */
+    unsigned short rto;  /* timeout of the query */
+    unsigned short spent; /* sum of timeouts that expired already */
+  } slot[READWINDOW];
+  unsigned char nextchunk = 0, lastchunk, busy = 0, i;
+  unsigned char directchunk = 0xff; /* chunk the direct receive target points at */
+  unsigned short lastlen; /* length of data in the last chunk */
+  unsigned char *buff = glob_pktdrv_sndbuff + 60;
+  unsigned short chunksz = glob_framesize - 60; /* amount of data per chunk */
+  unsigned char zflag = 0;
+  unsigned char srv = glob_drvsrv[glob_reqdrv];
+
+  /* if compression has been negotiated, answers may come compressed, and
+   * they start with a byte that tells whether they are */
+  if ((glob_srvcaps & CAP_COMPRESS) != 0) {
+    zflag = DFLAG_ZANSWER;
+    chunksz--;
+  }
+
+  /* compute the amount of chunks (and length of the last one) */
+  lastchunk = (len - 1) / chunksz;
+  lastlen = len - ((unsigned short)lastchunk * chunksz);
+
+  for (i = 0; i < READWINDOW; i++) slot[i].chunk = 0xff;
+  selectsrv(glob_reqdrv);
+  glob_pktdrv_sndbuff[58] = glob_data.ldrv[glob_reqdrv] | zflag;
+  glob_pktdrv_sndbuff[59] = AL_READFIL;
+  glob_rxseqlo = glob_seq + 1;
+  glob_rxanysrc = 0;
+  rxflush(); /* drop any stale frame */
+
+  for (;;) {
+    /* send a query for every free slot (as long as there are chunks left to
+     * ask for), and resend the ones that got no answer in time */
+    for (i = 0; i < READWINDOW; i++) {
+      if (slot[i].chunk == 0xff) {
+        if (nextchunk > lastchunk) continue;
+        slot[i].chunk = nextchunk++;
+        slot[i].seq = ++glob_seq;
+        slot[i].rto = glob_rto[srv];
+        slot[i].spent = 0;
+        busy++;
+      } else if ((unsigned short)(pit_now() - slot[i].sent) < slot[i].rto) {
+        continue; /* still waiting for an answer */
+      } else { /* timeout */
+        slot[i].spent += slot[i].rto;
+        if (slot[i].spent >= QUERYPATIENCE) { /* out of patience */
+          glob_stats.timeouts++;
+          glob_directlen = 0;
+          srvfailover(glob_drvsrv[glob_reqdrv]);
+          return(0xFFFFu);
+        }
+        slot[i].rto = rtobackoff(srv, slot[i].rto);
+      }
+      /* query is OOOOSSLL (offset, start sector, lenght to read) */
+      ((unsigned long *)buff)[0] = offs + ((unsigned long)(slot[i].chunk) * chunksz);
+      ((unsigned short *)buff)[2] = fileid;
+      ((unsigned short *)buff)[3] = (slot[i].chunk == lastchunk)?lastlen:chunksz;
+      glob_pktdrv_sndbuff[57] = slot[i].seq;
+      pktdrv_send(60 + 8);
+      slot[i].sent = pit_now();
+    }
+    /* nothing left in flight? then I'm done */
+    if (busy == 0) break;
+
+    /* let the answer to the lowest chunk I wait for land straight in the DTA
+     * (the target can change only while no frame waits in the ring). This
+     * is pointless if the answer might be compressed */
+    if ((zflag == 0) && (glob_directlen == 0) && (glob_rxtail->len == 0)) {
+      directchunk = 0xff;
+      for (i = 0; i < READWINDOW; i++) {
+        if (slot[i].chunk < directchunk) directchunk = slot[i].chunk;
+      }
+      directrecv(dst + ((unsigned short)directchunk * chunksz), (directchunk == lastchunk)?lastlen:chunksz, 60);
+    }
+
+    /* do I have an answer? */
+    if (glob_rxtail->len < 1) continue;
+    /* find the chunk the answer relates to */
+    for (i = 0; i < READWINDOW; i++) {
+      if ((slot[i].chunk != 0xff) && (slot[i].seq == glob_pktdrv_recvbuff[57])) break;
+    }
+    if (i == READWINDOW) goto ignoreframe; /* stale or duplicated answer */
+    if (slot[i].spent == 0) rttsample(srv, pit_now() - slot[i].sent);
+    if (((unsigned short *)glob_pktdrv_recvbuff)[29] != 0) { /* backend error */
+      glob_directlen = 0;
+      *errax = ((unsigned short *)glob_pktdrv_recvbuff)[29];
+      return(0xFFFEu);
+    }
+    {
+      unsigned short anslen, explen;
+      unsigned char far *chunkptr;
+      anslen = glob_rxtail->len - 60;
+      explen = (slot[i].chunk == lastchunk)?lastlen:chunksz;
+      chunkptr = dst + ((unsigned short)(slot[i].chunk) * chunksz);
+      if (zflag != 0) { /* answer is Fddd... (F = 1 if ddd... is compressed) */
+        if (anslen != 0) anslen--;
+        if ((anslen != 0) && (glob_pktdrv_recvbuff[60] != 0)) {
+          anslen = lzunpack(chunkptr, glob_pktdrv_recvbuff + 61, anslen, explen);
+          if (anslen == 0xFFFFu) goto ignoreframe; /* garbage, wait for a resend */
+        } else {
+          if (anslen > explen) anslen = explen;
+          copybytes(chunkptr, glob_pktdrv_recvbuff + 61, anslen);
+        }
+      } else {
+        if (anslen > explen) anslen = explen;
+        /* copy data to the DTA, unless it landed at the right place already */
+        if (glob_rxtail->hit == 0) {
+          copybytes(chunkptr, glob_pktdrv_recvbuff + 60, anslen);
+        } else if (slot[i].chunk != directchunk) {
+          copybytes(chunkptr, MK_FP(glob_directseg, glob_directoff), anslen);
+        }
+      }
+      /* a short answer means EOF: chunks past this one are of no interest */
+      if (anslen < explen) {
+        lastchunk = slot[i].chunk;
+        lastlen = anslen;
+      }
+    }
+    slot[i].chunk = 0xff;
+    busy--;
+    /* forget about queries that relate to data past EOF, if any */
+    for (i = 0; i < READWINDOW; i++) {
+      if ((slot[i].chunk == 0xff) || (slot[i].chunk <= lastchunk)) continue;
+      slot[i].chunk = 0xff;
+      busy--;
+    }
+    ignoreframe:
+    glob_directlen = 0; /* the lowest chunk I wait for might have changed */
+    rxrelease();
+  }
+  return(((unsigned short)lastchunk * chunksz) + lastlen);
+}
+
+
+/* reads len bytes of the file identified by fileid at offset offs into dst
+ * using a single READBULK query. The server answers with a stream of numbered
+ * fragments (glob_framesize - 62 bytes each, except the last one) that are
+ * copied to their place in dst as they come. When fragments stop coming
+ * before all of them made it, the query is resent with a bitmap of the
+ * fragments that are still missing (with the same backoff and patience as
+ * sendquery()). len must not exceed 64 fragments (see READBULKMAX). Returns
+ * the amount of bytes read, 0xFFFF on network error. On backend error 0xFFFE
+ * is returned and *errax is set to the server's AX. */
+static unsigned short readbulk(unsigned long offs, unsigned short fileid, unsigned char far *dst, unsigned short len, unsigned short *errax) {
+  unsigned char want[8]; /* bitmap of fragments I still wait for */
+  unsigned char fragcount, firstseq, i;
+  unsigned char directfrag = 0; /* fragment the direct receive target points at */
+  unsigned char srv = glob_drvsrv[glob_reqdrv];
+  unsigned short lastfraglen = 0, t, rto = glob_rto[srv], spent = 0;
+  unsigned char *buff = glob_pktdrv_sndbuff + 60;
+
+  fragcount = ((len - 1) / (glob_framesize - 62)) + 1;
+  for (i = 0; i < 8; i++) want[i] = 0;
+  for (i = 0; i < fragcount; i++) want[i >> 3] |= (1 << (i & 7));
+  firstseq = glob_seq + 1;
+  selectsrv(glob_reqdrv);
+  glob_pktdrv_sndbuff[58] = glob_data.ldrv[glob_reqdrv];
+  glob_pktdrv_sndbuff[59] = EXT_READBULK;
+  /* accept fragments that answer to any of the queries I will send, as long
+   * as they come from the right server */
+  glob_rxseqlo = firstseq;
+  glob_rxanysrc = 0;
+  rxflush(); /* drop any stale frame */
+
+  for (;;) {
+    /* query is OOOOSSLLFFMMMMMMMM (offset, start sector, length to read,
+     * fragment size, bitmap of fragments I want) */
+    ((unsigned long *)buff)[0] = offs;
+    ((unsigned short *)buff)[2] = fileid;
+    ((unsigned short *)buff)[3] = len;
+    ((unsigned short *)buff)[4] = glob_framesize - 62;
+    for (i = 0; i < 8; i++) buff[10 + i] = want[i];
+    glob_pktdrv_sndbuff[57] = ++glob_seq;
+    pktdrv_send(60 + 18);
+
+    /* collect fragments, until they stop coming for longer than rto */
+    t = pit_now();
+    for (;;) {
+      unsigned short fraglen, explen;
+      unsigned char fragid;
+      if ((unsigned short)(pit_now() - t) >= rto) break; /* timeout */
+      /* let the lowest fragment I wait for land straight in the DTA (the
+       * target can change only while no frame waits in the ring) */
+      if ((glob_directlen == 0) && (glob_rxtail->len == 0)) {
+        for (directfrag = 0; (want[directfrag >> 3] & (1 << (directfrag & 7))) == 0; directfrag++);
+        fraglen = len - ((unsigned short)directfrag * (glob_framesize - 62));
+        if (fraglen > glob_framesize - 62) fraglen = glob_framesize - 62;
+        directrecv(dst + ((unsigned short)directfrag * (glob_framesize - 62)), fraglen, 62);
+      }
+      if (glob_rxtail->len < 1) continue;
+      if (((unsigned short *)glob_pktdrv_recvbuff)[29] != 0) { /* backend error */
+        glob_directlen = 0;
+        *errax = ((unsigned short *)glob_pktdrv_recvbuff)[29];
+        return(0xFFFEu);
+      }
+      if (glob_rxtail->len < 62) goto ignoreframe;
+      /* answer is IN (fragment id, total amount of fragments) + data */
+      fragid = glob_pktdrv_recvbuff[60];
+      fraglen = glob_rxtail->len - 62;
+      /* less fragments than I expected means EOF */
+      if (glob_pktdrv_recvbuff[61] < fragcount) {
+        if (glob_pktdrv_recvbuff[61] == 0) goto ignoreframe; /* nonsense */
+        fragcount = glob_pktdrv_recvbuff[61];
+        for (i = fragcount; i < 64; i++) want[i >> 3] &= ~(1 << (i & 7));
+      }
+      if ((fragid >= fragcount) || ((want[fragid >> 3] & (1 << (fragid & 7))) == 0)) goto ignoreframe;
+      /* never more than what is left of len at this fragment's place */
+      explen = len - ((unsigned short)fragid * (glob_framesize - 62));
+      if (explen > glob_framesize - 62) explen = glob_framesize - 62;
+      if (fraglen > explen) fraglen = explen;
+      if (fragid == fragcount - 1) lastfraglen = fraglen;
+      /* copy data to the DTA, unless it landed at the right place already */
+      if (glob_rxtail->hit == 0) {
+        copybytes(dst + ((unsigned short)fragid * (glob_framesize - 62)), glob_pktdrv_recvbuff + 62, fraglen);
+      } else if (fragid != directfrag) {
+        copybytes(dst + ((unsigned short)fragid * (glob_framesize - 62)), MK_FP(glob_directseg, glob_directoff), fraglen);
+      }
+      want[fragid >> 3] &= ~(1 << (fragid & 7));
+      t = pit_now(); /* got something new, restart the timeout */
+      ignoreframe:
+      glob_directlen = 0; /* the lowest fragment I wait for might have changed */
+      rxrelease();
+      /* do I have everything? */
+      for (i = 0; (i < 8) && (want[i] == 0); i++);
+      if (i == 8) {
+        unsigned long res = ((unsigned long)(fragcount - 1) * (glob_framesize - 62)) + lastfraglen;
+        if (res > len) res = len;
+        return((unsigned short)res);
+      }
+    }
+    /* some fragments are missing - ask again for these only */
+    spent += rto;
+    if (spent >= QUERYPATIENCE) {
+      glob_stats.timeouts++;
+      glob_directlen = 0;
+      srvfailover(glob_drvsrv[glob_reqdrv]);
+      return(0xFFFFu);
+    }
+    rto = rtobackoff(srv, rto);
+  }
+}
+
+
+/* reads len bytes of the file identified by fileid at offset offs into dst,
+ * in a single bulk query if the server supports it (and the request fits in
+ * 64 fragments), otherwise through a window of multiple queries so chunks
+ * can fit in my eth frames without paying a full round-trip for every one.
+ * returns the same as readfilwin() and readbulk() */
+static unsigned short readfil(unsigned long offs, unsigned short fileid, unsigned char far *dst, unsigned short len, unsigned short *errax) {
+  /* READBULK fragments are never compressed, so when compression has been
+   * negotiated the window of READFIL queries is a better deal */
+  unsigned short res, t = pit_now();
+  if (((glob_srvcaps & (CAP_READBULK | CAP_COMPRESS)) == CAP_READBULK) && (len <= READBULKMAX)) {
+    res = readbulk(offs, fileid, dst, len, errax);
+  } else {
+    res = readfilwin(offs, fileid, dst, len, errax);
+  }
+  glob_netwait += pit_now() - t;
+  return(res);
+}
+
+
+/* returns the read-ahead entry of the file fileid on local drive drv, or
+ * NULL if there is none */
+static struct racache *rafind(unsigned char drv, unsigned short fileid) {
+  struct racache *ra;
+  for (ra = glob_racache; ra != glob_raend; ra++) {
+    if ((ra->drive == drv) && (ra->fileid == fileid)) return(ra);
+  }
+  return(NULL);
+}
+
+
+/* forgets whatever is read-ahead for the file fileid on local drive drv */
+static void radrop(unsigned char drv, unsigned short fileid) {
+  struct racache *ra = rafind(drv, fileid);
+  if (ra != NULL) ra->drive = 0xff;
+}
+
+
+/* copies to dst as much as possible of the len bytes at offset offs that
+ * the read-ahead entry ra holds, and returns the amount of bytes copied */
+static unsigned short raget(struct racache *ra, unsigned long offs, unsigned char far *dst, unsigned short len) {
+  unsigned long skip;
+  if (offs < ra->offs) return(0);
+  skip = offs - ra->offs;
+  if (skip >= ra->len) return(0);
+  if (len > ra->len - (unsigned short)skip) len = ra->len - (unsigned short)skip;
+  copybytes(dst, ra->buff + (unsigned short)skip, len);
+  ra->stamp = ++glob_rastamp;
+  return(len);
+}
+
+
+/* writes len bytes from src to the file identified by fileid on local drive
+ * drv at offset offs, using a single window of WRITESTREAM frames (len must
+ * not be bigger than WRITEWINDOW * (glob_framesize - 69)). All frames are
+ * sent in a burst, only the last one asks the server for an acknowledgment.
+ * The server answers with a bitmap of frames it got and the end of the
+ * contiguous data it wrote, so I resend only the frames that went missing.
+ * Rounds that go unanswered and rounds answered without any progress both
+ * eat into QUERYPATIENCE, like the retries of any other query. Returns the
+ * amount of bytes written contiguously from offs, and sets *errcode to the
+ * DOS error code to report (0 on success). */
+static unsigned short writefilwin(unsigned char drv, unsigned long offs, unsigned short fileid, unsigned char far *src, unsigned short len, unsigned short *errcode) {
+  static unsigned char winid;
+  unsigned short allmask, pending, mask, flen, zlen;
+  unsigned long written = 0;
+  unsigned short t, rto = glob_rto[glob_drvsrv[drv]], spent = 0;
+  unsigned char n, i, last, gotack;
+  unsigned char *buff = glob_pktdrv_sndbuff + 60;
+
+  n = ((len - 1) / (glob_framesize - 69)) + 1;
+  allmask = 0xFFFFu >> (16 - n);
+  pending = allmask;
+  winid++;
+  *errcode = 0;
+  selectsrv(drv);
+  glob_pktdrv_sndbuff[59] = EXT_WRITESTREAM;
+  glob_rxseqlo = glob_seq + 1;
+  glob_rxanysrc = 0;
+
+  for (;;) {
+    /* find the last pending frame, that's the one that will ask for an ack */
+    for (last = n - 1; (pending & (1 << last)) == 0; last--);
+    /* send all pending frames out */
+    rxflush(); /* drop any stale frame */
+    for (i = 0; i <= last; i++) {
+      if ((pending & (1 << i)) == 0) continue;
+      flen = (i == n - 1)?(len - ((unsigned short)i * (glob_framesize - 69))):(glob_framesize - 69);
+      /* query is OOOOSSWIF (offset, start sector, window id, frame index within
+       * window, flags) followed by data */
+      ((unsigned long *)buff)[0] = offs + ((unsigned short)i * (glob_framesize - 69));
+      ((unsigned short *)buff)[2] = fileid;
+      buff[6] = winid;
+      buff[7] = i;
+      buff[8] = (i == last)?1:0; /* flag 1 = 'ack requested' */
+      /* data goes compressed if that makes it any shorter */
+      glob_pktdrv_sndbuff[58] = glob_data.ldrv[drv];
+      zlen = lzpack(buff + 9, src + ((unsigned short)i * (glob_framesize - 69)), flen, flen);
+      if (zlen != 0) {
+        glob_pktdrv_sndbuff[58] |= DFLAG_ZDATA;
+        flen = zlen;
+      } else {
+        copybytes(buff + 9, src + ((unsigned short)i * (glob_framesize - 69)), flen);
+      }
+      glob_pktdrv_sndbuff[57] = ++glob_seq;
+      pktdrv_send(60 + 9 + flen);
+    }
+    /* wait for the ack */
+    t = pit_now();
+    for (gotack = 0;;) {
+      if ((unsigned short)(pit_now() - t) >= rto) break; /* timeout */
+      if (glob_rxtail->len < 1) continue;
+      if (glob_pktdrv_recvbuff[57] == glob_seq) {
+        gotack = 1;
+        break;
+      }
+      rxrelease(); /* ignore this frame and wait for the next one */
+    }
+    if (gotack != 0) {
+      /* a backend error comes with AX alone, no MMLLLL behind it */
+      if (((unsigned short *)glob_pktdrv_recvbuff)[29] != 0) {
+        *errcode = ((unsigned short *)glob_pktdrv_recvbuff)[29];
+        return((unsigned short)written);
+      }
+      if (glob_rxtail->len < 66) goto noprogress; /* truncated answer */
+      /* answer is MMLLLL (bitmap of frames written, end of the contiguous
+       * data written since the first frame of the window) */
+      mask = ((unsigned short *)glob_pktdrv_recvbuff)[30];
+      if ((mask & 1) != 0) { /* first frame went through */
+        written = *((unsigned long *)(glob_pktdrv_recvbuff + 62)) - offs;
+        if (written > len) written = len;
+      }
+      mask = allmask & ~mask;
+      if (mask != pending) { /* progress made */
+        pending = mask;
+        if (pending == 0) return((unsigned short)written);
+        continue;
+      }
+    }
+    noprogress:
+    /* no answer, or no progress: either way this round is a retry */
+    spent += rto;
+    if (spent >= QUERYPATIENCE) {
+      glob_stats.timeouts++;
+      if (gotack == 0) srvfailover(glob_drvsrv[drv]);
+      *errcode = 2;
+      return((unsigned short)written);
+    }
+    rto = rtobackoff(glob_drvsrv[drv], rto);
+    if (gotack == 0) pending = 1 << last; /* resend the ack frame only */
+  }
+}
+
+
+/* writes len bytes from src to the file identified by fileid on local drive
+ * drv at offset offs, in as many queries as needed: WRITESTREAM windows if
+ * the server supports them, classic WRITEFIL queries otherwise. Returns the
+ * amount of bytes written, and sets *errcode to the DOS error code to report
+ * (0 on success). */
+static unsigned short writefil(unsigned char drv, unsigned long offs, unsigned short fileid, unsigned char far *src, unsigned short len, unsigned short *errcode) {
+  unsigned short chunklen, l, t, written = 0;
+  unsigned short *ax;
+  unsigned char *answer;
+  unsigned char *buff = glob_pktdrv_sndbuff + 60;
+  *errcode = 0;
+  while (written < len) {
+    chunklen = len - written;
+    if (((glob_srvcaps & CAP_WRITESTREAM) != 0) && (chunklen > glob_framesize - 66)) {
+      /* (tested through a division, the product may not fit in 16 bits) */
+      if (chunklen / WRITEWINDOW >= glob_framesize - 69) chunklen = WRITEWINDOW * (glob_framesize - 69);
+      t = pit_now();
+      l = writefilwin(drv, offs + written, fileid, src + written, chunklen, errcode);
+      glob_netwait += pit_now() - t;
+    } else {
+      if (chunklen > glob_framesize - 66) chunklen = glob_framesize - 66;
+      /* query is OOOOSS (file offset, start sector/fileid) */
+      ((unsigned long *)buff)[0] = offs + written;
+      ((unsigned short *)buff)[2] = fileid;
+      /* data goes compressed if that makes it any shorter */
+      l = lzpack(buff + 6, src + written, chunklen, chunklen);
+      if (l != 0) {
+        l = sendquery(AL_WRITEFIL, drv | DFLAG_ZDATA, l + 6, &answer, &ax, SQ_OPENFILE);
+      } else {
+        copybytes(buff + 6, src + written, chunklen);
+        l = sendquery(AL_WRITEFIL, drv, chunklen + 6, &answer, &ax, SQ_OPENFILE);
+      }
+      if (l == 0xFFFFu) { /* network error */
+        *errcode = 2;
+        break;
+      } else if ((*ax != 0) || (l != 2)) { /* backend error */
+        *errcode = *ax;
+        break;
+      }
+      l = ((unsigned short *)answer)[0];
+    }
+    written += l;
+    if (*errcode != 0) break;
+    if (l != chunklen) break; /* something bad happened on the other side */
+  }
+  return(written);
+}
+
+
+/* returns the current value of the BIOS tick counter (low word) */
+#ifndef HOSTBUILD
+static unsigned short biostick(void) {
+  return(*((unsigned short volatile far *)MK_FP(0, 0x46C)));
+}
+#endif
+
+
+/* returns the write-back entry of the file fileid on local drive drv, or
+ * NULL if there is none */
+static struct wbcache *wbfind(unsigned char drv, unsigned short fileid) {
+  struct wbcache *wb;
+  for (wb = glob_wbcache; wb != glob_wbend; wb++) {
+    if ((wb->drive == drv) && (wb->fileid == fileid)) return(wb);
+  }
+  return(NULL);
+}
+
+
+/* sends whatever waits in the write-back entry wb to the server. The
+ * application has been told already that this data is written, so a failure
+ * can only be remembered in wb->err, to be reported at the next occasion.
+ * returns wb->err */
+static unsigned short wbflush(struct wbcache *wb) {
+  unsigned short errcode;
+  if (wb->len == 0) return(wb->err);
+  if ((writefil(wb->drive, wb->offs, wb->fileid, wb->buff, wb->len, &errcode) != wb->len) && (errcode == 0)) {
+    errcode = 29; /* "write fault" */
+  }
+  wb->len = 0;
+  if (errcode != 0) wb->err = errcode;
+  return(wb->err);
+}
+
+
+/* flushes the write-back entry of the file fileid on local drive drv (if
+ * any), and forgets about it if release is non-zero. Returns the error of a
+ * delayed write, if any - it is returned only once. */
+static unsigned short wbsync(unsigned char drv, unsigned short fileid, unsigned char release) {
+  struct wbcache *wb = wbfind(drv, fileid);
+  unsigned short err;
+  if (wb == NULL) return(0);
+  err = wbflush(wb);
+  wb->err = 0;
+  if (release != 0) wb->drive = 0xff;
+  return(err);
+}
+
+
+/* flushes all write-back entries, or only these that hold data for WBIDLE
+ * ticks at least if idleonly is non-zero. errors are kept by each entry for
+ * its own file. */
+static void wbflushall(unsigned char idleonly) {
+  struct wbcache *wb;
+  unsigned short now = biostick();
+  glob_wbdirty = 0;
+  for (wb = glob_wbcache; wb != glob_wbend; wb++) {
+    if (wb->len == 0) continue;
+    if ((idleonly != 0) && ((unsigned short)(now - wb->tick) < WBIDLE)) {
+      glob_wbdirty = 1; /* not old enough yet */
+      continue;
+    }
+    wbflush(wb);
+  }
+}
+
+
+/* returns a free write-back entry for the file fileid on local drive drv:
+ * an unused one, or the least recently used one once flushed. Returns NULL
+ * if there are no entries at all, or if the flush failed (the entry is kept
+ * then, so its error gets reported for the file it relates to). */
+static struct wbcache *wbget(unsigned char drv, unsigned short fileid) {
+  struct wbcache *wb, *w;
+  if (glob_wbcache == glob_wbend) return(NULL);
+  wb = glob_wbcache;
+  for (w = glob_wbcache; w != glob_wbend; w++) {
+    if (w->drive == 0xff) {
+      wb = w;
+      break;
+    }
+    if ((unsigned short)(glob_wbstamp - w->stamp) > (unsigned short)(glob_wbstamp - wb->stamp)) wb = w;
+  }
+  if ((wb->drive != 0xff) && (wbflush(wb) != 0)) return(NULL);
+  wb->drive = drv;
+  wb->fileid = fileid;
+  wb->len = 0;
+  wb->err = 0;
+  return(wb);
+}
+
+
+/* looks in the directory cache for the entry that follows the one the
+ * FindNext search data dta (on local drive drv) points to. Returns a pointer
+ * to it (in the format of a FINDFIRST answer), or NULL if the cache does not
+ * have it - *nomore is set to 1 then if the cache knows that there are no
+ * more entries at all. */
+static unsigned char *dirget(struct sdbstruct far *dta, unsigned char drv, unsigned char *nomore) {
+  unsigned char *res;
+  int i;
+  *nomore = 0;
+  if ((glob_dircache.drive != drv) || (glob_dircache.par_clstr != dta->par_clstr) || (glob_dircache.dir_entry != dta->dir_entry) || (glob_dircache.srch_attr != dta->srch_attr)) return(NULL);
+  for (i = 0; i < 11; i++) {
+    if (glob_dircache.srch_tmpl[i] != dta->srch_tmpl[i]) return(NULL);
+  }
+  if (glob_dircache.count == 0) {
+    *nomore = glob_dircache.eod;
+    return(NULL);
+  }
+  res = glob_dircache.next;
+  glob_dircache.next += 24;
+  glob_dircache.count--;
+  return(res);
+}
+
+
+/* returns non-zero if the metadata cache entry md relates to path (a NULL
+ * path matches entries that relate to no path) */
+static int mdsamepath(struct mdcache *md, unsigned char far *path) {
+  int i;
+  if (path == NULL) return(md->path[0] == 0);
+  for (i = 0; (md->path[i] == path[i]) && (path[i] != 0); i++);
+  return(md->path[i] == path[i]);
+}
+
+
+/* returns the metadata cache entry with the result of the query type for
+ * path (drive excluded, NULL if the query takes no path) on local drive drv,
+ * or NULL if there is none, or if it is older than glob_mdttl (glob_negttl
+ * for negative results) */
+static struct mdcache *mdfind(unsigned char drv, unsigned char type, unsigned char far *path) {
+  struct mdcache *md;
+  unsigned short now = biostick();
+  for (md = glob_mdcache; md != glob_mdend; md++) {
+    if ((md->drive != drv) || (md->type != type)) continue;
+    if (mdsamepath(md, path) == 0) continue;
+    if ((unsigned short)(now - md->tick) >= (((type & MDNEG) != 0)?glob_negttl:glob_mdttl)) {
+      md->drive = 0xff; /* expired */
+      return(NULL);
+    }
+    md->stamp = ++glob_mdstamp;
+    return(md);
+  }
+  return(NULL);
+}
+
+
+/* returns a metadata cache entry for the result of the query type for path
+ * on local drive drv (the least recently used one is recycled if needed).
+ * the caller fills its data. returns NULL if path is too long to be kept */
+static struct mdcache *mdnew(unsigned char drv, unsigned char type, unsigned char far *path) {
+  struct mdcache *md, *m;
+  unsigned short len = 0;
+  if (path != NULL) len = mystrlen(path);
+  if ((glob_mdcache == glob_mdend) || (len >= MDPATHMAX)) return(NULL);
+  md = glob_mdcache;
+  for (m = glob_mdcache; m != glob_mdend; m++) {
+    if (m->drive == 0xff) {
+      md = m;
+      break;
+    }
+    if ((unsigned short)(glob_mdstamp - m->stamp) > (unsigned short)(glob_mdstamp - md->stamp)) md = m;
+  }
+  md->drive = drv;
+  md->type = type;
+  md->tick = biostick();
+  md->stamp = ++glob_mdstamp;
+  md->path[0] = 0;
+  if (path != NULL) copybytes(md->path, path, len + 1);
+  return(md);
+}
+
+
+/* forgets cached metadata of path (drive excluded) on local drive drv, along
+ * with the drive's free space and all negative results of the drive (a new
+ * file or directory makes a whole subtree appear). a NULL path, or a path
+ * with wildcards, means everything that is known about the drive */
+static void mdinval(unsigned char drv, unsigned char far *path) {
+  struct mdcache *md;
+  if ((path != NULL) && (len_if_no_wildcards((char far *)path) < 0)) path = NULL;
+  for (md = glob_mdcache; md != glob_mdend; md++) {
+    if (md->drive != drv) continue;
+    if ((path != NULL) && (md->type != AL_DISKSPACE) && ((md->type & MDNEG) == 0) && (mdsamepath(md, path) == 0)) continue;
+    md->drive = 0xff;
+  }
+}
+
+
+/* forgets the free space of local drive drv and the attributes of its files,
+ * that a write may change. what exists and where it is stays true */
+static void mdinvalwrite(unsigned char drv) {
+  struct mdcache *md;
+  for (md = glob_mdcache; md != glob_mdend; md++) {
+    if ((md->drive == drv) && ((md->type == AL_DISKSPACE) || (md->type == AL_GETATTR))) md->drive = 0xff;
+  }
+}
+
+
+/* returns the error code that the query type for path (drive excluded) on
+ * local drive drv ended with recently, if it was "file not found" or "path
+ * not found". attr are the search attributes of a FINDFIRST (0 for other
+ * queries). returns 0 if no such failure is known. */
+static unsigned short negfind(unsigned char drv, unsigned char type, unsigned char attr, unsigned char far *path) {
+  struct mdcache *md = mdfind(drv, type | MDNEG, path);
+  if ((md == NULL) || (md->data[2] != attr)) return(0);
+  return(((unsigned short *)md->data)[0]);
+}
+
+
+/* remembers that the query type for path on local drive drv (with search
+ * attributes attr) failed with error err - if it is 2 ("file not found") or
+ * 3 ("path not found"), so it can be answered by negfind() for a short
+ * while */
+static void negnew(unsigned char drv, unsigned char type, unsigned char attr, unsigned char far *path, unsigned short err) {
+  struct mdcache *md;
+  if ((err != 2) && (err != 3)) return;
+  md = mdfind(drv, type | MDNEG, path);
+  if (md == NULL) md = mdnew(drv, type | MDNEG, path);
+  if (md == NULL) return;
+  md->tick = biostick();
+  ((unsigned short *)md->data)[0] = err;
+  md->data[2] = attr;
+}
+
+
+/* reset CF (set on error only) and AX (expected to contain the error code,
+ * I might set it later) - I assume a success */
+#define SUCCESSFLAG glob_intregs.w.ax = 0; glob_intregs.w.flags &= ~(INTR_CF);
+#define FAILFLAG(x) {glob_intregs.w.ax = x; glob_intregs.w.flags |= INTR_CF;}
+
+/* adds a call of subfunction al that took t pit_now() units, net of which
+ * were spent on the network, to the latency histograms */
+static void histadd(unsigned char al, unsigned short t, unsigned short net) {
+  unsigned char b;
+  unsigned short v;
+  if (net > t) net = t;
+  for (b = 0, v = net; (v != 0) && (b < MPXHISTBUCKETS - 1); b++) v >>= 1;
+  glob_hist[al].net[b]++;
+  for (b = 0, v = t - net; (v != 0) && (b < MPXHISTBUCKETS - 1); b++) v >>= 1;
+  glob_hist[al].local[b]++;
+}
+
+/* fills the next record of the trace ring with what is known about the
+ * current call before it is processed, returns a pointer to the record or
+ * NULL if calls are not being traced */
+static struct mpxtrace far *tracebegin(unsigned short calltime) {
+  struct mpxtracehdr far *hdr;
+  struct mpxtrace far *tr;
+  struct sftstruct far *sft;
+  unsigned char al = glob_intregs.h.al;
+  unsigned short i;
+  if (glob_tracexms != NULL) { /* recorded in DS first, moved to XMS later */
+    hdr = &(glob_tracexms->hdr);
+    tr = &(glob_tracexms->rec);
+  } else if (glob_traceseg != 0) {
+    hdr = MK_FP(glob_traceseg, 0);
+    tr = MK_FP(glob_traceseg, sizeof(struct mpxtracehdr) + (hdr->next * sizeof(struct mpxtrace)));
+  } else {
+    return(NULL);
+  }
+  if (hdr->paused != 0) return(NULL);
+  tr->al = al;
+  tr->drive = glob_reqdrv;
+  tr->flags = 0;
+  tr->reserved = 0;
+  tr->tick = biostick();
+  tr->start = calltime;
+  tr->cx = glob_intregs.x.cx;
+  tr->file = 0xffffu;
+  tr->pos = 0;
+  tr->arg[0] = 0;
+  tr->arg[1] = 0;
+  tr->arg[2] = 0;
+  for (i = 0; i < MPXTRACEPATH; i++) tr->path[i] = 0;
+  if (((al >= AL_CLSFIL) && (al <= AL_UNLOCKFIL)) || (al == AL_SKFMEND) || (al == AL_UNKNOWN_2D)) {
+    sft = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
+    tr->file = sft->start_sector;
+    tr->pos = sft->file_pos;
+    if (al == AL_SKFMEND) tr->arg[0] = glob_intregs.x.dx;
+    return(tr);
+  }
+  if ((al == AL_DISKSPACE) || (al == AL_FINDNEXT)) return(tr);
+  switch (al) {
+    case AL_SPOPNFIL:
+      tr->arg[1] = glob_sdaptr->spop_act;
+      tr->arg[2] = glob_sdaptr->spop_mode;
+      /* FALLTHRU */
+    case AL_SETATTR:
+    case AL_OPEN:
+    case AL_CREATE:
+      tr->arg[0] = glob_reqstkword;
+      break;
+    case AL_FINDFIRST:
+      tr->arg[0] = glob_sdaptr->srch_attr;
+      break;
+  }
+  for (i = 0; (i < MPXTRACEPATH) && (glob_sdaptr->fn1[i + 2] != 0); i++) tr->path[i] = glob_sdaptr->fn1[i + 2];
+  if (glob_sdaptr->fn1[i + 2] != 0) tr->flags = MPXTRACE_TRUNC;
+  return(tr);
+}
+
+/* moves the record of the current call into its place of the trace ring in
+ * XMS (glob_tracexms->hdr.next) */
+#ifndef HOSTBUILD
+static void tracexmsput(void) {
+  struct xmsmove *mv = &(glob_tracexms->mv);
+  unsigned long entry = glob_tracexms->entry;
+  mv->len = sizeof(struct mpxtrace);
+  mv->srchandle = 0;
+  mv->srcoff = ((unsigned long)FP_SEG((void far *)mv) << 16) | FP_OFF(&(glob_tracexms->rec));
+  mv->dsthandle = glob_tracexms->hdr.xms;
+  mv->dstoff = (unsigned long)glob_tracexms->hdr.next * sizeof(struct mpxtrace);
+  _asm {
+    push ax
+    push bx
+    push si
+    mov ah, 0Bh  /* XMS: move extended memory block (DS:SI = struct xmsmove) */
+    mov si, mv
+    call dword ptr entry
+    pop si
+    pop bx
+    pop ax
+  }
+}
+#endif
+
+/* completes the trace record tr with the outcome of the current call, and
+ * moves on to the next record of the ring */
+static void traceend(struct mpxtrace far *tr, unsigned short calltime) {
+  struct mpxtracehdr far *hdr;
+  if (glob_tracexms != NULL) {
+    hdr = &(glob_tracexms->hdr);
+  } else {
+    hdr = MK_FP(glob_traceseg, 0);
+  }
+  tr->time = pit_now() - calltime;
+  tr->ax = glob_intregs.w.ax;
+  if ((glob_intregs.w.flags & INTR_CF) != 0) {
+    tr->flags |= MPXTRACE_FAIL;
+  } else if ((tr->al == AL_OPEN) || (tr->al == AL_CREATE) || (tr->al == AL_SPOPNFIL)) {
+    tr->file = ((struct sftstruct far *)MK_FP(glob_intregs.x.es, glob_intregs.x.di))->start_sector;
+  }
+  if (glob_tracexms != NULL) tracexmsput();
+  hdr->next++;
+  if (hdr->next == hdr->max) hdr->next = 0;
+  hdr->total++;
+}
+
+/* this function contains the logic behind INT 2F processing */
+void process2f(void) {
+#if DEBUGLEVEL > 0
+  char far *dbg_msg = NULL;
+#endif
+  short i;
+  unsigned char *answer;
+  unsigned char *buff; /* pointer to the "query arguments" part of glob_pktdrv_sndbuff */
+  unsigned char subfunction;
+  unsigned short *ax; /* used to collect the resulting value of AX */
+  unsigned short calltime = pit_now();
+  struct mpxtrace far *tr;
+  buff = glob_pktdrv_sndbuff + 60;
+  glob_netwait = 0;
+
+  /* DEBUG output (RED) */
+#if DEBUGLEVEL > 0
+  dbg_xpos &= 511;
+  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x4e00 | ' ';
+  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x4e00 | (dbg_hexc[(glob_intregs.h.al >> 4) & 0xf]);
+  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x4e00 | (dbg_hexc[glob_intregs.h.al & 0xf]);
+  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x4e00 | ' ';
+#endif
+
+  /* remember the AL register (0x2F subfunction id) */
+  subfunction = glob_intregs.h.al;
+  glob_stats.calls[subfunction]++;
+  tr = tracebegin(calltime);
+
+  /* if we got here, then the call is definitely for us. set AX and CF to */
+  /* 'success' (being a natural optimist I assume success) */
+  SUCCESSFLAG;
+
+  /* servers that did not answer at load time are asked about their
+   * extensions once they are needed */
+  if (glob_srvunknown != 0) srvcapscheck(glob_reqdrv);
+
+  /* write-back buffers hold data that the server does not know about yet:
+   * it has to get there before anything might observe it. Calls that relate
+   * to an open file only need to care about that very file (see below), plus
+   * buffers that have been waiting for too long */
+  if (glob_wbdirty != 0) {
+    if (((subfunction >= AL_CLSFIL) && (subfunction <= AL_UNLOCKFIL)) || (subfunction == AL_SKFMEND)) {
+      wbflushall(1);
+    } else {
+      wbflushall(0);
+    }
+  }
+
+  /* calls that may change the content of a directory make whatever the
+   * directory and metadata caches hold outdated. renaming or removing a
+   * directory affects all paths below it. the path of a written file is not
+   * known, but a write only changes sizes and times, not what exists */
+  switch (subfunction) {
+    case AL_RMDIR:
+    case AL_RENAME:
+      glob_dircache.drive = 0xff;
+      mdinval(glob_reqdrv, NULL);
+      break;
+    case AL_WRITEFIL:
+      mdinvalwrite(glob_reqdrv);
+      break;
+    case AL_MKDIR:
+    case AL_SETATTR:
+    case AL_DELETE:
+    case AL_CREATE:
+    case AL_SPOPNFIL:
+      glob_dircache.drive = 0xff;
+      mdinval(glob_reqdrv, glob_sdaptr->fn1 + 2);
+      break;
+  }
+
+  /* look what function is called exactly and process it */
+  switch (subfunction) {
+    case AL_RMDIR: /*** 01h: RMDIR ******************************************/
+      /* RMDIR is like MKDIR, but I need to check if dir is not current first */
+      for (i = 0; glob_sdaptr->fn1[i] != 0; i++) {
+        if (glob_sdaptr->fn1[i] != glob_sdaptr->drive_cdsptr[i]) goto proceedasmkdir;
+      }
+      FAILFLAG(16); /* err 16 = "attempted to remove current directory" */
+      break;
+      proceedasmkdir:
+    case AL_MKDIR: /*** 03h: MKDIR ******************************************/
+      i = mystrlen(glob_sdaptr->fn1);
+      /* fn1 must be at least 2 bytes long */
+      if (i < 2) {
+        FAILFLAG(3); /* "path not found" */
+        break;
+      }
+      /* copy fn1 to buff (but skip drive part) */
+      i -= 2;
+      copybytes(buff, glob_sdaptr->fn1 + 2, i);
+      /* send query providing fn1 */
+      if (sendquery(subfunction, glob_reqdrv, i, &answer, &ax, 0) == 0) {
+        glob_intregs.w.ax = *ax;
+        if (*ax != 0) glob_intregs.w.flags |= INTR_CF;
+      } else {
+        FAILFLAG(2);
+      }
+      break;
+    case AL_CHDIR: /*** 05h: CHDIR ******************************************/
+      /* The INT 2Fh/1105h redirector callback is executed by DOS when
+       * changing directories. The Phantom authors (and RBIL contributors)
+       * clearly thought that it was the redirector's job to update the CDS,
+       * but in fact the callback is only meant to validate that the target
+       * directory exists; DOS subsequently updates the CDS. */
+      /* fn1 must be at least 2 bytes long */
+      i = mystrlen(glob_sdaptr->fn1);
+      if (i < 2) {
+        FAILFLAG(3); /* "path not found" */
+        break;
+      }
+      /* has this directory been found to exist (or not) recently? */
+      if (mdfind(glob_reqdrv, AL_CHDIR, glob_sdaptr->fn1 + 2) != NULL) break;
+      i = negfind(glob_reqdrv, AL_CHDIR, 0, glob_sdaptr->fn1 + 2);
+      if (i != 0) {
+        FAILFLAG(i);
+        break;
+      }
+      i = mystrlen(glob_sdaptr->fn1);
+      /* copy fn1 to buff (but skip the drive: part) */
+      i -= 2;
+      copybytes(buff, glob_sdaptr->fn1 + 2, i);
+      /* send query providing fn1 */
+      if (sendquery(AL_CHDIR, glob_reqdrv, i, &answer, &ax, 0) == 0) {
+        glob_intregs.w.ax = *ax;
+        if (*ax != 0) {
+          glob_intregs.w.flags |= INTR_CF;
+          negnew(glob_reqdrv, AL_CHDIR, 0, glob_sdaptr->fn1 + 2, *ax);
+        } else {
+          mdnew(glob_reqdrv, AL_CHDIR, glob_sdaptr->fn1 + 2);
+        }
+      } else {
+        FAILFLAG(3); /* "path not found" */
+      }
+      break;
+    case AL_CLSFIL: /*** 06h: CLSFIL ****************************************/
+      /* my only job is to decrement the SFT's handle count (which I didn't
+       * have to increment during OPENFILE since DOS does it... talk about
+       * consistency. I also inform the server about this, just so it knows */
+      /* ES:DI points to the SFT */
+      {
+      struct sftstruct far *sftptr = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
+      unsigned short errcode;
+      if (sftptr->handle_count > 0) sftptr->handle_count--;
+      if (sftstale(sftptr) != 0) { /* the server does not know the file */
+        FAILFLAG(6); /* "invalid handle" */
+        break;
+      }
+      radrop(glob_reqdrv, sftptr->start_sector);
+      /* whatever waits in the write-back buffer must be written first */
+      errcode = wbsync(glob_reqdrv, sftptr->start_sector, 1);
+      ((unsigned short *)buff)[0] = sftptr->start_sector;
+      if (sendquery(AL_CLSFIL, glob_reqdrv, 2, &answer, &ax, SQ_OPENFILE) == 0) {
+        if (*ax != 0) FAILFLAG(*ax);
+      }
+      if (errcode != 0) FAILFLAG(errcode); /* a delayed write failed */
+      }
+      break;
+    case AL_CMMTFIL: /*** 07h: CMMTFIL **************************************/
+      /* the only thing I have to do is to send out any delayed write */
+      {
+      struct sftstruct far *sftptr = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
+      unsigned short errcode;
+      if (sftstale(sftptr) != 0) {
+        FAILFLAG(6); /* "invalid handle" */
+        break;
+      }
+      errcode = wbsync(glob_reqdrv, sftptr->start_sector, 0);
+      if (errcode != 0) FAILFLAG(errcode);
+      }
+      break;
+    case AL_READFIL: /*** 08h: READFIL **************************************/
+      { /* ES:DI points to the SFT (whose file_pos needs to be updated) */
+        /* CX = number of bytes to read (to be updated with number of bytes actually read) */
+        /* SDA DTA = read buffer */
+      struct sftstruct far *sftptr = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
+      struct racache *ra;
+      unsigned short totreadlen = 0, len, errax;
+      /* is the file open for write-only? */
+      if (sftptr->open_mode & 1) {
+        FAILFLAG(5); /* "access denied" */
+        break;
+      }
+      if (sftstale(sftptr) != 0) {
+        FAILFLAG(6); /* "invalid handle" */
+        break;
+      }
+      /* return immediately if the caller wants to read 0 bytes */
+      if (glob_intregs.x.cx == 0) break;
+      /* the server has to know about delayed writes before I read anything */
+      errax = wbsync(glob_reqdrv, sftptr->start_sector, 0);
+      if (errax != 0) {
+        FAILFLAG(errax);
+        break;
+      }
+      /* serve whatever I can from the read-ahead cache first */
+      ra = rafind(glob_reqdrv, sftptr->start_sector);
+      if (ra != NULL) totreadlen = raget(ra, sftptr->file_pos, glob_sdaptr->curr_dta, glob_intregs.x.cx);
+      len = glob_intregs.x.cx - totreadlen;
+      if ((len != 0) && (len <= glob_rabufsz / 2) && (ra != NULL) && ((totreadlen != 0) || (ra->nextpos == sftptr->file_pos))) {
+        /* small sequential reads: fetch a full buffer ahead of the caller,
+         * and serve the read from it */
+        ra->len = 0;
+        ra->offs = sftptr->file_pos + totreadlen;
+        len = readfil(ra->offs, sftptr->start_sector, ra->buff, glob_rabufsz, &errax);
+        if (len < 0xFFFEu) {
+          ra->len = len;
+          len = raget(ra, ra->offs, glob_sdaptr->curr_dta + totreadlen, glob_intregs.x.cx - totreadlen);
+        }
+      } else if (len != 0) {
+        len = readfil(sftptr->file_pos + totreadlen, sftptr->start_sector, glob_sdaptr->curr_dta + totreadlen, len, &errax);
+      }
+      if (len == 0xFFFFu) { /* network error */
+        FAILFLAG(2);
+      } else if (len == 0xFFFEu) { /* backend error */
+        FAILFLAG(errax);
+      } else { /* success - update SFT and CX */
+        totreadlen += len;
+        /* small reads may be the beginning of a sequential scan: remember
+         * where this one ended, in the least recently used entry if needed */
+        if ((ra == NULL) && (glob_intregs.x.cx <= glob_rabufsz / 2) && (glob_racache != glob_raend)) {
+          struct racache *r;
+          ra = glob_racache;
+          for (r = glob_racache; r != glob_raend; r++) {
+            if (r->drive == 0xff) {
+              ra = r;
+              break;
+            }
+            if ((unsigned short)(glob_rastamp - r->stamp) > (unsigned short)(glob_rastamp - ra->stamp)) ra = r;
+          }
+          ra->drive = glob_reqdrv;
+          ra->fileid = sftptr->start_sector;
+          ra->len = 0;
+          ra->stamp = ++glob_rastamp;
+        }
+        if (ra != NULL) ra->nextpos = sftptr->file_pos + totreadlen;
+        sftptr->file_pos += totreadlen;
+        glob_intregs.x.cx = totreadlen;
+        glob_stats.rdbytes += totreadlen;
+      }
+      }
+      break;
+    case AL_WRITEFIL: /*** 09h: WRITEFIL ************************************/
+      { /* ES:DI points to the SFT (whose file_pos needs to be updated) */
+        /* CX = number of bytes to write (to be updated with number of bytes actually written) */
+        /* SDA DTA = read buffer */
+      struct sftstruct far *sftptr = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
+      struct wbcache *wb;
+      unsigned short len, chunklen, errcode;
+      unsigned char small;
+      /* is the file open for read-only? */
+      if ((sftptr->open_mode & 3) == 0) {
+        FAILFLAG(5); /* "access denied" */
+        break;
+      }
+      if (sftstale(sftptr) != 0) {
+        FAILFLAG(6); /* "invalid handle" */
+        break;
+      }
+      /* whatever has been read ahead might not be true any more */
+      radrop(glob_reqdrv, sftptr->start_sector);
+      /* TODO FIXME I should update the file's time in the SFT here */
+      len = glob_intregs.x.cx;
+      /* small writes are delayed in a write-back buffer, so they reach the
+       * server as a few full frames instead of many small queries. The data
+       * that waits in the buffer must go out first unless this write simply
+       * continues it (a write of 0 bytes only flushes the buffer: no query
+       * goes out for it, so the file is not truncated) */
+      small = ((len != 0) && (len <= glob_wbbufsz / 2))?1:0;
+      wb = wbfind(glob_reqdrv, sftptr->start_sector);
+      if ((wb != NULL) && ((wb->err != 0) || (small == 0) || ((wb->len != 0) && (sftptr->file_pos != wb->offs + wb->len)))) {
+        errcode = wbsync(glob_reqdrv, sftptr->start_sector, 0);
+        if (errcode != 0) {
+          FAILFLAG(errcode);
+          break;
+        }
+      }
+      if ((small != 0) && (wb == NULL)) wb = wbget(glob_reqdrv, sftptr->start_sector);
+      if ((small != 0) && (wb != NULL)) {
+        if (wb->len == 0) {
+          wb->offs = sftptr->file_pos;
+          wb->tick = biostick();
+        }
+        /* fill the buffer up, and once it is full send it out as a whole
+         * and put the rest of the data in there */
+        chunklen = glob_wbbufsz - wb->len;
+        if (chunklen > len) chunklen = len;
+        copybytes(wb->buff + wb->len, glob_sdaptr->curr_dta, chunklen);
+        wb->len += chunklen;
+        if (wb->len == glob_wbbufsz) {
+          errcode = wbflush(wb);
+          if (errcode != 0) {
+            wb->err = 0;
+            FAILFLAG(errcode);
+            break;
+          }
+          wb->offs = sftptr->file_pos + chunklen;
+          wb->tick = biostick();
+          wb->len = len - chunklen;
+          copybytes(wb->buff, glob_sdaptr->curr_dta + chunklen, wb->len);
+        }
+        wb->stamp = ++glob_wbstamp;
+        if (wb->len != 0) glob_wbdirty = 1;
+        /* as far as the application is concerned, all of it is written */
+        glob_stats.wrbytes += len;
+        sftptr->file_pos += len;
+        if (sftptr->file_pos > sftptr->file_size) sftptr->file_size = sftptr->file_pos;
+        break;
+      }
+      /* write it all through right away - CX is set to the amount of bytes
+       * actually written */
+      len = writefil(glob_reqdrv, sftptr->file_pos, sftptr->start_sector, glob_sdaptr->curr_dta, len, &errcode);
+      glob_intregs.x.cx = len;
+      glob_stats.wrbytes += len;
+      sftptr->file_pos += len;
+      if (sftptr->file_pos > sftptr->file_size) sftptr->file_size = sftptr->file_pos;
+      if (errcode != 0) FAILFLAG(errcode);
+      }
+      break;
+    case AL_LOCKFIL: /*** 0Ah: LOCKFIL **************************************/
+      /* TODO */
+      FAILFLAG(2);
+      break;
+    case AL_UNLOCKFIL: /*** 0Bh: UNLOCKFIL **********************************/
+      /* TODO */
+      FAILFLAG(2);
+      break;
+    case AL_DISKSPACE: /*** 0Ch: get disk information ***********************/
+      {
+      /* the cached answer is kept along with its AX, as AXCCSSFF */
+      struct mdcache *md = mdfind(glob_reqdrv, AL_DISKSPACE, NULL);
+      if (md == NULL) {
+        if (sendquery(AL_DISKSPACE, glob_reqdrv, 0, &answer, &ax, 0) != 6) {
+          FAILFLAG(2);
+          break;
+        }
+        md = mdnew(glob_reqdrv, AL_DISKSPACE, NULL);
+        if (md != NULL) copybytes(md->data, ax, 8);
+        answer -= 2; /* make it point at AX, like md->data */
+      } else {
+        answer = md->data;
+      }
+      glob_intregs.w.ax = ((unsigned short *)answer)[0]; /* sectors per cluster */
+      glob_intregs.w.bx = ((unsigned short *)answer)[1]; /* total clusters */
+      glob_intregs.w.cx = ((unsigned short *)answer)[2]; /* bytes per sector */
+      glob_intregs.w.dx = ((unsigned short *)answer)[3]; /* num of available clusters */
+      }
+      break;
+    case AL_SETATTR: /*** 0Eh: SETATTR **************************************/
+      /* sdaptr->fn1 -> file to set attributes for
+         stack word -> new attributes (stack must not be changed!) */
+      /* fn1 must be at least 2 characters long */
+      i = mystrlen(glob_sdaptr->fn1);
+      if (i < 2) {
+        FAILFLAG(2);
+        break;
+      }
+      /* */
+      buff[0] = glob_reqstkword;
+      /* copy fn1 to buff (but without the drive part) */
+      copybytes(buff + 1, glob_sdaptr->fn1 + 2, i - 2);
+    #if DEBUGLEVEL > 0
+      dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x1000 | dbg_hexc[(glob_reqstkword >> 4) & 15];
+      dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x1000 | dbg_hexc[glob_reqstkword & 15];
+    #endif
+      i = sendquery(AL_SETATTR, glob_reqdrv, i - 1, &answer, &ax, 0);
+      if (i != 0) {
+        FAILFLAG(2);
+      } else if (*ax != 0) {
+        FAILFLAG(*ax);
+      }
+      break;
+    case AL_GETATTR: /*** 0Fh: GETATTR **************************************/
+      {
+      struct mdcache *md;
+      i = mystrlen(glob_sdaptr->fn1);
+      if (i < 2) {
+        FAILFLAG(2);
+        break;
+      }
+      /* has the same question been answered recently? */
+      i = negfind(glob_reqdrv, AL_GETATTR, 0, glob_sdaptr->fn1 + 2);
+      if (i != 0) {
+        FAILFLAG(i);
+        break;
+      }
+      md = mdfind(glob_reqdrv, AL_GETATTR, glob_sdaptr->fn1 + 2);
+      if (md != NULL) {
+        answer = md->data;
+      } else {
+        i = mystrlen(glob_sdaptr->fn1) - 2;
+        copybytes(buff, glob_sdaptr->fn1 + 2, i);
+        i = sendquery(AL_GETATTR, glob_reqdrv, i, &answer, &ax, 0);
+        if ((unsigned short)i == 0xffffu) {
+          FAILFLAG(2);
+          break;
+        } else if ((i != 9) || (*ax != 0)) {
+          FAILFLAG(*ax);
+          negnew(glob_reqdrv, AL_GETATTR, 0, glob_sdaptr->fn1 + 2, *ax);
+          break;
+        }
+        md = mdnew(glob_reqdrv, AL_GETATTR, glob_sdaptr->fn1 + 2);
+        if (md != NULL) copybytes(md->data, answer, 9);
+      }
+      /* CX = timestamp
+       * DX = datestamp
+       * BX:DI = fsize
+       * AX = attr
+       * NOTE: Undocumented DOS talks only about setting AX, no fsize, time
+       *       and date, these are documented in RBIL and used by SHSUCDX */
+      glob_intregs.w.cx = ((unsigned short *)answer)[0]; /* time */
+      glob_intregs.w.dx = ((unsigned short *)answer)[1]; /* date */
+      glob_intregs.w.bx = ((unsigned short *)answer)[3]; /* fsize hi word */
+      glob_intregs.w.di = ((unsigned short *)answer)[2]; /* fsize lo word */
+      glob_intregs.w.ax = answer[8];                     /* file attribs */
+      }
+      break;
+    case AL_RENAME: /*** 11h: RENAME ****************************************/
+      /* sdaptr->fn1 = old name
+       * sdaptr->fn2 = new name */
+      /* is the operation for the SAME drive? */
+      if (glob_sdaptr->fn1[0] != glob_sdaptr->fn2[0]) {
+        FAILFLAG(2);
+        break;
+      }
+      /* prepare the query (LSSS...DDD...) */
+      i = mystrlen(glob_sdaptr->fn1);
+      if (i < 2) {
+        FAILFLAG(2);
+        break;
+      }
+      i -= 2; /* trim out the drive: part (C:\FILE --> \FILE) */
+      buff[0] = i;
+      copybytes(buff + 1, glob_sdaptr->fn1 + 2, i);
+      i = len_if_no_wildcards((char far *)glob_sdaptr->fn2);
+      if (i < 2) {
+        FAILFLAG(3);
+        break;
+      }
+      i -= 2; /* trim out the drive: part (C:\FILE --> \FILE) */
+      copybytes(buff + 1 + buff[0], glob_sdaptr->fn2 + 2, i);
+      /* send the query out */
+      i = sendquery(AL_RENAME, glob_reqdrv, 1 + buff[0] + i, &answer, &ax, 0);
+      if (i != 0) {
+        FAILFLAG(2);
+      } else if (*ax != 0) {
+        FAILFLAG(*ax);
+      }
+      break;
+    case AL_DELETE: /*** 13h: DELETE ****************************************/
+    #if DEBUGLEVEL > 0
+      dbg_msg = glob_sdaptr->fn1;
+    #endif
+      /* compute length of fn1 and copy it to buff (w/o the 'drive:' part) */
+      i = mystrlen(glob_sdaptr->fn1);
+      if (i < 2) {
+        FAILFLAG(2);
+        break;
+      }
+      i -= 2;
+      copybytes(buff, glob_sdaptr->fn1 + 2, i);
+      /* send query */
+      i = sendquery(AL_DELETE, glob_reqdrv, i, &answer, &ax, 0);
+      if ((unsigned short)i == 0xffffu) {
+        FAILFLAG(2);
+      } else if ((i != 0) || (*ax != 0)) {
+        FAILFLAG(*ax);
+      }
+      break;
+    case AL_OPEN: /*** 16h: OPEN ********************************************/
+    case AL_CREATE: /*** 17h: CREATE ****************************************/
+    case AL_SPOPNFIL: /*** 2Eh: SPOPNFIL ************************************/
+    #if DEBUGLEVEL > 0
+      dbg_msg = glob_sdaptr->fn1;
+    #endif
+      /* fail if fn1 contains any wildcard, otherwise get len of fn1 */
+      i = len_if_no_wildcards((char far *)glob_sdaptr->fn1);
+      if (i < 2) {
+        FAILFLAG(3);
+        break;
+      }
+      /* a file that could not be found a moment ago is still not there */
+      if (subfunction == AL_OPEN) {
+        unsigned short err = negfind(glob_reqdrv, AL_OPEN, 0, glob_sdaptr->fn1 + 2);
+        if (err != 0) {
+          FAILFLAG(err);
+          break;
+        }
+      }
+      i -= 2;
+      /* prepare and send query (SSCCMMfff...) */
+      ((unsigned short *)buff)[0] = glob_reqstkword; /* WORD from the stack */
+      ((unsigned short *)buff)[1] = glob_sdaptr->spop_act; /* action code (SPOP only) */
+      ((unsigned short *)buff)[2] = glob_sdaptr->spop_mode; /* open mode (SPOP only) */
+      copybytes(buff + 6, glob_sdaptr->fn1 + 2, i);
+      i = sendquery(subfunction, glob_reqdrv, i + 6, &answer, &ax, 0);
+      if ((unsigned short)i == 0xffffu) {
+        FAILFLAG(2);
+      } else if ((i != 25) || (*ax != 0)) {
+        FAILFLAG(*ax);
+        if (subfunction == AL_OPEN) negnew(glob_reqdrv, AL_OPEN, 0, glob_sdaptr->fn1 + 2, *ax);
+      } else {
+        /* ES:DI contains an uninitialized SFT */
+        struct sftstruct far *sftptr = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
+        /* special treatment for SPOP, (set open_mode and return CX, too) */
+        if (subfunction == AL_SPOPNFIL) {
+          glob_intregs.w.cx = ((unsigned short *)answer)[11];
+        }
+        if (sftptr->open_mode & 0x8000) { /* if bit 15 is set, then it's a "FCB open", and requires the internal DOS "Set FCB Owner" function to be called */
+          /* TODO FIXME set_sft_owner() */
+        #if DEBUGLEVEL > 0
+          dbg_VGA[25*80] = 0x1700 | '$';
+        #endif
+        }
+        sftptr->file_attr = answer[0];
+        sftptr->dev_info_word = 0x8040 | glob_reqdrv; /* mark device as network drive */
+        sftptr->dev_drvr_ptr = NULL;
+        sftptr->start_sector = ((unsigned short *)answer)[10];
+        sftptr->file_time = ((unsigned long *)answer)[3];
+        sftptr->file_size = ((unsigned long *)answer)[4];
+        sftptr->file_pos = 0;
+        sftptr->open_mode &= 0xff00u;
+        sftptr->open_mode |= answer[24];
+        sftptr->rel_sector = 0xffff;
+        sftptr->abs_sector = 0xffff;
+        sftptr->dir_sector = glob_drvgen[glob_reqdrv]; /* see sftstale() */
+        sftptr->dir_entry_no = 0xff; /* why such value? no idea, PHANTOM.C uses that, too */
+        copybytes(sftptr->file_name, answer + 1, 11);
+      }
+      break;
+    case AL_FINDFIRST: /*** 1Bh: FINDFIRST **********************************/
+    case AL_FINDNEXT:  /*** 1Ch: FINDNEXT ***********************************/
+      {
+      /* AX = 111Bh
+      SS = DS = DOS DS
+      [DTA] = uninitialized 21-byte findfirst search data
+      (see #01626 at INT 21/AH=4Eh)
+      SDA first filename pointer (FN1, 9Eh) -> fully-qualified search template
+      SDA CDS pointer -> current directory structure for drive with file
+      SDA search attribute = attribute mask for search
+
+      Return:
+      CF set on error
+      AX = DOS error code (see #01680 at INT 21/AH=59h/BX=0000h)
+           -> http://www.ctyme.com/intr/rb-3012.htm
+      CF clear if successful
+      [DTA] = updated findfirst search data
+      (bit 7 of first byte must be set)
+      [DTA+15h] = standard directory entry for file (see #01352)
+
+      FindNext is the same, but only DTA should be used to fetch search params
+      */
+      struct sdbstruct far *dta;
+      unsigned char *q;
+      unsigned char batch = 0, nomore;
+
+#if DEBUGLEVEL > 0
+      dbg_msg = glob_sdaptr->fn1;
+#endif
+      /* FindFirst gets search arguments from SDA, FindNext from DTA (es:di) */
+      if (subfunction == AL_FINDFIRST) {
+        dta = (struct sdbstruct far *)(glob_sdaptr->curr_dta);
+      } else {
+        dta = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
+      }
+      /* a FindFirst might have failed a moment ago already, and a FindNext
+       * might be served right away from the directory cache */
+      answer = NULL;
+      if (subfunction == AL_FINDFIRST) {
+        i = negfind(glob_reqdrv, AL_FINDFIRST, glob_sdaptr->srch_attr, glob_sdaptr->fn1 + 2);
+        if (i != 0) {
+          FAILFLAG(i);
+          break;
+        }
+      } else {
+        answer = dirget(dta, glob_reqdrv, &nomore);
+        if (nomore != 0) {
+          FAILFLAG(18); /* "no more files" */
+          break;
+        }
+      }
+      if (answer == NULL) {
+        /* if the server supports it, ask for as many entries as it can fit
+         * in a frame at once: the query is NFxxx... (max amount of entries,
+         * F = 0 for FindFirst or 1 for FindNext, then the usual query) */
+        q = buff;
+        if (glob_dirmax != 0) {
+          batch = glob_dirmax;
+          buff[0] = batch;
+          buff[1] = (subfunction == AL_FINDNEXT)?1:0;
+          q = buff + 2;
+        }
+        /* prepare the query buffer (i must provide query's length) */
+        if (subfunction == AL_FINDFIRST) {
+          /* FindFirst needs to fetch search arguments from SDA */
+          q[0] = glob_sdaptr->srch_attr; /* file attributes to look for */
+          /* copy fn1 (w/o drive) to buff */
+          for (i = 2; glob_sdaptr->fn1[i] != 0; i++) q[i-1] = glob_sdaptr->fn1[i];
+          i--; /* adjust i because its one too much otherwise */
+        } else { /* FindNext needs to fetch search arguments from DTA */
+          ((unsigned short *)q)[0] = dta->par_clstr;
+          ((unsigned short *)q)[1] = dta->dir_entry;
+          q[4] = dta->srch_attr;
+          /* copy search template to buff */
+          for (i = 0; i < 11; i++) q[i+5] = dta->srch_tmpl[i];
+          i += 5; /* i must provide the exact query's length */
+        }
+        i += (q - buff);
+        /* send query to remote peer and wait for answer */
+        i = sendquery((batch != 0)?EXT_FINDBATCH:subfunction, glob_reqdrv, i, &answer, &ax, 0);
+        if ((unsigned short)i == 0xffffu) {
+          if (subfunction == AL_FINDFIRST) {
+            FAILFLAG(2); /* a failed findfirst returns error 2 (file not found) */
+          } else {
+            FAILFLAG(18); /* a failed findnext returns error 18 (no more files) */
+          }
+          break;
+        } else if ((*ax != 0) || ((batch == 0) && (i != 24))) {
+          FAILFLAG(*ax);
+          if (subfunction == AL_FINDFIRST) negnew(glob_reqdrv, AL_FINDFIRST, glob_sdaptr->srch_attr, glob_sdaptr->fn1 + 2, *ax);
+          break;
+        }
+        /* a batch answer is Neee... (N entries, 24 bytes each): the first
+         * entry is the one to return, all others go to the directory cache */
+        if (batch != 0) {
+          if ((answer[0] == 0) || (answer[0] > batch) || (i < 1 + ((unsigned short)answer[0] * 24))) {
+            /* *ax is 0 here, so fail the way a network error does */
+            if (subfunction == AL_FINDFIRST) {
+              FAILFLAG(2);
+            } else {
+              FAILFLAG(18);
+            }
+            break;
+          }
+          glob_dircache.count = answer[0] - 1;
+          glob_dircache.eod = (answer[0] < batch)?1:0;
+          glob_dircache.next = glob_dircache.buff;
+          answer++;
+          copybytes(glob_dircache.buff, answer + 24, glob_dircache.count * 24);
+        }
+      }
+      /* fill in the directory entry 'found_file' (32 bytes)
+       * 00h unsigned char fname[11]
+       * 0Bh unsigned char fattr (1=RO 2=HID 4=SYS 8=VOL 16=DIR 32=ARCH 64=DEV)
+       * 0Ch unsigned char f1[10]
+       * 16h unsigned short time_lstupd
+       * 18h unsigned short date_lstupd
+       * 1Ah unsigned short start_clstr  *optional*
+       * 1Ch unsigned long fsize
+       */
+      copybytes(glob_sdaptr->found_file.fname, answer+1, 11); /* found file name */
+      glob_sdaptr->found_file.fattr = answer[0]; /* found file attributes */
+      glob_sdaptr->found_file.time_lstupd = ((unsigned short *)answer)[6]; /* time (word) */
+      glob_sdaptr->found_file.date_lstupd = ((unsigned short *)answer)[7]; /* date (word) */
+      glob_sdaptr->found_file.start_clstr = 0; /* start cluster (I don't care) */
+      glob_sdaptr->found_file.fsize = ((unsigned long *)answer)[4]; /* fsize (word) */
+
+      /* put things into DTA so I can understand where I left should FindNext
+       * be called - this shall be a valid FindFirst structure (21 bytes):
+       * 00h unsigned char drive letter (7bits, MSB must be set for remote drives)
+       * 01h unsigned char search_tmpl[11]
+       * 0Ch unsigned char search_attr (1=RO 2=HID 4=SYS 8=VOL 16=DIR 32=ARCH 64=DEV)
+       * 0Dh unsigned short entry_count_within_directory
+       * 0Fh unsigned short cluster number of start of parent directory
+       * 11h unsigned char reserved[4]
+       * -- RBIL says: [DTA+15h] = standard directory entry for file
+       * 15h 11-bytes (FCB-style) filename+ext ("FILE0000TXT")
+       * 20h unsigned char attr. of file found (1=RO 2=HID 4=SYS 8=VOL 16=DIR 32=ARCH 64=DEV)
+       * 21h 10-bytes reserved
+       * 2Bh unsigned short file time
+       * 2Dh unsigned short file date
+       * 2Fh unsigned short cluster
+       * 31h unsigned long file size
+       */
+      /* init some stuff only on FindFirst (FindNext contains valid values already) */
+      if (subfunction == AL_FINDFIRST) {
+        dta->drv_lett = glob_reqdrv | 128; /* bit 7 set means 'network drive' */
+        copybytes(dta->srch_tmpl, glob_sdaptr->fcb_fn1, 11);
+        dta->srch_attr = glob_sdaptr->srch_attr;
+      }
+      dta->par_clstr = ((unsigned short *)answer)[10];
+      dta->dir_entry = ((unsigned short *)answer)[11];
+      /* then 32 bytes as in the found_file record */
+      copybytes((unsigned char far *)dta + 0x15, &(glob_sdaptr->found_file), 32);
+      /* the directory cache follows the search, so the next FindNext finds
+       * there whatever comes after this entry */
+      if (batch != 0) {
+        glob_dircache.drive = glob_reqdrv;
+        glob_dircache.srch_attr = dta->srch_attr;
+        copybytes(glob_dircache.srch_tmpl, dta->srch_tmpl, 11);
+        glob_dircache.par_clstr = dta->par_clstr;
+      }
+      if (glob_dircache.drive == glob_reqdrv) glob_dircache.dir_entry = dta->dir_entry;
+      }
+      break;
+    case AL_SKFMEND: /*** 21h: SKFMEND **************************************/
+    {
+      struct sftstruct far *sftptr = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
+      if (sftstale(sftptr) != 0) {
+        FAILFLAG(6); /* "invalid handle" */
+        break;
+      }
+      /* the server must know the actual size of the file */
+      i = wbsync(glob_reqdrv, sftptr->start_sector, 0);
+      if (i != 0) {
+        FAILFLAG(i);
+        break;
+      }
+      ((unsigned short *)buff)[0] = glob_intregs.x.dx;
+      ((unsigned short *)buff)[1] = glob_intregs.x.cx;
+      ((unsigned short *)buff)[2] = sftptr->start_sector;
+      /* send query to remote peer and wait for answer */
+      i = sendquery(AL_SKFMEND, glob_reqdrv, 6, &answer, &ax, SQ_OPENFILE);
+      if ((unsigned short)i == 0xffffu) {
+        FAILFLAG(2);
+      } else if ((*ax != 0) || (i != 4)) {
+        FAILFLAG(*ax);
+      } else { /* put new position into DX:AX */
+        glob_intregs.w.ax = ((unsigned short *)answer)[0];
+        glob_intregs.w.dx = ((unsigned short *)answer)[1];
+      }
+      break;
+    }
+    case AL_UNKNOWN_2D: /*** 2Dh: UNKNOWN_2D ********************************/
+      /* this is only called in MS-DOS v4.01, its purpose is unknown. MSCDEX
+       * returns AX=2 there, and so do I. */
+      glob_intregs.w.ax = 2;
+      break;
+  }
+
+  if (tr != NULL) traceend(tr, calltime);
+  if (glob_hist != NULL) histadd(subfunction, pit_now() - calltime, glob_netwait);
+
+  /* DEBUG */
+#if DEBUGLEVEL > 0
+  while ((dbg_msg != NULL) && (*dbg_msg != 0)) dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x4f00 | *(dbg_msg++);
+#endif
+}
+
+/* serves the MPX_SRVCOPY multiplex call (see mplex.h): asks the server to
+ * copy data between two files it has open, in as many SRVCOPY queries as it
+ * takes (the server copies only so much at each query, so none of them times
+ * out). ES:DI points to the caller's struct mpxcopy. */
+static void srvcopy(void) {
+  struct mpxcopy far *p = MK_FP(glob_intregs.x.es, glob_intregs.x.di);
+  struct sftstruct far *src = p->src;
+  struct sftstruct far *dst = p->dst;
+  unsigned char *buff = glob_pktdrv_sndbuff + 60;
+  unsigned char *answer;
+  unsigned short *ax;
+  unsigned short errcode, l;
+  unsigned long done = 0, n;
+  unsigned char drv;
+
+  /* both files must be open on the same drive of mine, and the server must
+   * support SRVCOPY - otherwise the caller has to copy data by itself */
+  glob_intregs.w.ax = 1; /* "invalid function" */
+  if (((src->dev_info_word & 0x8000u) == 0) || ((dst->dev_info_word & 0x8000u) == 0)) return;
+  drv = src->dev_info_word & 0x3F;
+  if ((drv > 25) || (glob_data.ldrv[drv] == 0xff) || ((dst->dev_info_word & 0x3F) != drv)) return;
+  if (glob_srvunknown != 0) srvcapscheck(drv);
+  if ((glob_srvcaps & CAP_SRVCOPY) == 0) return;
+  if (((src->open_mode & 3) == 1) || ((dst->open_mode & 3) == 0)) { /* source write-only, or destination read-only */
+    glob_intregs.w.ax = 5; /* "access denied" */
+    return;
+  }
+  if ((sftstale(src) != 0) || (sftstale(dst) != 0)) {
+    glob_intregs.w.ax = 6; /* "invalid handle" */
+    return;
+  }
+
+  /* the server has to know about delayed writes to either file, and what
+   * I know about the destination file will not be true any more */
+  errcode = wbsync(drv, src->start_sector, 0);
+  if (errcode == 0) errcode = wbsync(drv, dst->start_sector, 0);
+  if (errcode != 0) {
+    glob_intregs.w.ax = errcode;
+    return;
+  }
+  radrop(drv, dst->start_sector);
+  glob_dircache.drive = 0xff;
+  mdinval(drv, NULL);
+
+  glob_intregs.w.ax = 0;
+  while (done < p->len) {
+    /* query is SSOOOOssooooLLLL (source start sector and offset, destination
+     * start sector and offset, length to copy) */
+    ((unsigned short *)buff)[0] = src->start_sector;
+    *((unsigned long *)(buff + 2)) = src->file_pos + done;
+    ((unsigned short *)buff)[3] = dst->start_sector;
+    *((unsigned long *)(buff + 8)) = dst->file_pos + done;
+    *((unsigned long *)(buff + 12)) = p->len - done;
+    l = sendquery(EXT_SRVCOPY, drv, 16, &answer, &ax, SQ_OPENFILE);
+    if (l == 0xFFFFu) { /* network error */
+      glob_intregs.w.ax = 2;
+      break;
+    } else if ((*ax != 0) || (l != 4)) { /* backend error */
+      glob_intregs.w.ax = *ax;
+      break;
+    }
+    /* answer is LLLL (amount of bytes copied, 0 at end of source file) */
+    n = *((unsigned long *)answer);
+    if (n > p->len - done) n = p->len - done;
+    if (n == 0) break;
+    done += n;
+  }
+  /* update positions (and destination's size) */
+  src->file_pos += done;
+  dst->file_pos += done;
+  if (dst->file_pos > dst->file_size) dst->file_size = dst->file_pos;
+  p->len = done;
+}
+
+
+/* this function is hooked on INT 2Fh */
+#ifndef HOSTBUILD
+void __interrupt __far inthandler(union INTPACK r) {
+  /* insert a static code signature so I can reliably patch myself later,
+   * this will also contain the DS segment to use and actually set it */
+  _asm {
+    jmp SKIPTSRSIG
+    TSRSIG DB 'M','V','e','t'
+    SKIPTSRSIG:
+    /* save AX */
+    push ax
+    /* switch to new (patched) DS */
+    mov ax, 0
+    mov ds, ax
+    /* save one word from the stack (might be used by SETATTR later)
+     * The original stack should be at SS:BP+30 */
+    mov ax, ss:[BP+30]
+    mov glob_reqstkword, ax
+
+    /* uncomment the debug code below to insert a stack's dump into snd eth
+     * frame - debugging ONLY! */
+    /*
+    mov ax, ss:[BP+20]
+    mov word ptr [glob_pktdrv_sndbuff+16], ax
+    mov ax, ss:[BP+22]
+    mov word ptr [glob_pktdrv_sndbuff+18], ax
+    mov ax, ss:[BP+24]
+    mov word ptr [glob_pktdrv_sndbuff+20], ax
+    mov ax, ss:[BP+26]
+    mov word ptr [glob_pktdrv_sndbuff+22], ax
+    mov ax, ss:[BP+28]
+    mov word ptr [glob_pktdrv_sndbuff+24], ax
+    mov ax, ss:[BP+30]
+    mov word ptr [glob_pktdrv_sndbuff+26], ax
+    mov ax, ss:[BP+32]
+    mov word ptr [glob_pktdrv_sndbuff+28], ax
+    mov ax, ss:[BP+34]
+    mov word ptr [glob_pktdrv_sndbuff+30], ax
+    mov ax, ss:[BP+36]
+    mov word ptr [glob_pktdrv_sndbuff+32], ax
+    mov ax, ss:[BP+38]
+    mov word ptr [glob_pktdrv_sndbuff+34], ax
+    mov ax, ss:[BP+40]
+    mov word ptr [glob_pktdrv_sndbuff+36], ax
+    */
+    /* restore AX */
+    pop ax
+  }
+
+  /* DEBUG output (BLUE) */
+#if DEBUGLEVEL > 1
+  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x1e00 | (dbg_hexc[(r.h.ah >> 4) & 0xf]);
+  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x1e00 | (dbg_hexc[r.h.ah & 0xf]);
+  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x1e00 | (dbg_hexc[(r.h.al >> 4) & 0xf]);
+  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x1e00 | (dbg_hexc[r.h.al & 0xf]);
+  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0;
+#endif
+
+  /* is it a multiplex call for me? */
+  if (r.h.ah == glob_multiplexid) {
+    if (r.h.al == MPX_INSTALLCHK) { /* install check */
+      r.h.al = 0xff;    /* 'installed' */
+      r.w.bx = MPXSIG;  /* MV          */
+      r.w.cx = 0x7e1;   /* 2017        */
+      return;
+    }
+    /* get shared data or counters ptr (AX=0, ptr under BX:CX) */
+    if (((r.h.al == MPX_GETDATA) || (r.h.al == MPX_GETSTATS)) && (r.x.cx == MPXSIG)) {
+      _asm {
+        push ds
+        pop glob_reqstkword
+      }
+      r.w.cx = (r.h.al == MPX_GETDATA)?FP_OFF(&glob_data):FP_OFF(&glob_stats);
+      r.w.ax = 0; /* zero out AX */
+      r.w.bx = glob_reqstkword; /* ptr returned at BX:CX */
+      return;
+    }
+    if ((r.h.al == MPX_GETHIST) && (r.x.cx == MPXSIG)) { /* get histograms ptr (AX=0, ptr under BX:CX) */
+      r.w.ax = 1; /* "not enabled" */
+      if (glob_hist == NULL) return;
+      _asm {
+        push ds
+        pop glob_reqstkword
+      }
+      r.w.ax = 0;
+      r.w.bx = glob_reqstkword;
+      r.w.cx = FP_OFF(glob_hist);
+      return;
+    }
+    if ((r.h.al == MPX_GETTRACE) && (r.x.cx == MPXSIG)) { /* get trace ring ptr (AX=0, ptr under BX:CX) */
+      r.w.ax = 1; /* "not enabled" */
+      if (glob_tracexms != NULL) {
+        _asm {
+          push ds
+          pop glob_reqstkword
+        }
+        r.w.ax = 0;
+        r.w.bx = glob_reqstkword;
+        r.w.cx = FP_OFF(&(glob_tracexms->hdr));
+      } else if (glob_traceseg != 0) {
+        r.w.ax = 0;
+        r.w.bx = glob_traceseg;
+        r.w.cx = 0;
+      }
+      return;
+    }
+    if ((r.h.al == MPX_SRVCOPY) && (r.x.cx == MPXSIG)) goto PROCESSCALL; /* server-side copy */
+  }
+
+  /* if not related to a redirector function (AH=11h), or the function is
+   * an 'install check' (0), or the function is over our scope (2Eh), or it's
+   * an otherwise unsupported function (as pointed out by supportedfunctions),
+   * then call the previous INT 2F handler immediately */
+  if ((r.h.ah != 0x11) || (r.h.al == AL_INSTALLCHK) || (r.h.al > 0x2E) || (supportedfunctions[r.h.al] == AL_UNKNOWN)) goto CHAINTOPREVHANDLER;
+
+  /* DEBUG output (GREEN) */
+#if DEBUGLEVEL > 0
+  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x2e00 | (dbg_hexc[(r.h.al >> 4) & 0xf]);
+  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x2e00 | (dbg_hexc[r.h.al & 0xf]);
+  dbg_VGA[dbg_startoffset + dbg_xpos++] = 0;
+#endif
+
+  /* determine whether or not the query is meant for a drive I control,
+   * and if not - chain to the previous INT 2F handler */
+  if (((r.h.al >= AL_CLSFIL) && (r.h.al <= AL_UNLOCKFIL)) || (r.h.al == AL_SKFMEND) || (r.h.al == AL_UNKNOWN_2D)) {
+  /* ES:DI points to the SFT: if the bottom 6 bits of the device information
+   * word in the SFT are > last drive, then it relates to files not associated
+   * with drives, such as LAN Manager named pipes. */
+    struct sftstruct far *sft = MK_FP(r.w.es, r.w.di);
+    glob_reqdrv = sft->dev_info_word & 0x3F;
+  } else {
+    switch (r.h.al) {
+      case AL_FINDNEXT:
+        glob_reqdrv = glob_sdaptr->sdb.drv_lett & 0x1F;
+        break;
+      case AL_SETATTR:
+      case AL_GETATTR:
+      case AL_DELETE:
+      case AL_OPEN:
+      case AL_CREATE:
+      case AL_SPOPNFIL:
+      case AL_MKDIR:
+      case AL_RMDIR:
+      case AL_CHDIR:
+      case AL_RENAME: /* check sda.fn1 for drive */
+        glob_reqdrv = DRIVETONUM(glob_sdaptr->fn1[0]);
+        break;
+      default: /* otherwise check out the CDS (at ES:DI) */
+        {
+        struct cdsstruct far *cds = MK_FP(r.w.es, r.w.di);
+        glob_reqdrv = DRIVETONUM(cds->current_path[0]);
+      #if DEBUGLEVEL > 0 /* DEBUG output (ORANGE) */
+        dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x6e00 | ('A' + glob_reqdrv);
+        dbg_VGA[dbg_startoffset + dbg_xpos++] = 0x6e00 | ':';
+      #endif
+        }
+        break;
+    }
+  }
+  /* validate drive */
+  if ((glob_reqdrv > 25) || (glob_data.ldrv[glob_reqdrv] == 0xff)) {
+    goto CHAINTOPREVHANDLER;
+  }
+
+  /* This should not be necessary. DOS usually generates an FCB-style name in
+   * the appropriate SDA area. However, in the case of user input such as
+   * 'CD ..' or 'DIR ..' it leaves the fcb area all spaces, hence the need to
+   * normalize the fcb area every time. */
+  if (r.h.al != AL_DISKSPACE) {
+    unsigned short i;
+    unsigned char far *path = glob_sdaptr->fn1;
+
+    /* fast forward 'path' to first character of the filename */
+    for (i = 0;; i++) {
+      if (glob_sdaptr->fn1[i] == '\\') path = glob_sdaptr->fn1 + i + 1;
+      if (glob_sdaptr->fn1[i] == 0) break;
+    }
+
+    /* clear out fcb_fn1 by filling it with spaces */
+    for (i = 0; i < 11; i++) glob_sdaptr->fcb_fn1[i] = ' ';
+
+    /* copy 'path' into fcb_name using the fcb syntax ("FILE    TXT") */
+    for (i = 0; *path != 0; path++) {
+      if (*path == '.') {
+        i = 8;
+      } else {
+        glob_sdaptr->fcb_fn1[i++] = *path;
+      }
+    }
+  }
+
+  /* copy interrupt registers into glob_intregs so the int handler can access them without using any stack */
+  PROCESSCALL:
+  copybytes(&glob_intregs, &r, sizeof(union INTPACK));
+  /* set stack to my custom memory */
+  _asm {
+    cli /* make sure to disable interrupts, so nobody gets in the way while I'm fiddling with the stack */
+    mov glob_oldstack_seg, SS
+    mov glob_oldstack_off, SP
+    /* set SS to DS */
+    mov ax, ds
+    mov ss, ax
+    /* set SP to the end of my DATASEGSZ (-2) */
+    mov sp, DATASEGSZ
+    dec sp
+    dec sp
+    sti
+  }
+  /* call the actual INT 2F processing function */
+  glob_busy = 1;
+  if (glob_intregs.h.ah == glob_multiplexid) {
+    srvcopy();
+  } else {
+    process2f();
+  }
+  glob_busy = 0;
+  /* switch stack back */
+  _asm {
+    cli
+    mov SS, glob_oldstack_seg
+    mov SP, glob_oldstack_off
+    sti
+  }
+  /* copy all registers back so watcom will set them as required 'for real' */
+  copybytes(&r, &glob_intregs, sizeof(union INTPACK));
+  return;
+
+  /* hand control to the previous INT 2F handler */
+  CHAINTOPREVHANDLER:
+  _mvchain_intr(MK_FP(glob_data.prev_2f_handler_seg, glob_data.prev_2f_handler_off));
+}
+#endif
+
+/* looks (no more often than every PROBEIVAL ticks) whether the primary
+ * server of a drive that failed over to a replica is back. If it answers,
+ * all drives it is the primary server of go back to it. A single frame is
+ * sent and its answer awaited for a short while only, since this runs while
+ * DOS is idle. */
+static void srvprobe(void) {
+  unsigned char d, pri, cur;
+  unsigned short t;
+  if ((unsigned short)(biostick() - glob_probetick) < PROBEIVAL) return;
+  glob_probetick = biostick();
+  /* find a drive that is not on its primary server */
+  for (d = 0; d < 26; d++) {
+    if ((glob_data.ldrv[d] != 0xff) && (glob_drvsrv[d] != glob_drvpri[d])) break;
+  }
+  if (d == 26) {
+    glob_failover = 0;
+    return;
+  }
+  /* send it a DISKSPACE query, the answer does not matter */
+  pri = glob_drvpri[d];
+  cur = glob_drvsrv[d];
+  glob_drvsrv[d] = pri;
+  selectsrv(d);
+  glob_drvsrv[d] = cur;
+  glob_pktdrv_sndbuff[57] = ++glob_seq;
+  glob_pktdrv_sndbuff[58] = glob_data.ldrv[d];
+  glob_pktdrv_sndbuff[59] = AL_DISKSPACE;
+  glob_rxseqlo = glob_seq;
+  glob_rxanysrc = 0;
+  rxflush(); /* drop any stale frame */
+  pktdrv_send(60);
+  t = pit_now();
+  while ((unsigned short)(pit_now() - t) < PROBEWAIT) {
+    if (glob_rxtail->len < 1) continue;
+    /* the primary server is back */
+    rxflush();
+    for (d = 0; d < 26; d++) {
+      if (glob_drvpri[d] == pri) srvswitch(d, pri);
+    }
+    return;
+  }
+}
+
+
+/* this function is hooked on INT 28h, that DOS calls whenever it is idle
+ * (typically while waiting for a keypress). The network can't be used from
+ * the timer interrupt (the packet driver might be busy already), so this is
+ * where write-back buffers that have been waiting for WBIDLE ticks get
+ * flushed, and where primary servers that stopped answering are probed. */
+#ifndef HOSTBUILD
+void __interrupt __far idlehandler(void) {
+  /* code signature, with the DS segment to use (patched at startup) */
+  _asm {
+    jmp SKIPIDLESIG
+    IDLESIG DB 'M','V','i','d'
+    SKIPIDLESIG:
+    push ax
+    mov ax, 0
+    mov ds, ax
+    pop ax
+  }
+  if (((glob_wbdirty | glob_failover) != 0) && (glob_busy == 0)) {
+    glob_busy = 1;
+    _asm {
+      cli
+      mov glob_oldstack_seg, SS
+      mov glob_oldstack_off, SP
+      mov ax, ds
+      mov ss, ax
+      mov sp, DATASEGSZ
+      dec sp
+      dec sp
+      sti
+    }
+    if (glob_wbdirty != 0) wbflushall(1);
+    if (glob_failover != 0) srvprobe();
+    _asm {
+      cli
+      mov SS, glob_oldstack_seg
+      mov SP, glob_oldstack_off
+      sti
+    }
+    glob_busy = 0;
+  }
+  _mvchain_intr(MK_FP(glob_data.prev_28_handler_seg, glob_data.prev_28_handler_off));
+}
+#endif
+
+
+/*********************** HERE ENDS THE RESIDENT PART ***********************/
+
+/* the transient part is of no use to the host build */
+#ifndef HOSTBUILD
+
+#pragma code_seg("_TEXT", "CODE");
+
+/* this function obviously does nothing - but I need it because it is a
+ * 'low-water' mark for the end of my resident code (so I know how much memory
+ * exactly I can trim when going TSR) */
+void begtextend(void) {
+}
+
+/* registers a packet driver handle to use on subsequent calls */
+static int pktdrv_accesstype(void) {
+  unsigned char cflag = 0;
+
+  _asm {
+    mov ax, 201h        /* AH=subfunction access_type(), AL=if_class=1(eth) */
+    mov bx, 0ffffh      /* if_type = 0xffff means 'all' */
+    mov dl, 0           /* if_number: 0 (first interface) */
+    /* DS:SI should point to the ethertype value in network byte order */
+    mov si, glob_pktdrv_sndbuff /* I don't set DS, it's good already */
+    add si, 12
+    mov cx, 2           /* typelen (ethertype is 16 bits) */
+    /* ES:DI points to the receiving routine */
+    push cs /* write segment of pktdrv_recv into es */
+    pop es
+    mov di, offset pktdrv_recv
+    mov cflag, 1        /* pre-set the cflag variable to failure */
+    /* int to variable vector is a mess, so I have fetched its vector myself
+     * and pushf + cli + call far it now to simulate a regular int */
+    pushf
+    cli
+    call dword ptr glob_pktdrv_pktcall
+    /* get CF state - reset cflag if CF clear, and get pkthandle from AX */
+    jc badluck   /* Jump if Carry */
+    mov word ptr [glob_data + GLOB_DATOFF_PKTHANDLE], ax /* Pkt handle should be in AX */
+    mov cflag, 0
+    badluck:
+  }
+
+  if (cflag != 0) return(-1);
+  return(0);
+}
+
+/* get my own MAC addr. target MUST point to a space of at least 6 chars */
+static void pktdrv_getaddr(unsigned char *dst) {
+  _asm {
+    mov ah, 6                       /* subfunction: get_addr() */
+    mov bx, word ptr [glob_data + GLOB_DATOFF_PKTHANDLE];  /* handle */
+    push ds                         /* write segment of dst into es */
+    pop es
+    mov di, dst                     /* offset of dst (in small mem model dst IS an offset) */
+    mov cx, 6                       /* expected length (ethernet = 6 bytes) */
+    /* int to variable vector is a mess, so I have fetched its vector myself
+     * and pushf + cli + call far it now to simulate a regular int */
+    pushf
+    cli
+    call dword ptr glob_pktdrv_pktcall
+  }
+}
+
+/* asks the packet driver about the biggest frame it can handle (its MTU, MAC
+ * headers included). get_parameters() is an optional call, packet drivers
+ * that do not implement it make me return 0. */
+static unsigned short pktdrv_getmtu(void) {
+  unsigned short res = 0;
+  _asm {
+    push es
+    push di
+    mov ah, 0Ah                     /* subfunction: get_parameters() */
+    /* int to variable vector is a mess, so I have fetched its vector myself
+     * and pushf + cli + call far it now to simulate a regular int */
+    pushf
+    cli
+    call dword ptr glob_pktdrv_pktcall
+    jc nomtu                        /* function not supported */
+    mov ax, es:[di+4]               /* ES:DI points to the param struct */
+    mov res, ax
+    nomtu:
+    pop di
+    pop es
+  }
+  return(res);
+}
+
+
+/* switches PIT channel 0 to mode 2 (rate generator), keeping its divisor of
+ * 65536 so IRQ0 still fires at the usual 18.2 Hz. BIOSes usually set it up in
+ * mode 3 (square wave) where the counter goes down twice per period, which
+ * makes it useless for pit_now(). */
+static void pit_init(void) {
+  _asm {
+    pushf
+    cli
+    mov al, 34h   /* channel 0, lobyte/hibyte, mode 2, binary */
+    out 43h, al
+    xor al, al    /* divisor 0 (ie. 65536) */
+    out 40h, al
+    out 40h, al
+    popf
+  }
+}
+
+
+/* puts PIT channel 0 back in mode 3 (square wave) with a divisor of 65536,
+ * the way the BIOS sets it up */
+static void pit_done(void) {
+  _asm {
+    pushf
+    cli
+    mov al, 36h   /* channel 0, lobyte/hibyte, mode 3, binary */
+    out 43h, al
+    xor al, al    /* divisor 0 (ie. 65536) */
+    out 40h, al
+    out 40h, al
+    popf
+  }
+}
+
+
+static int pktdrv_init(unsigned short pktintparam) {
+  unsigned short far *intvect = (unsigned short far *)MK_FP(0, pktintparam << 2);
+  unsigned short pktdrvfuncoffs = *intvect;
+  unsigned short pktdrvfuncseg = *(intvect+1);
+  unsigned short rseg = 0, roff = 0;
+  char far *pktdrvfunc = (char far *)MK_FP(pktdrvfuncseg, pktdrvfuncoffs);
+  int i;
+  char sig[8];
+  /* preload sig with "PKT DRVR" -- I could it just as well with
+   * char sig[] = "PKT DRVR", but I want to avoid this landing in
+   * my DATA segment so it doesn't pollute the TSR memory space. */
+  sig[0] = 'P';
+  sig[1] = 'K';
+  sig[2] = 'T';
+  sig[3] = ' ';
+  sig[4] = 'D';
+  sig[5] = 'R';
+  sig[6] = 'V';
+  sig[7] = 'R';
+
+  /* set my ethertype to 0xF5ED (EDF5 in network byte order) */
+  glob_pktdrv_sndbuff[12] = 0xED;
+  glob_pktdrv_sndbuff[13] = 0xF5;
+  /* set the protover field in send buffer (I won't touch it again) */
+  glob_pktdrv_sndbuff[56] = PROTOVER; /* protocol version */
+
+  pktdrvfunc += 3; /* skip three bytes of executable code */
+  for (i = 0; i < 8; i++) if (sig[i] != pktdrvfunc[i]) return(-1);
+
+  glob_data.pktint = pktintparam;
+
+  /* fetch the vector of the pktdrv interrupt and save it for later */
+  _asm {
+    mov ah, 35h /* AH=GetVect */
+    mov al, byte ptr [glob_data] + GLOB_DATOFF_PKTINT; /* AL=int number */
+    push es /* save ES and BX (will be overwritten) */
+    push bx
+    int 21h
+    mov rseg, es
+    mov roff, bx
+    pop bx
+    pop es
+  }
+  glob_pktdrv_pktcall = rseg;
+  glob_pktdrv_pktcall <<= 16;
+  glob_pktdrv_pktcall |= roff;
+
+  return(pktdrv_accesstype());
+}
+
+
+static void pktdrv_free(unsigned long pktcall) {
+  _asm {
+    mov ah, 3
+    mov bx, word ptr [glob_data + GLOB_DATOFF_PKTHANDLE]
+    /* int to variable vector is a mess, so I have fetched its vector myself
+     * and pushf + cli + call far it now to simulate a regular int */
+    pushf
+    cli
+    call dword ptr glob_pktdrv_pktcall
+  }
+  /* if (regs.x.cflag != 0) return(-1);
+  return(0);*/
+}
+
+static struct sdastruct far *getsda(void) {
+  /* DOS 3.0+ - GET ADDRESS OF SDA (Swappable Data Area)
+   * AX = 5D06h
+   *
+   * CF set on error (AX=error code)
+   * DS:SI -> sda pointer
+   */
+  unsigned short rds = 0, rsi = 0;
+  _asm {
+    mov ax, 5d06h
+    push ds
+    push si
+    int 21h
+    mov bx, ds
+    mov cx, si
+    pop si
+    pop ds
+    mov rds, bx
+    mov rsi, cx
+  }
+  return(MK_FP(rds, rsi));
+}
+
+/* returns the CDS struct for drive. requires DOS 4+ */
+static struct cdsstruct far *getcds(unsigned int drive) {
+  /* static to preserve state: only do init once */
+  static unsigned char far *dir;
+  static int ok = -1;
+  static unsigned char lastdrv;
+  /* init of never inited yet */
+  if (ok == -1) {
+    /* DOS 3.x+ required - no CDS in earlier versions */
+    ok = 1;
+    /* offsets of CDS and lastdrv in the List of Lists depends on the DOS version:
+     * DOS < 3   no CDS at all
+     * DOS 3.0   lastdrv at 1Bh, CDS pointer at 17h
+     * DOS 3.1+  lastdrv at 21h, CDS pointer at 16h */
+    /* fetch lastdrv and CDS through a little bit of inline assembly */
+    _asm {
+      push si /* SI needs to be preserved */
+      /* get the List of Lists into ES:BX */
+      mov ah, 52h
+      int 21h
+      /* get the LASTDRIVE value */
+      mov si, 21h /* 21h for DOS 3.1+, 1Bh on DOS 3.0 */
+      mov ah, byte ptr es:[bx+si]
+      mov lastdrv, ah
+      /* get the CDS */
+      mov si, 16h /* 16h for DOS 3.1+, 17h on DOS 3.0 */
+      les bx, es:[bx+si]
+      mov word ptr dir+2, es
+      mov word ptr dir, bx
+      /* restore the original SI value*/
+      pop si
+    }
+    /* some OSes (at least OS/2) set the CDS pointer to FFFF:FFFF */
+    if (dir == (unsigned char far *) -1l) ok = 0;
+  } /* end of static initialization */
+  if (ok == 0) return(NULL);
+  if (drive > lastdrv) return(NULL);
+  /* return the CDS array entry for drive - note that currdir_size depends on
+   * DOS version: 0x51 on DOS 3.x, and 0x58 on DOS 4+ */
+  return((struct cdsstruct __far *)((unsigned char __far *)dir + (drive * 0x58 /*currdir_size*/)));
+}
+/******* end of CDS-related stuff *******/
+
+/* primitive BIOS-based message output used instead of printf() to limit
+ * memory usage and binary size */
+static void outmsg(char *s) {
+  _asm {
+    mov ah, 9h  /* DOS 1+ - WRITE STRING TO STANDARD OUTPUT */
+    mov dx, s   /* small memory model: no need to set DS, 's' is an offset */
+    int 21h
+  }
+}
+
+/* zero out an object of l bytes */
+static void zerobytes(void *obj, unsigned short l) {
+  unsigned char *o = obj;
+  while (l-- != 0) {
+    *o = 0;
+    o++;
+  }
+}
+
+/* expects a hex string of exactly two chars "XX" and returns its value, or -1
+ * if invalid */
+static int hexpair2int(char *hx) {
+  unsigned char h[2];
+  unsigned short i;
+  /* translate hx[] to numeric values and validate */
+  for (i = 0; i < 2; i++) {
+    if ((hx[i] >= 'A') && (hx[i] <= 'F')) {
+      h[i] = hx[i] - ('A' - 10);
+    } else if ((hx[i] >= 'a') && (hx[i] <= 'f')) {
+      h[i] = hx[i] - ('a' - 10);
+    } else if ((hx[i] >= '0') && (hx[i] <= '9')) {
+      h[i] = hx[i] - '0';
+    } else { /* invalid */
+      return(-1);
+    }
+  }
+  /* compute the end result and return it */
+  i = h[0];
+  i <<= 4;
+  i |= h[1];
+  return(i);
+}
+
+/* translates a decimal ASCII string into its numeric value, or returns 0 if
+ * the string is empty, invalid or the value does not fit in 16 bits */
+static unsigned short dec2uint(char *s) {
+  unsigned long res = 0;
+  if (*s == 0) return(0);
+  for (; *s != 0; s++) {
+    if ((*s < '0') || (*s > '9')) return(0);
+    res *= 10;
+    res += *s - '0';
+    if (res > 0xFFFFu) return(0);
+  }
+  return((unsigned short)res);
+}
+
+/* translates an ASCII MAC address into a 6-bytes binary string */
+static int string2mac(unsigned char *d, char *mac) {
+  int i, v;
+  /* is it exactly 17 chars long? */
+  for (i = 0; mac[i] != 0; i++);
+  if (i != 17) return(-1);
+  /* are nibble pairs separated by colons? */
+  for (i = 2; i < 16; i += 3) if (mac[i] != ':') return(-1);
+  /* translate each byte to its numeric value */
+  for (i = 0; i < 16; i += 3) {
+    v = hexpair2int(mac + i);
+    if (v < 0) return(-1);
+    *d = v;
+    d++;
+  }
+  return(0);
+}
+
+
+#define ARGFL_QUIET 1
+#define ARGFL_AUTO 2
+#define ARGFL_UNLOAD 4
+#define ARGFL_COMPRESS 8
+#define ARGFL_STATS 16
+#define ARGFL_LATENCY 32
+#define ARGFL_PRINTLAT 64
+#define ARGFL_DUMPTRACE 128
+#define ARGFL_LOWMEM 256
+
+/* a structure used to pass and decode arguments between main() and parseargv() */
+struct argstruct {
+  int argc;    /* original argc */
+  char **argv; /* original argv */
+  unsigned short pktint; /* custom packet driver interrupt */
+  unsigned short framesize; /* frame size forced by the user (0 = auto) */
+  unsigned short rxslots; /* amount of slots in the receive ring */
+  unsigned short racaches; /* amount of read-ahead buffers */
+  unsigned short wbcaches; /* amount of write-back buffers */
+  unsigned short mdttl; /* lifetime of metadata cache entries, in seconds */
+  unsigned short tracemax; /* amount of records in the trace ring (0 = none) */
+  char *tracefile; /* file to dump the trace ring to (/t=FILE) */
+  unsigned char srvcount; /* amount of servers in glob_srvmac */
+  unsigned short flags; /* ARGFL_QUIET, ARGFL_AUTO, ARGFL_COMPRESS, ARGFL_LATENCY... */
+};
+
+
+/* parses (and applies) command-line arguments. returns 0 on success,
+ * non-zero otherwise */
+static int parseargv(struct argstruct *args) {
+  /* Syntax: etherdfs SRVMAC [MAC/]rdrive-ldrive [options] */
+  int i, drivemapflag = 0;
+  /* if only one argument given, it must be /u, /s, /l or /t=FILE */
+  if (args->argc == 2) {
+    /* must start with a '/' */
+    if ((args->argv[1][0] != '/') || (args->argv[1][1] == 0)) return(-1);
+    /* is it /t=FILE ? */
+    if (((args->argv[1][1] == 't') || (args->argv[1][1] == 'T')) && (args->argv[1][2] == '=') && (args->argv[1][3] != 0)) {
+      args->flags = ARGFL_DUMPTRACE;
+      args->tracefile = args->argv[1] + 3;
+      return(0);
+    }
+    /* otherwise it must be two characters long */
+    if (args->argv[1][2] != 0) return(-1);
+    /* is it /u ? */
+    if ((args->argv[1][1] == 'u') || (args->argv[1][1] == 'U')) {
+      args->flags = ARGFL_UNLOAD;
+      return(0);
+    }
+    /* is it /s ? */
+    if ((args->argv[1][1] == 's') || (args->argv[1][1] == 'S')) {
+      args->flags = ARGFL_STATS;
+      return(0);
+    }
+    /* is it /l ? */
+    if ((args->argv[1][1] == 'l') || (args->argv[1][1] == 'L')) {
+      args->flags = ARGFL_PRINTLAT;
+      return(0);
+    }
+    /* otherwise I don't care */
+    return(-1);
+  }
+
+  /* I require at least 2 arguments */
+  if (args->argc < 3) return(-1);
+  /* read the srv mac address, unless it's "::" (auto) - in which case the
+   * broadcast address is used until the server answers */
+  if ((args->argv[1][0] == ':') && (args->argv[1][1] == ':') && (args->argv[1][2] == 0)) {
+    args->flags |= ARGFL_AUTO;
+    for (i = 0; i < 6; i++) glob_srvmac[0][i] = 0xff;
+  } else {
+    if (string2mac(glob_srvmac[0], args->argv[1]) != 0) return(-1);
+  }
+  args->srvcount = 1;
+
+  /* iterate through options, if any */
+  for (i = 2; i < args->argc; i++) {
+    char opt;
+    char *arg;
+    char *map = args->argv[i];
+    unsigned char srv, pri = 0, prev = 0xff;
+    /* a drive mapping may come with a server of its own, like
+     * "AA:BB:CC:DD:EE:FF/c-x", or with a server followed by its replicas (in
+     * the order they should be tried), like "AA:BB:CC:DD:EE:FF+11:22:33:44:55:66/c-x" */
+    while ((mystrlen(map) > 18) && ((map[17] == '/') || (map[17] == '+'))) {
+      char mac[18];
+      unsigned char bin[6], z;
+      copybytes(mac, map, 17);
+      mac[17] = 0;
+      if (string2mac(bin, mac) != 0) return(-2);
+      /* is it a server I know already? */
+      for (srv = 0; srv < args->srvcount; srv++) {
+        for (z = 0; (z < 6) && (glob_srvmac[srv][z] == bin[z]); z++);
+        if (z == 6) break;
+      }
+      if (srv == args->srvcount) { /* no, it's a new one */
+        if (args->srvcount == SRVMAX) return(-2);
+        copybytes(glob_srvmac[srv], bin, 6);
+        args->srvcount++;
+      }
+      if (prev == 0xff) {
+        pri = srv;
+      } else if (glob_srvnext[prev] != srv) {
+        /* a server has the same replicas wherever it is used, and the list
+         * can't loop back to a server that is in it already */
+        if (glob_srvnext[prev] != 0xff) return(-2);
+        for (z = srv; (z != 0xff) && (z != prev); z = glob_srvnext[z]);
+        if (z == prev) return(-2);
+        glob_srvnext[prev] = srv;
+      }
+      prev = srv;
+      map += 18;
+      if (map[-1] == '/') break;
+    }
+    /* is it a drive mapping, like "c-x"? */
+    if ((map[0] >= 'A') && (map[1] == '-') && (map[2] >= 'A') && (map[3] == 0)) {
+      unsigned char ldrv, rdrv;
+      rdrv = DRIVETONUM(map[0]);
+      ldrv = DRIVETONUM(map[2]);
+      if ((ldrv > 25) || (rdrv > 25)) return(-2);
+      if (glob_data.ldrv[ldrv] != 0xff) return(-2);
+      glob_data.ldrv[ldrv] = rdrv;
+      glob_drvsrv[ldrv] = pri;
+      glob_drvpri[ldrv] = pri;
+      drivemapflag = 1;
+      continue;
+    }
+    if (map != args->argv[i]) return(-2); /* a server address without mapping */
+    /* not a drive mapping -> check for options */
+    if ((args->argv[i][0] != '/') || (args->argv[i][1] == 0)) return(-3);
+    opt = args->argv[i][1];
+    /* fetch option's argument, if any */
+    if (args->argv[i][2] == 0) { /* single option */
+      arg = NULL;
+    } else if (args->argv[i][2] == '=') { /* trailing argument */
+      arg = args->argv[i] + 3;
+    } else {
+      return(-3);
+    }
+    /* normalize the option char to lower case */
+    if ((opt >= 'A') && (opt <= 'Z')) opt += ('a' - 'A');
+    /* what is the option about? */
+    switch (opt) {
+      case 'a':
+        if (arg == NULL) return(-4);
+        args->mdttl = dec2uint(arg);
+        if ((args->mdttl == 0) && ((arg[0] != '0') || (arg[1] != 0))) return(-4);
+        if (args->mdttl > MDTTLMAX) return(-4);
+        break;
+      case 'c':
+        if (arg != NULL) return(-4);
+        args->flags |= ARGFL_LOWMEM;
+        break;
+      case 'l':
+        if (arg != NULL) return(-4);
+        args->flags |= ARGFL_LATENCY;
+        break;
+      case 'q':
+        if (arg != NULL) return(-4);
+        args->flags |= ARGFL_QUIET;
+        break;
+      case 'p':
+        if (arg == NULL) return(-4);
+        /* I expect an exactly 2-characters string */
+        if ((arg[0] == 0) || (arg[1] == 0) || (arg[2] != 0)) return(-1);
+        if ((args->pktint = hexpair2int(arg)) < 1) return(-4);
+        break;
+      case 'b':
+        if (arg == NULL) return(-4);
+        args->rxslots = dec2uint(arg);
+        if ((args->rxslots < 1) || (args->rxslots > RXSLOTSMAX)) return(-4);
+        break;
+      case 'r':
+        if (arg == NULL) return(-4);
+        args->racaches = dec2uint(arg);
+        if ((args->racaches == 0) && ((arg[0] != '0') || (arg[1] != 0))) return(-4);
+        if (args->racaches > RACACHEMAX) return(-4);
+        break;
+      case 't':
+        if (arg == NULL) return(-4);
+        args->tracemax = dec2uint(arg);
+        if ((args->tracemax < 1) || (args->tracemax > TRACEMAX)) return(-4);
+        break;
+      case 'w':
+        if (arg == NULL) return(-4);
+        args->wbcaches = dec2uint(arg);
+        if ((args->wbcaches == 0) && ((arg[0] != '0') || (arg[1] != 0))) return(-4);
+        if (args->wbcaches > WBCACHEMAX) return(-4);
+        break;
+      case 'z':
+        if (arg != NULL) return(-4);
+        args->flags |= ARGFL_COMPRESS;
+        break;
+      case 'f':
+        if (arg == NULL) return(-4);
+        args->framesize = dec2uint(arg);
+        if ((args->framesize < FRAMESIZEMIN) || (args->framesize > FRAMESIZEMAX)) return(-4);
+        break;
+      default: /* invalid parameter */
+        return(-5);
+    }
+  }
+  /* did I get at least one drive mapping? */
+  if (drivemapflag == 0) return(-6);
+  return(0);
+}
+
+/* translates an unsigned byte into a 2-characters string containing its hex
+ * representation. s needs to be at least 3 bytes long. */
+static void byte2hex(char *s, unsigned char b) {
+  char h[16];
+  unsigned short i;
+  /* pre-compute h[] with a string 0..F -- I could do the same thing easily
+   * with h[] = "0123456789ABCDEF", but then this would land inside the DATA
+   * segment, while I want to keep it in stack to avoid polluting the TSR's
+   * memory space */
+  for (i = 0; i < 10; i++) h[i] = '0' + i;
+  for (; i < 16; i++) h[i] = ('A' - 10) + i;
+  /* */
+  s[0] = h[b >> 4];
+  s[1] = h[b & 15];
+  s[2] = 0;
+}
+
+/* tells that option /opt had to be reduced to n, since buffers would not fit
+ * in DATASEGMAX otherwise */
+static void reducedopt(char opt, unsigned short n) {
+  char buff[6];
+  #include "msg\\bufrdcd.c"
+  buff[0] = opt;
+  buff[1] = '=';
+  buff[2] = '0' + n;
+  buff[3] = '\r';
+  buff[4] = '\n';
+  buff[5] = '$';
+  outmsg(buff);
+}
+
+/* writes v in decimal into the w bytes at s, right-aligned and padded with
+ * spaces (w must be at least 10 so any value fits). no terminator is added */
+static void ul2dec(char *s, unsigned long v, unsigned short w) {
+  do {
+    s[--w] = '0' + (unsigned char)(v % 10);
+    v /= 10;
+  } while (v != 0);
+  while (w != 0) s[--w] = ' ';
+}
+
+/* outputs v in decimal, followed by a line break */
+static void outul(unsigned long v) {
+  char buff[13];
+  unsigned short i;
+  ul2dec(buff, v, 10);
+  for (i = 0; buff[i] == ' '; i++);
+  buff[10] = '\r';
+  buff[11] = '\n';
+  buff[12] = '$';
+  outmsg(buff + i);
+}
+
+/* prints the counters of a loaded EtherDFS (see MPX_GETSTATS) */
+static void printstats(struct mpxstats far *st) {
+  char buff[18];
+  unsigned short i, n = 0;
+  #include "msg\\statcall.c"
+  /* subfunctions that have been called at all, four per line */
+  for (i = 0; i < 0x2F; i++) {
+    if (st->calls[i] == 0) continue;
+    buff[0] = ' ';
+    buff[1] = ' ';
+    byte2hex(buff + 2, (unsigned char)i);
+    buff[4] = 'h';
+    buff[5] = ':';
+    ul2dec(buff + 6, st->calls[i], 10);
+    buff[16] = ' ';
+    buff[17] = '$';
+    outmsg(buff);
+    n++;
+    if ((n & 3) == 0) {
+      buff[0] = '\r';
+      buff[1] = '\n';
+      buff[2] = '$';
+      outmsg(buff);
+    }
+  }
+  if ((n & 3) != 0) {
+    buff[0] = '\r';
+    buff[1] = '\n';
+    buff[2] = '$';
+    outmsg(buff);
+  }
+  #include "msg\\statrd.c"
+  outul(st->rdbytes);
+  #include "msg\\statwr.c"
+  outul(st->wrbytes);
+  #include "msg\\stattx.c"
+  outul(st->txframes);
+  #include "msg\\statrx.c"
+  outul(st->rxframes);
+  #include "msg\\statrexm.c"
+  outul(st->rexmits);
+  #include "msg\\statto.c"
+  outul(st->timeouts);
+  #include "msg\\statign.c"
+  outul(st->rxignored);
+  #include "msg\\statbusy.c"
+  outul(st->rxbusy);
+}
+
+/* prints the latency histograms of a loaded EtherDFS (see MPX_GETHIST): a
+ * line for every duration bucket that some call fell into, with the amount
+ * of calls that spent that long on the network, and locally */
+static void printhist(struct mpxhist far *h) {
+  char buff[39];
+  unsigned short al, b, i, first;
+  #include "msg\\histhdr.c"
+  for (al = 0; al < 0x2F; al++) {
+    first = 1;
+    for (b = 0; b < MPXHISTBUCKETS; b++) {
+      if ((h[al].net[b] == 0) && (h[al].local[b] == 0)) continue;
+      buff[0] = ' ';
+      buff[1] = ' ';
+      buff[2] = ' ';
+      if (first != 0) {
+        byte2hex(buff, (unsigned char)al);
+        buff[2] = 'h';
+        first = 0;
+      }
+      /* upper bound of the bucket in microseconds (the last one has none,
+       * its lower bound is shown instead) */
+      i = (b < MPXHISTBUCKETS - 1)?b:(b - 1);
+      ul2dec(buff + 3, ((1lu << i) * 54925lu) >> 10, 11);
+      for (i = 3; buff[i + 1] == ' '; i++);
+      buff[i] = (b < MPXHISTBUCKETS - 1)?'<':'>';
+      ul2dec(buff + 14, h[al].net[b], 11);
+      ul2dec(buff + 25, h[al].local[b], 11);
+      buff[36] = '\r';
+      buff[37] = '\n';
+      buff[38] = '$';
+      outmsg(buff);
+    }
+  }
+}
+
+/* asks the loaded EtherDFS (at multiplex id) for the pointer that multiplex
+ * call func returns in BX:CX. returns NULL on failure, with *err set to the
+ * AX value returned (0xffff if the call did not happen at all) */
+static void far *mpxgetptr(unsigned char id, unsigned char func, unsigned short *err) {
+  unsigned short myseg = 0, myoff = 0, myax = 0xffffu;
+  _asm {
+    push ax
+    push bx
+    push cx
+    pushf
+    mov ah, id
+    mov al, func
+    mov cx, MPXSIG
+    int 2Fh /* AX should be 0, and BX:CX contains the address */
+    mov myax, ax
+    test ax, ax
+    jnz fail
+    mov myseg, bx
+    mov myoff, cx
+    fail:
+    popf
+    pop cx
+    pop bx
+    pop ax
+  }
+  *err = myax;
+  if (myax != 0) return(NULL);
+  return(MK_FP(myseg, myoff));
+}
+
+/* creates (or truncates) the file fname, returns its handle or 0xffff */
+static unsigned short dosfcreate(char *fname) {
+  unsigned short res = 0xffffu;
+  _asm {
+    push ax
+    push cx
+    push dx
+    mov ah, 3Ch
+    xor cx, cx  /* no attributes */
+    mov dx, fname
+    int 21h
+    jc createfail
+    mov res, ax
+    createfail:
+    pop dx
+    pop cx
+    pop ax
+  }
+  return(res);
+}
+
+/* writes len bytes from buf to the file fh, returns 0 on success */
+static int dosfwrite(unsigned short fh, void far *buf, unsigned short len) {
+  unsigned short bufseg = FP_SEG(buf), bufoff = FP_OFF(buf), res = 0xffffu;
+  _asm {
+    push ax
+    push bx
+    push cx
+    push dx
+    push ds
+    mov bx, fh
+    mov cx, len
+    mov dx, bufoff
+    mov ax, bufseg
+    mov ds, ax
+    mov ah, 40h
+    int 21h
+    pop ds
+    jc writefail
+    mov res, ax
+    writefail:
+    pop dx
+    pop cx
+    pop bx
+    pop ax
+  }
+  return((res == len)?0:-1);
+}
+
+/* closes the file fh */
+static void dosfclose(unsigned short fh) {
+  _asm {
+    push ax
+    push bx
+    mov ah, 3Eh
+    mov bx, fh
+    int 21h
+    pop bx
+    pop ax
+  }
+}
+
+/* returns the entry point of the XMS driver, or 0 if there is none */
+static unsigned long xmsentry(void) {
+  unsigned short entseg = 0, entoff = 0;
+  _asm {
+    push ax
+    push bx
+    push es
+    mov ax, 4300h  /* XMS installation check */
+    int 2Fh
+    cmp al, 80h
+    jne noxms
+    mov ax, 4310h  /* get XMS driver entry point (ES:BX) */
+    int 2Fh
+    mov entseg, es
+    mov entoff, bx
+    noxms:
+    pop es
+    pop bx
+    pop ax
+  }
+  return(((unsigned long)entseg << 16) | entoff);
+}
+
+/* allocates a block of kb KiB of XMS, returns its handle or 0 on error */
+static unsigned short xmsalloc(unsigned long entry, unsigned short kb) {
+  unsigned short handle = 0;
+  _asm {
+    push ax
+    push dx
+    mov ah, 09h  /* XMS: allocate extended memory block */
+    mov dx, kb
+    call dword ptr entry
+    test ax, ax
+    jz allocfail
+    mov handle, dx
+    allocfail:
+    pop dx
+    pop ax
+  }
+  return(handle);
+}
+
+/* frees the XMS block of handle */
+static void xmsfree(unsigned short handle) {
+  unsigned long entry = xmsentry();
+  if (entry == 0) return;
+  _asm {
+    push ax
+    push dx
+    mov ah, 0Ah  /* XMS: free extended memory block */
+    mov dx, handle
+    call dword ptr entry
+    pop dx
+    pop ax
+  }
+}
+
+/* copies len bytes at offset offs of the XMS block of handle into dst.
+ * returns 0 on success */
+static int xmsget(unsigned short handle, unsigned long offs, void *dst, unsigned short len) {
+  struct xmsmove mv;
+  struct xmsmove *mvptr = &mv;
+  unsigned long entry = xmsentry();
+  unsigned short res = 0;
+  if (entry == 0) return(-1);
+  mv.len = len;
+  mv.srchandle = handle;
+  mv.srcoff = offs;
+  mv.dsthandle = 0;
+  mv.dstoff = ((unsigned long)FP_SEG((void far *)dst) << 16) | FP_OFF(dst);
+  _asm {
+    push ax
+    push bx
+    push si
+    mov ah, 0Bh  /* XMS: move extended memory block (DS:SI = struct xmsmove) */
+    mov si, mvptr
+    call dword ptr entry
+    mov res, ax  /* 1 on success */
+    pop si
+    pop bx
+    pop ax
+  }
+  return((res == 1)?0:-1);
+}
+
+/* writes n records of the trace ring hdr to the file fh, starting with the
+ * record first. returns 0 on success */
+static int dumprecs(unsigned short fh, struct mpxtracehdr far *hdr, unsigned short first, unsigned short n) {
+  struct mpxtrace rec;
+  if (hdr->xms == 0) {
+    return(dosfwrite(fh, MK_FP(FP_SEG(hdr), sizeof(struct mpxtracehdr) + (first * sizeof(struct mpxtrace))), n * sizeof(struct mpxtrace)));
+  }
+  /* records in XMS go through conventional memory, one at a time */
+  for (; n != 0; n--, first++) {
+    if (xmsget(hdr->xms, (unsigned long)first * sizeof(struct mpxtrace), &rec, sizeof(rec)) != 0) return(-1);
+    if (dosfwrite(fh, &rec, sizeof(rec)) != 0) return(-1);
+  }
+  return(0);
+}
+
+/* writes the trace ring of a loaded EtherDFS (see MPX_GETTRACE) into the file
+ * fname, oldest record first, in the format described in trace.txt. Tracing
+ * is paused meanwhile, since the file might be on an EtherDFS drive. returns
+ * the amount of records written, or -1 on error */
+static long dumptrace(char *fname, struct mpxtracehdr far *hdr) {
+  unsigned char fhdr[16];
+  unsigned short fh, count, first, part;
+  unsigned long lost;
+  int err;
+  hdr->paused = 1;
+  /* once the ring has wrapped, the oldest record is the next one to go */
+  if (hdr->total > hdr->max) {
+    count = hdr->max;
+    first = hdr->next;
+  } else {
+    count = (unsigned short)hdr->total;
+    first = 0;
+  }
+  lost = hdr->total - count;
+  /* file header: "EDFTRC", version, record size, records, records lost */
+  fhdr[0] = 'E';
+  fhdr[1] = 'D';
+  fhdr[2] = 'F';
+  fhdr[3] = 'T';
+  fhdr[4] = 'R';
+  fhdr[5] = 'C';
+  fhdr[6] = 1;
+  fhdr[7] = sizeof(struct mpxtrace);
+  *((unsigned long *)(fhdr + 8)) = count;
+  *((unsigned long *)(fhdr + 12)) = lost;
+  fh = dosfcreate(fname);
+  if (fh == 0xffffu) {
+    hdr->paused = 0;
+    return(-1);
+  }
+  err = dosfwrite(fh, fhdr, 16);
+  /* records from the oldest one to the end of the ring, then from the
+   * beginning of the ring (if it wrapped) */
+  part = hdr->max - first;
+  if (part > count) part = count;
+  if ((err == 0) && (part != 0)) err = dumprecs(fh, hdr, first, part);
+  if ((err == 0) && (count > part)) err = dumprecs(fh, hdr, 0, count - part);
+  dosfclose(fh);
+  hdr->paused = 0;
+  if (err != 0) return(-1);
+  return(count);
+}
+
+/* allocation strategies of allocseg() */
+#define ALLOC_FIRSTFIT 0x00 /* lowest possible, for blocks freed before going TSR */
+#define ALLOC_LASTFIT  0x02 /* highest possible, to avoid memory fragmentation */
+#define ALLOC_UMBFIRST 0x82 /* same, but in upper memory if there is room there */
+
+/* allocates sz bytes of memory and returns the segment to allocated memory or
+ * 0 on error. blocks that stay allocated once I am resident should be
+ * allocated 'highest possible' (ALLOC_LASTFIT) to avoid memory fragmentation.
+ * with ALLOC_UMBFIRST, upper memory blocks are linked for the time of the
+ * allocation and tried first, so the segment ends up in upper memory if
+ * there is room enough there */
+static unsigned short allocseg(unsigned short sz, unsigned char strategy) {
+  unsigned short volatile res = 0;
+  /* sz should contains number of 16-byte paragraphs instead of bytes */
+  sz += 15; /* make sure to allocate enough paragraphs */
+  sz >>= 4;
+  /* ask DOS for memory */
+  _asm {
+    push cx /* save cx */
+    push dx /* save dx */
+    /* remember the current strategy and UMB link state */
+    mov ax, 5800h /* get strategy */
+    int 21h       /* now current strategy is in ax */
+    mov cx, ax    /* copy current strategy to cx */
+    mov ax, 5802h /* get UMB link state (DOS 5+) */
+    int 21h
+    mov dl, al    /* copy current link state to dl */
+    /* link UMBs if they are to be tried first (this fails harmlessly if
+     * there are none) */
+    test strategy, 80h
+    jz setstrategy
+    mov ax, 5803h
+    mov bx, 1
+    int 21h
+    setstrategy:
+    mov ax, 5801h /* set strategy (0 = first fit, 2 = last fit, +80h = high memory first) */
+    xor bh, bh
+    mov bl, strategy
+    int 21h
+    /* do the allocation now */
+    mov ah, 48h     /* alloc memory (DOS 2+) */
+    mov bx, sz      /* number of paragraphs to allocate */
+    mov res, 0      /* pre-set res to failure (0) */
+    int 21h         /* returns allocated segment in AX */
+    /* check CF */
+    jc failed
+    mov res, ax     /* set res to actual result */
+    failed:
+    /* set strategy and UMB link state back to their initial settings */
+    mov ax, 5801h
+    mov bx, cx
+    int 21h
+    mov ax, 5803h
+    xor bh, bh
+    mov bl, dl
+    int 21h
+    pop dx    /* restore dx */
+    pop cx    /* restore cx */
+  }
+  return(res);
+}
+
+/* free segment previously allocated through allocseg() */
+static void freeseg(unsigned short segm) {
+  _asm {
+    mov ah, 49h   /* free memory (DOS 2+) */
+    mov es, segm  /* put segment to free into ES */
+    int 21h
+  }
+}
+
+/* frees the trace ring, be it in its own segment (glob_traceseg) or in the
+ * XMS block xmshandle */
+static void tracefree(unsigned short xmshandle) {
+  if (glob_traceseg != 0) freeseg(glob_traceseg);
+  if (xmshandle != 0) xmsfree(xmshandle);
+}
+
+/* end of DGROUP, as set by the linker: my data (resident or not) lies below
+ * it, and the stack of the transient part (-k1024) right above */
+extern unsigned char dgroupend;
+#pragma aux dgroupend "_end";
+
+/* copies the first DATASEGSZ bytes of my current DS (that is all my data
+ * along with the stack) into the segment newds, and switches both DS and SS
+ * to it. the TSR routines are not patched (see updatetsrds()) */
+static void switchds(unsigned short newds) {
+  _asm {
+    /* save registers on the stack */
+    push es
+    push cx
+    push si
+    push di
+    pushf
+    /* copy the memory block */
+    mov cx, DATASEGSZ  /* copy cx bytes */
+    xor si, si         /* si = 0*/
+    xor di, di         /* di = 0 */
+    cld                /* clear direction flag (increment si/di) */
+    mov es, newds      /* load es with newds */
+    rep movsb          /* execute copy DS:SI -> ES:DI */
+    /* restore registers (but NOT es, instead save it into AX for now) */
+    popf
+    pop di
+    pop si
+    pop cx
+    pop ax
+    /* switch to the new DS _AND_ SS now */
+    push es
+    push es
+    pop ds
+    pop ss
+    /* restore ES */
+    push ax
+    pop es
+  }
+}
+
+/* looks for the 4-bytes signature sig within the first 64 bytes of the
+ * routine at ptr. returns a pointer to the signature, or NULL if not found */
+static unsigned char far *findsig(unsigned char far *ptr, char *sig) {
+  int i;
+  for (i = 0; i < 64; i++) {
+    if ((ptr[i] == sig[0]) && (ptr[i + 1] == sig[1]) && (ptr[i + 2] == sig[2]) && (ptr[i + 3] == sig[3])) return(ptr + i);
+  }
+  return(NULL);
+}
+
+/* patch the TSR routines and packet driver handler so they use my new DS.
+ * return 0 on success, non-zero otherwise */
+static int updatetsrds(void) {
+  unsigned short newds;
+  unsigned char far *ptr;
+  unsigned short far *sptr;
+  newds = 0;
+  _asm {
+    push ds
+    pop newds
+  }
+
+  /* first patch the TSR routine */
+  ptr = (unsigned char far *)inthandler + 24; /* the interrupt handler's signature appears at offset 23 (this might change at each source code modification and/or optimization settings) */
+  /*{
+    int x;
+    unsigned short far *VGA = (unsigned short far *)(0xB8000000l);
+    for (x = 0; x < 128; x++) VGA[80*12 + ((x >> 6) * 80) + (x & 63)] = 0x1f00 | ptr[x];
+  }*/
+  sptr = (unsigned short far *)ptr;
+  /* check for the routine's signature first ("MVet") */
+  if ((ptr[0] != 'M') || (ptr[1] != 'V') || (ptr[2] != 'e') || (ptr[3] != 't')) return(-1);
+  sptr[3] = newds;
+  /* now patch the pktdrv_recv() routine */
+  ptr = (unsigned char far *)pktdrv_recv + 3;
+  sptr = (unsigned short far *)ptr;
+  /*{
+    int x;
+    unsigned short far *VGA = (unsigned short far *)(0xB8000000l);
+    for (x = 0; x < 128; x++) VGA[80*12 + ((x >> 6) * 80) + (x & 63)] = 0x1f00 | ptr[x];
+  }*/
+  /* check for the routine's signature first */
+  if ((ptr[0] != 'p') || (ptr[1] != 'k') || (ptr[2] != 't') || (ptr[3] != 'r')) return(-1);
+  sptr[4] = newds;
+  /* and the idlehandler() routine */
+  ptr = findsig((unsigned char far *)idlehandler, "MVid");
+  if (ptr == NULL) return(-1);
+  sptr = (unsigned short far *)ptr;
+  sptr[3] = newds;
+  /*{
+    int x;
+    unsigned short far *VGA = (unsigned short far *)(0xB8000000l);
+    for (x = 0; x < 128; x++) VGA[80*20 + ((x >> 6) * 80) + (x & 63)] = 0x1f00 | ptr[x];
+  }*/
+  return(0);
+}
+
+/* returns the CPU family: 0 for an 8086 (or 8088, 80186...), 2 for a 286
+ * and 3 for a 386 or better */
+static unsigned char cputype(void) {
+  unsigned char res = 0;
+  _asm {
+    push ax
+    pushf
+    /* an 8086 pushes SP as it is after the push, a 286+ as it was before */
+    push sp
+    pop ax
+    cmp ax, sp
+    jne cpudone
+    mov res, 2
+    /* IOPL and NT (bits 12-14 of FLAGS) cannot be set in real mode on a 286 */
+    pushf
+    pop ax
+    or ax, 7000h
+    push ax
+    popf
+    pushf
+    pop ax
+    test ax, 7000h
+    jz cpudone
+    mov res, 3
+    cpudone:
+    popf
+    pop ax
+  }
+  return(res);
+}
+
+/* patches copybytes() so it copies dwords on a 386+ (8086 and 286 keep the
+ * word variant it is built with). The patch is done in place, so the TSR
+ * takes no more memory either way */
+static void cpupatch(void) {
+  unsigned char far *ptr;
+  if (cputype() < 3) return;
+  ptr = findsig((unsigned char far *)copybytes, "MVcp");
+  if (ptr == NULL) return;
+  /* make sure the code is laid out as expected (NOP NOP NOP ... AND CX,1) */
+  if ((ptr[6] != 0x90) || (ptr[7] != 0x90) || (ptr[8] != 0x90) || (ptr[13] != 0x83) || (ptr[15] != 1)) return;
+  ptr[6] = 0xD1;  /* shr cx, 1 */
+  ptr[7] = 0xE9;
+  ptr[8] = 0x66;  /* operand size prefix: rep movsw -> rep movsd */
+  ptr[15] = 3;    /* and cx, 3 */
+}
+
+/* scans the 2Fh interrupt for some available 'multiplex id' in the range
+ * C0..FF. also checks for EtherDFS presence at the same time. returns:
+ *  - the available id if found
+ *  - the id of the already-present etherdfs instance
+ *  - 0 if no available id found
+ * presentflag set to 0 if no etherdfs found loaded, non-zero otherwise. */
+static unsigned char findfreemultiplex(unsigned char *presentflag) {
+  unsigned char id = 0, freeid = 0, pflag = 0;
+  _asm {
+    mov id, 0C0h /* start scanning at C0h */
+    checkid:
+    xor al, al   /* subfunction is 'installation check' (00h) */
+    mov ah, id
+    int 2Fh
+    /* is it free? (AL == 0) */
+    test al, al
+    jnz notfree    /* not free - is it me perhaps? */
+    mov freeid, ah /* it's free - remember it, I may use it myself soon */
+    jmp checknextid
+    notfree:
+    /* is it me? (AL=FF + BX=4D86 CX=7E1 [MV 2017]) */
+    cmp al, 0ffh
+    jne checknextid
+    cmp bx, 4d86h
+    jne checknextid
+    cmp cx, 7e1h
+    jne checknextid
+    /* if here, then it's me... */
+    mov ah, id
+    mov freeid, ah
+    mov pflag, 1
+    jmp gameover
+    checknextid:
+    /* if not me, then check next id */
+    inc id
+    jnz checkid /* if id is zero, then all range has been covered (C0..FF) */
+    gameover:
+  }
+  *presentflag = pflag;
+  return(freeid);
+}
+
+int main(int argc, char **argv) {
+  struct argstruct args;
+  struct cdsstruct far *cds;
+  unsigned char tmpflag = 0;
+  int i;
+  unsigned short tmpdataseg, newdataseg;
+  unsigned char memstrategy; /* how blocks that stay resident are allocated */
+  unsigned short xmshandle = 0; /* XMS block of the trace ring, if any */
+  unsigned long xmsent = 0;
+
+  /* set all drive mappings as 'unused', and servers as having no replicas
+   * and no measured round-trip */
+  for (i = 0; i < 26; i++) glob_data.ldrv[i] = 0xff;
+  for (i = 0; i < SRVMAX; i++) {
+    glob_srvnext[i] = 0xff;
+    glob_rto[i] = RTOINIT;
+  }
+
+  /* parse command-line arguments */
+  zerobytes(&args, sizeof(args));
+  args.argc = argc;
+  args.argv = argv;
+  args.rxslots = RXSLOTS;
+  args.racaches = RACACHES;
+  args.wbcaches = WBCACHES;
+  args.mdttl = MDTTL;
+  if (parseargv(&args) != 0) {
+    #include "msg/help.c"
+    return(1);
+  }
+
+  /* check DOS version - I require DOS 5.0+ */
+  _asm {
+    mov ax, 3306h
+    int 21h
+    mov tmpflag, bl
+    inc al /* if AL was 0xFF ("unsupported function"), it is 0 now */
+    jnz done
+    mov tmpflag, 0 /* if AL is 0 (hence was 0xFF), set dosver to 0 */
+    done:
+  }
+  if (tmpflag < 5) { /* tmpflag contains DOS version or 0 for 'unknown' */
+    #include "msg\\unsupdos.c"
+    return(1);
+  }
+
+  /* look whether or not it's ok to install a network redirector at int 2F */
+  _asm {
+    mov tmpflag, 0
+    mov ax, 1100h
+    int 2Fh
+    dec ax /* if AX was set to 1 (ie. "not ok to install"), it's zero now */
+    jnz goodtogo
+    mov tmpflag, 1
+    goodtogo:
+  }
+  if (tmpflag != 0) {
+    #include "msg\\noredir.c"
+    return(1);
+  }
+
+  /* is it about printing the counters (or the latency histograms) of the
+   * loaded instance, or about dumping its trace ring? */
+  if ((args.flags & (ARGFL_STATS | ARGFL_PRINTLAT | ARGFL_DUMPTRACE)) != 0) {
+    unsigned char etherdfsid;
+    unsigned short err;
+    void far *ptr;
+    long n;
+    etherdfsid = findfreemultiplex(&tmpflag);
+    if (tmpflag == 0) {
+      #include "msg\\notlds.c"
+      return(1);
+    }
+    if ((args.flags & ARGFL_STATS) != 0) {
+      ptr = mpxgetptr(etherdfsid, MPX_GETSTATS, &err);
+    } else if ((args.flags & ARGFL_PRINTLAT) != 0) {
+      ptr = mpxgetptr(etherdfsid, MPX_GETHIST, &err);
+      if (err == 1) {
+        #include "msg\\nohist.c"
+        return(1);
+      }
+    } else {
+      ptr = mpxgetptr(etherdfsid, MPX_GETTRACE, &err);
+      if (err == 1) {
+        #include "msg\\notrace.c"
+        return(1);
+      }
+    }
+    if (ptr == NULL) {
+      #include "msg\\tsrcomfa.c"
+      return(1);
+    }
+    if ((args.flags & ARGFL_STATS) != 0) {
+      printstats(ptr);
+    } else if ((args.flags & ARGFL_PRINTLAT) != 0) {
+      printhist(ptr);
+    } else {
+      n = dumptrace(args.tracefile, ptr);
+      if (n < 0) {
+        #include "msg\\trcfail.c"
+        return(1);
+      }
+      #include "msg\\trcdump.c"
+      outul(n);
+    }
+    return(0);
+  }
+
+  /* is it all about unloading myself? */
+  if ((args.flags & ARGFL_UNLOAD) != 0) {
+    unsigned char etherdfsid, pktint;
+    unsigned short myseg, myoff, myhandle, mydataseg;
+    unsigned long pktdrvcall;
+    struct tsrshareddata far *tsrdata;
+    unsigned char far *int2fptr;
+    void far *traceptr;
+    unsigned short err;
+
+    /* am I loaded at all? */
+    etherdfsid = findfreemultiplex(&tmpflag);
+    if (tmpflag == 0) { /* not loaded, cannot unload */
+      #include "msg\\notload.c"
+      return(1);
+    }
+    /* am I still at the top of the int 2Fh chain? */
+    _asm {
+      /* save AX, BX and ES */
+      push ax
+      push bx
+      push es
+      /* fetch int vector */
+      mov ax, 352Fh  /* AH=35h 'GetVect' for int 2Fh */
+      int 21h
+      mov myseg, es
+      mov myoff, bx
+      /* restore AX, BX and ES */
+      pop es
+      pop bx
+      pop ax
+    }
+    int2fptr = (unsigned char far *)MK_FP(myseg, myoff) + 24; /* the interrupt handler's signature appears at offset 24 (this might change at each source code modification) */
+    /* look for the "MVet" signature */
+    if ((int2fptr[0] != 'M') || (int2fptr[1] != 'V') || (int2fptr[2] != 'e') || (int2fptr[3] != 't')) {
+      #include "msg\\othertsr.c";
+      return(1);
+    }
+    /* same question for the int 28h chain */
+    _asm {
+      push ax
+      push bx
+      push es
+      mov ax, 3528h  /* AH=35h 'GetVect' for int 28h */
+      int 21h
+      mov myseg, es
+      mov myoff, bx
+      pop es
+      pop bx
+      pop ax
+    }
+    if (findsig((unsigned char far *)MK_FP(myseg, myoff), "MVid") == NULL) {
+      #include "msg\\othertsr.c";
+      return(1);
+    }
+    /* get the ptr to TSR's data */
+    _asm {
+      push ax
+      push bx
+      push cx
+      pushf
+      mov ah, etherdfsid
+      mov al, 1
+      mov cx, 4d86h
+      mov myseg, 0ffffh
+      int 2Fh /* AX should be 0, and BX:CX contains the address */
+      test ax, ax
+      jnz fail
+      mov myseg, bx
+      mov myoff, cx
+      mov mydataseg, dx
+      fail:
+      popf
+      pop cx
+      pop bx
+      pop ax
+    }
+    if (myseg == 0xffffu) {
+      #include "msg\\tsrcomfa.c"
+      return(1);
+    }
+    tsrdata = MK_FP(myseg, myoff);
+    mydataseg = myseg;
+    /* the trace ring (if any) is either in a segment of its own, or in XMS
+     * with only its header in the data segment (see below) */
+    traceptr = mpxgetptr(etherdfsid, MPX_GETTRACE, &err);
+    /* restore previous int 2f handler (under DS:DX, AH=25h, INT 21h)*/
+    myseg = tsrdata->prev_2f_handler_seg;
+    myoff = tsrdata->prev_2f_handler_off;
+    _asm {
+      /* save AX, DS and DX */
+      push ax
+      push ds
+      push dx
+      /* set DS:DX */
+      mov ax, myseg
+      push ax
+      pop ds
+      mov dx, myoff
+      /* call INT 21h,25h for int 2Fh */
+      mov ax, 252Fh
+      int 21h
+      /* restore AX, DS and DX */
+      pop dx
+      pop ds
+      pop ax
+    }
+    /* restore previous int 28h handler, too */
+    myseg = tsrdata->prev_28_handler_seg;
+    myoff = tsrdata->prev_28_handler_off;
+    _asm {
+      push ax
+      push ds
+      push dx
+      mov ax, myseg
+      push ax
+      pop ds
+      mov dx, myoff
+      mov ax, 2528h
+      int 21h
+      pop dx
+      pop ds
+      pop ax
+    }
+    /* get the address of the packet driver routine */
+    pktint = tsrdata->pktint;
+    _asm {
+      /* save AX, BX and ES */
+      push ax
+      push bx
+      push es
+      /* fetch int vector */
+      mov ah, 35h  /* AH=35h 'GetVect' */
+      mov al, pktint /* interrupt */
+      int 21h
+      mov myseg, es
+      mov myoff, bx
+      /* restore AX, BX and ES */
+      pop es
+      pop bx
+      pop ax
+    }
+    pktdrvcall = myseg;
+    pktdrvcall <<= 16;
+    pktdrvcall |= myoff;
+    /* unregister packet driver */
+    myhandle = tsrdata->pkthandle;
+    _asm {
+      /* save AX and BX */
+      push ax
+      push bx
+      /* prepare the release_type() call */
+      mov ah, 3 /* release_type() */
+      mov bx, myhandle
+      /* call the pktdrv int */
+      /* int to variable vector is a mess, so I have fetched its vector myself
+       * and pushf + cli + call far it now to simulate a regular int */
+      pushf
+      cli
+      call dword ptr pktdrvcall
+      /* restore AX and BX */
+      pop bx
+      pop ax
+    }
+    /* give the PIT back its BIOS setup */
+    pit_done();
+    /* set all mapped drives as 'not available' */
+    for (i = 0; i < 26; i++) {
+      if (tsrdata->ldrv[i] == 0xff) continue;
+      cds = getcds(i);
+      if (cds != NULL) cds->flags = 0;
+    }
+    /* free TSR's trace ring (in XMS, or in a segment of its own), its
+     * data/stack seg and its PSP */
+    if (traceptr != NULL) {
+      if (((struct mpxtracehdr far *)traceptr)->xms != 0) {
+        xmsfree(((struct mpxtracehdr far *)traceptr)->xms);
+      } else {
+        freeseg(FP_SEG(traceptr));
+      }
+    }
+    freeseg(mydataseg);
+    freeseg(tsrdata->pspseg);
+    /* all done */
+    #include "msg\\unloaded.c"
+    return(0);
+  }
+
+  /* remember current int 2f handler, we might over-write it soon (also I
+   * use it to see if I'm already loaded) */
+  _asm {
+    mov ax, 352fh; /* AH=GetVect AL=2F */
+    push es /* save ES and BX (will be overwritten) */
+    push bx
+    int 21h
+    mov word ptr [glob_data + GLOB_DATOFF_PREV2FHANDLERSEG], es
+    mov word ptr [glob_data + GLOB_DATOFF_PREV2FHANDLEROFF], bx
+    pop bx
+    pop es
+  }
+  /* same for int 28h (DOS idle), where I flush delayed writes */
+  _asm {
+    mov ax, 3528h; /* AH=GetVect AL=28 */
+    push es
+    push bx
+    int 21h
+    mov word ptr [glob_data + GLOB_DATOFF_PREV28HANDLERSEG], es
+    mov word ptr [glob_data + GLOB_DATOFF_PREV28HANDLEROFF], bx
+    pop bx
+    pop es
+  }
+
+  /* is the TSR installed already? */
+  glob_multiplexid = findfreemultiplex(&tmpflag);
+  if (tmpflag != 0) { /* already loaded */
+    #include "msg\\alrload.c"
+    return(1);
+  } else if (glob_multiplexid == 0) { /* no free multiplex id found */
+    #include "msg\\nomultpx.c"
+    return(1);
+  }
+
+  /* if any of the to-be-mapped drives is already active, fail */
+  for (i = 0; i < 26; i++) {
+    if (glob_data.ldrv[i] == 0xff) continue;
+    cds = getcds(i);
+    if (cds == NULL) {
+      #include "msg\\mapfail.c"
+      return(1);
+    }
+    if (cds->flags != 0) {
+      #include "msg\\drvactiv.c"
+      return(1);
+    }
+  }
+
+  /* my data segment is made of the first DATASEGSZ bytes of DGROUP, and
+   * the stack lives at its end - make sure that my data and a stack of
+   * STACKMIN bytes fit in there (the transient stack, that has the same
+   * size, gets moved along, too) */
+  if ((unsigned short)&dgroupend > DATASEGSZ - STACKMIN) {
+    #include "msg\\dsegsz.c"
+    return(1);
+  }
+
+  /* frame buffers come right after DATASEGSZ, in the same segment as my
+   * data. the frame size is not known until the server has been asked, so I
+   * talk to the server from a temporary segment first (allocated low, so it
+   * leaves no hole once freed), and allocate the data segment for good only
+   * then, at its final size */
+  glob_framesize = (args.framesize != 0)?args.framesize:FRAMESIZEMAX;
+  memstrategy = ((args.flags & ARGFL_LOWMEM) == 0)?ALLOC_UMBFIRST:ALLOC_LASTFIT;
+  /* the trace ring, if asked for, goes to XMS if possible (only its header
+   * stays in the data segment then), or in a segment of its own */
+  if (args.tracemax != 0) {
+    if ((args.flags & ARGFL_LOWMEM) == 0) xmsent = xmsentry();
+    if (xmsent != 0) xmshandle = xmsalloc(xmsent, (unsigned short)(((args.tracemax * (unsigned long)sizeof(struct mpxtrace)) + 1023) >> 10));
+    if (xmshandle == 0) {
+      struct mpxtracehdr far *hdr;
+      glob_traceseg = allocseg(sizeof(struct mpxtracehdr) + (args.tracemax * sizeof(struct mpxtrace)), memstrategy);
+      if (glob_traceseg == 0) {
+        #include "msg\\memfail.c"
+        return(1);
+      }
+      hdr = MK_FP(glob_traceseg, 0);
+      hdr->max = args.tracemax;
+      hdr->next = 0;
+      hdr->total = 0;
+      hdr->paused = 0;
+      hdr->xms = 0;
+    }
+  }
+  /* room for a single receive slot and the send buffer */
+  tmpdataseg = allocseg(DATASEGSZ + (2 * glob_framesize), ALLOC_FIRSTFIT);
+  if (tmpdataseg == 0) {
+    #include "msg\\memfail.c"
+    tracefree(xmshandle);
+    return(1);
+  }
+
+  /* copy current DS into the temporary segment and switch to new DS/SS */
+  switchds(tmpdataseg);
+
+  /* patch the TSR and pktdrv_recv() so they use my new DS */
+  if (updatetsrds() != 0) {
+    #include "msg\\relfail.c"
+    freeseg(tmpdataseg);
+    tracefree(xmshandle);
+    return(1);
+  }
+
+  /* pick the memory copy routine that suits the CPU best */
+  cpupatch();
+
+  /* set up frame buffers past the end of my (temporary) data segment - a
+   * single receive slot is enough until I'm done talking to the server */
+  glob_rxslot[0].buff = (unsigned char *)DATASEGSZ;
+  glob_rxhead = glob_rxslot;
+  glob_rxtail = glob_rxslot;
+  glob_rxend = glob_rxslot + 1;
+  glob_pktdrv_recvbuff = glob_rxslot[0].buff;
+  glob_pktdrv_sndbuff = glob_pktdrv_recvbuff + glob_framesize;
+
+  /* remember the SDA address (will be useful later) */
+  glob_sdaptr = getsda();
+
+  /* init the packet driver interface */
+  glob_data.pktint = 0;
+  if (args.pktint == 0) { /* detect first packet driver within int 60h..80h */
+    for (i = 0x60; i <= 0x80; i++) {
+      if (pktdrv_init(i) == 0) break;
+    }
+  } else { /* use the pktdrvr interrupt passed through command line */
+    pktdrv_init(args.pktint);
+  }
+  /* has it succeeded? */
+  if (glob_data.pktint == 0) {
+    #include "msg\\pktdfail.c"
+    freeseg(tmpdataseg);
+    tracefree(xmshandle);
+    return(1);
+  }
+  pktdrv_getaddr(GLOB_LMAC);
+
+  /* set up the PIT so I can measure round-trip times with sub-tick precision */
+  pit_init();
+
+  /* frames cannot be bigger than what the packet driver is able to handle
+   * (unless the user said otherwise) */
+  if (args.framesize == 0) {
+    unsigned short mtu = pktdrv_getmtu();
+    if (mtu == 0) mtu = 1514; /* no idea, assume plain ethernet */
+    if (mtu < FRAMESIZEMIN) mtu = FRAMESIZEMIN;
+    if (mtu < glob_framesize) glob_framesize = mtu;
+  }
+
+  /* should I auto-discover the server? (only drives mapped without a server
+   * address of their own need it) */
+  for (i = 0; (i < 26) && ((glob_data.ldrv[i] == 0xff) || (glob_drvsrv[i] != 0)); i++); /* find first disk of server 0 */
+  if (((args.flags & ARGFL_AUTO) != 0) && (i < 26)) {
+    unsigned short *ax;
+    unsigned char *answer;
+    /* send a discovery frame (to the broadcast address) that will update
+     * the address of server 0 */
+    if (sendquery(AL_DISKSPACE, i, 0, &answer, &ax, SQ_UPDATERMAC) != 6) {
+      #include "msg\\nosrvfnd.c"
+      pit_done();
+      pktdrv_free(glob_pktdrv_pktcall); /* free the pkt drv and quit */
+      freeseg(tmpdataseg);
+      tracefree(xmshandle);
+      return(1);
+    }
+  }
+
+  /* ask every server about the protocol extensions it supports and the
+   * biggest frame it handles (an older server will answer with an error).
+   * extensions and frame size are the same for all drives, so I use only
+   * what all servers agree on. a server that does not answer is asked again
+   * once it is used (see srvcapscheck()), meanwhile it is not held against
+   * the others */
+  glob_srvcaps = CAP_WRITESTREAM | CAP_READBULK | CAP_FINDBATCH | CAP_SRVCOPY;
+  if ((args.flags & ARGFL_COMPRESS) != 0) glob_srvcaps |= CAP_COMPRESS;
+  glob_framedef = (args.framesize == 0)?FRAMESIZE:0; /* unless the user knows better */
+  {
+    unsigned char srv, z;
+    for (srv = 0; srv < args.srvcount; srv++) {
+      /* find a disk served by this server (or by its replicas) */
+      for (i = 0; i < 26; i++) {
+        if (glob_data.ldrv[i] == 0xff) continue;
+        for (z = glob_drvpri[i]; (z != 0xff) && (z != srv); z = glob_srvnext[z]);
+        if (z == srv) break;
+      }
+      if (i == 26) continue; /* no drive is mapped to this server */
+      glob_srvunknown |= 1 << srv;
+      glob_drvsrv[i] = srv;
+      if ((srvgetcaps(i) != 0) && ((args.flags & ARGFL_QUIET) == 0)) {
+        char buff[20];
+        #include "msg\\srvnoans.c"
+        for (z = 0; z < 6; z++) byte2hex(buff + z + z + z, glob_srvmac[srv][z]);
+        for (z = 2; z < 16; z += 3) buff[z] = ':';
+        buff[17] = '\r';
+        buff[18] = '\n';
+        buff[19] = '$';
+        outmsg(buff);
+      }
+    }
+    /* back to the primary server (the discovery might have failed over) */
+    for (i = 0; i < 26; i++) glob_drvsrv[i] = glob_drvpri[i];
+    glob_failover = 0;
+  }
+
+  /* the frame size is settled now: lay out the receive ring, the send
+   * buffer (along with the headers it holds), read-ahead and write-back
+   * buffers and the caches right after DATASEGSZ, allocate my data segment
+   * for good and move there. all of it must fit in DATASEGMAX: caches are
+   * small and are always given room, buffers get what is left (receive
+   * buffers first, then read-ahead, then write-back), and options that ask
+   * for more than that are reduced */
+  {
+    unsigned char hdr[60];
+    unsigned short room, bufsz, wbarea, dirarea, mdarea, lzarea, n;
+    room = DATASEGMAX - DATASEGSZ;
+    if ((args.flags & ARGFL_LATENCY) != 0) room -= HISTSZ;
+    if (xmshandle != 0) room -= sizeof(struct tracexms);
+    if ((glob_srvcaps & CAP_FINDBATCH) != 0) {
+      n = (glob_framesize - 61) / 24;
+      if (n > DIRBATCHMAX) n = DIRBATCHMAX;
+      glob_dirmax = n;
+      room -= glob_dirmax * 24;
+    }
+    glob_mdttl = (args.mdttl * 91) / 5; /* 18.2 BIOS ticks per second */
+    glob_negttl = (glob_mdttl < NEGTTL)?glob_mdttl:NEGTTL;
+    if (glob_mdttl != 0) room -= MDCACHES * sizeof(struct mdcache);
+    if ((glob_srvcaps & CAP_COMPRESS) != 0) room -= 256 * 2;
+    /* receive slots, along with the send buffer */
+    n = (room / glob_framesize) - 1;
+    if (args.rxslots > n) {
+      args.rxslots = n;
+      if ((args.flags & ARGFL_QUIET) == 0) reducedopt('b', args.rxslots);
+    }
+    bufsz = (args.rxslots + 1) * glob_framesize;
+    room -= bufsz;
+    /* read-ahead buffers */
+    glob_rabufsz = RAFRAMES * (glob_framesize - 60);
+    n = room / glob_rabufsz;
+    if (args.racaches > n) {
+      args.racaches = n;
+      if ((args.flags & ARGFL_QUIET) == 0) reducedopt('r', args.racaches);
+    }
+    for (i = 0; i < args.racaches; i++) {
+      glob_racache[i].drive = 0xff;
+      glob_racache[i].buff = (unsigned char *)DATASEGSZ + bufsz + (i * glob_rabufsz);
+    }
+    glob_raend = glob_racache + args.racaches;
+    if (args.racaches == 0) glob_rabufsz = 0;
+    wbarea = bufsz + (args.racaches * glob_rabufsz);
+    room -= args.racaches * glob_rabufsz;
+    /* write-back buffers */
+    glob_wbbufsz = WBFRAMES * (glob_framesize - 69);
+    n = room / glob_wbbufsz;
+    if (args.wbcaches > n) {
+      args.wbcaches = n;
+      if ((args.flags & ARGFL_QUIET) == 0) reducedopt('w', args.wbcaches);
+    }
+    for (i = 0; i < args.wbcaches; i++) {
+      glob_wbcache[i].drive = 0xff;
+      glob_wbcache[i].buff = (unsigned char *)DATASEGSZ + wbarea + (i * glob_wbbufsz);
+    }
+    glob_wbend = glob_wbcache + args.wbcaches;
+    if (args.wbcaches == 0) glob_wbbufsz = 0;
+    /* the directory cache, the metadata cache and the hash table of the
+     * compressor (only if they are enabled) */
+    dirarea = wbarea + (args.wbcaches * glob_wbbufsz);
+    glob_dircache.drive = 0xff;
+    glob_dircache.buff = (unsigned char *)DATASEGSZ + dirarea;
+    mdarea = dirarea + (glob_dirmax * 24);
+    glob_mdcache = (struct mdcache *)((unsigned char *)DATASEGSZ + mdarea);
+    glob_mdend = glob_mdcache;
+    if (glob_mdttl != 0) glob_mdend = glob_mdcache + MDCACHES;
+    lzarea = mdarea + ((glob_mdend - glob_mdcache) * sizeof(struct mdcache));
+    if ((glob_srvcaps & CAP_COMPRESS) != 0) {
+      glob_lzhash = (unsigned short *)((unsigned char *)DATASEGSZ + lzarea);
+      lzarea += 256 * 2;
+    }
+    /* latency histograms, if asked for */
+    if ((args.flags & ARGFL_LATENCY) != 0) {
+      glob_hist = (struct mpxhist *)((unsigned char *)DATASEGSZ + lzarea);
+      lzarea += HISTSZ;
+    }
+    /* the header of the trace ring, if the ring is in XMS */
+    if (xmshandle != 0) {
+      glob_tracexms = (struct tracexms *)((unsigned char *)DATASEGSZ + lzarea);
+      lzarea += sizeof(struct tracexms);
+    }
+    /* allocate the data segment for good - it goes to upper memory if there
+     * is room enough there (unless the user said otherwise) */
+    newdataseg = allocseg(DATASEGSZ + lzarea, memstrategy);
+    if (newdataseg == 0) {
+      #include "msg\\memfail.c"
+      pit_done();
+      pktdrv_free(glob_pktdrv_pktcall);
+      freeseg(tmpdataseg);
+      tracefree(xmshandle);
+      return(1);
+    }
+    /* move there, and set up the receive ring and the send buffer. this must
+     * not be interrupted by a frame arriving meanwhile */
+    copybytes(hdr, glob_pktdrv_sndbuff, 60);
+    _asm {
+      cli
+    }
+    switchds(newdataseg);
+    updatetsrds(); /* cannot fail, signatures have been checked already */
+    for (i = 0; i < args.rxslots; i++) {
+      glob_rxslot[i].len = 0;
+      glob_rxslot[i].buff = (unsigned char *)DATASEGSZ + (i * glob_framesize);
+    }
+    glob_rxhead = glob_rxslot;
+    glob_rxtail = glob_rxslot;
+    glob_rxend = glob_rxslot + args.rxslots;
+    glob_pktdrv_recvbuff = glob_rxslot[0].buff;
+    glob_pktdrv_sndbuff = (unsigned char *)DATASEGSZ + (args.rxslots * glob_framesize);
+    copybytes(glob_pktdrv_sndbuff, hdr, 60);
+    _asm {
+      sti
+    }
+    freeseg(tmpdataseg);
+    /* caches that need some initialization */
+    for (i = 0; i < glob_mdend - glob_mdcache; i++) glob_mdcache[i].drive = 0xff;
+    if (glob_hist != NULL) zerobytes(glob_hist, HISTSZ);
+    if (glob_tracexms != NULL) {
+      zerobytes(glob_tracexms, sizeof(struct tracexms));
+      glob_tracexms->hdr.max = args.tracemax;
+      glob_tracexms->hdr.xms = xmshandle;
+      glob_tracexms->entry = xmsent;
+    }
+  }
+
+  /* set all drives as being 'network' drives (also add the PHYSICAL bit,
+   * otherwise MS-DOS 6.0 will ignore the drive) */
+  for (i = 0; i < 26; i++) {
+    if (glob_data.ldrv[i] == 0xff) continue;
+    cds = getcds(i);
+    cds->flags = CDSFLAG_NET | CDSFLAG_PHY;
+    /* set 'current path' to root, to avoid inheriting any garbage */
+    cds->current_path[0] = 'A' + i;
+    cds->current_path[1] = ':';
+    cds->current_path[2] = '\\';
+    cds->current_path[3] = 0;
+  }
+
+  if ((args.flags & ARGFL_QUIET) == 0) {
+    char buff[20];
+    #include "msg\\instlled.c"
+    for (i = 0; i < 6; i++) {
+      byte2hex(buff + i + i + i, GLOB_LMAC[i]);
+    }
+    for (i = 2; i < 16; i += 3) buff[i] = ':';
+    buff[17] = '$';
+    outmsg(buff);
+    #include "msg\\pktdrvat.c"
+    byte2hex(buff, glob_data.pktint);
+    buff[2] = ')';
+    buff[3] = '\r';
+    buff[4] = '\n';
+    buff[5] = '$';
+    outmsg(buff);
+    for (i = 0; i < 26; i++) {
+      int z;
+      if (glob_data.ldrv[i] == 0xff) continue;
+      buff[0] = ' ';
+      buff[1] = 'A' + i;
+      buff[2] = ':';
+      buff[3] = ' ';
+      buff[4] = '-';
+      buff[5] = '>';
+      buff[6] = ' ';
+      buff[7] = '[';
+      buff[8] = 'A' + glob_data.ldrv[i];
+      buff[9] = ':';
+      buff[10] = ']';
+      buff[11] = ' ';
+      buff[12] = 'o';
+      buff[13] = 'n';
+      buff[14] = ' ';
+      buff[15] = '$';
+      outmsg(buff);
+      for (z = 0; z < 6; z++) {
+        byte2hex(buff + z + z + z, glob_srvmac[glob_drvsrv[i]][z]);
+      }
+      for (z = 2; z < 16; z += 3) buff[z] = ':';
+      buff[17] = '\r';
+      buff[18] = '\n';
+      buff[19] = '$';
+      outmsg(buff);
+    }
+  }
+
+  /* get the segment of the PSP (might come handy later) */
+  _asm {
+    mov ah, 62h          /* get current PSP address */
+    int 21h              /* returns the segment of PSP in BX */
+    mov word ptr [glob_data + GLOB_DATOFF_PSPSEG], bx  /* copy PSP segment to glob_pspseg */
+  }
+
+  /* free the environment (env segment is at offset 2C of the PSP) */
+  _asm {
+    mov es, word ptr [glob_data + GLOB_DATOFF_PSPSEG] /* load ES with PSP's segment */
+    mov es, es:[2Ch]    /* get segment of the env block */
+    mov ah, 49h         /* free memory (DOS 2+) */
+    int 21h
+  }
+
+  /* set up the TSR (INT 2F catching) */
+  _asm {
+    cli
+    mov ax, 252fh /* AH=set interrupt vector  AL=2F */
+    push ds /* preserve DS and DX */
+    push dx
+    push cs /* set DS to current CS, that is provide the */
+    pop ds  /* int handler's segment */
+    mov dx, offset inthandler /* int handler's offset */
+    int 21h
+    mov ax, 2528h /* AH=set interrupt vector  AL=28 */
+    mov dx, offset idlehandler
+    int 21h
+    pop dx /* restore DS and DX to previous values */
+    pop ds
+    sti
+  }
+
+  /* Turn self into a TSR and free memory I won't need any more. That is, I
+   * free all the libc startup code and my init functions by passing the
+   * number of paragraphs to keep resident to INT 21h, AH=31h. How to compute
+   * the number of paragraphs? Simple: look at the memory map and note down
+   * the size of the BEGTEXT segment (that's where I store all TSR routines).
+   * then: (sizeof(BEGTEXT) + sizeof(PSP) + 15) / 16
+   * PSP is 256 bytes of course. And +15 is needed to avoid truncating the
+   * last (partially used) paragraph. */
+  _asm {
+    mov ax, 3100h  /* AH=31 'terminate+stay resident', AL=0 exit code */
+    mov dx, offset begtextend /* DX = offset of resident code end     */
+    add dx, 256    /* add size of PSP (256 bytes)                     */
+    add dx, 15     /* add 15 to avoid truncating last paragraph       */
+    shr dx, 1      /* convert bytes to number of 16-bytes paragraphs  */
+    shr dx, 1      /* the 8086/8088 CPU supports only a 1-bit version */
+    shr dx, 1      /* of SHR, so I have to repeat it as many times as */
+    shr dx, 1      /* many bits I need to shift.                      */
+    int 21h
+  }
+
+  return(0); /* never reached, but compiler complains if not present */
+}
+
+#endif /* HOSTBUILD */
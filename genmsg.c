@@ -69,15 +69,29 @@ int main(void) {
     "EtherDFS v" PVER " / Copyright (C) " PDATE " Mateusz Viste\r\n"
     "A network drive for DOS, running over raw ethernet\r\n"
     "\r\n"
-    "Usage: etherdfs SRVMAC rdrv-ldrv [rdrv2-ldrv2 ...] [options]\r\n"
+    "Usage: etherdfs SRVMAC [MAC/]rdrv-ldrv [[MAC/]rdrv2-ldrv2 ...] [options]\r\n"
     "       etherdfs /u\r\n"
+    "       etherdfs /s\r\n"
+    "       etherdfs /l\r\n"
+    "       etherdfs /t=FILE\r\n"
     "\r\n"
     "Options:\r\n"
+    "  /a=N    keep file attributes in cache for N seconds, 0..60 (default: 2)\r\n"
+    "  /b=N    use N receive buffers, 1..8 (default: 4)\r\n"
+    "  /c      keep EtherDFS in conventional memory (no UMB, no XMS)\r\n"
+    "  /f=N    max frame size in bytes, 576..9216 (autodetect otherwise)\r\n"
+    "  /l      keep latency histograms (print them with 'etherdfs /l')\r\n"
     "  /p=XX   use packet driver at interrupt XX (autodetect otherwise)\r\n"
     "  /q      quiet mode (print nothing if loaded successfully)\r\n"
+    "  /r=N    use N read-ahead buffers, 0..4 (default: 2)\r\n"
+    "  /s      print statistics of the loaded EtherDFS\r\n"
+    "  /t=N    trace the last N calls, 1..1000 (dump them with 'etherdfs /t=FILE')\r\n"
     "  /u      unload EtherDFS from memory\r\n"
+    "  /w=N    use N write-back buffers, 0..4 (default: 1)\r\n"
+    "  /z      compress file data (if the server supports it)\r\n"
     "\r\n"
-    "Use '::' as SRVMAC for server auto-discovery.\r\n"
+    "Use '::' as SRVMAC for server auto-discovery. MAC/ maps a drive from another\r\n"
+    "server than SRVMAC, MAC1+MAC2/ from a server with a replica to fail over to.\r\n"
     "\r\n"
     "Examples:  etherdfs 6d:4f:4a:4d:49:52 C-F /q\r\n"
     "           etherdfs :: C-X D-Y E-Z /p=6F\r\n"
@@ -93,6 +107,28 @@ int main(void) {
 
   genmsg("msg\\tsrcomfa.c", "Communication with the TSR failed.\r\n");
 
+  genmsg("msg\\notlds.c", "EtherDFS is not loaded.\r\n");
+
+  genmsg("msg\\statcall.c", "Redirector calls (subfunction: count):\r\n");
+  genmsg("msg\\statrd.c",   "Bytes read:            ");
+  genmsg("msg\\statwr.c",   "Bytes written:         ");
+  genmsg("msg\\stattx.c",   "Frames sent:           ");
+  genmsg("msg\\statrx.c",   "Frames received:       ");
+  genmsg("msg\\statrexm.c", "Retransmissions:       ");
+  genmsg("msg\\statto.c",   "Queries timed out:     ");
+  genmsg("msg\\statign.c",  "Frames ignored:        ");
+  genmsg("msg\\statbusy.c", "Frames refused (busy): ");
+
+  genmsg("msg\\nohist.c", "Latency histograms are not enabled (load EtherDFS with /l).\r\n");
+
+  genmsg("msg\\histhdr.c",
+    "Calls per duration, spent on the network and locally:\r\n"
+    "AL   time (us)    network      local\r\n");
+
+  genmsg("msg\\notrace.c", "Tracing is not enabled (load EtherDFS with /t=N).\r\n");
+  genmsg("msg\\trcfail.c", "Failed to write the trace file.\r\n");
+  genmsg("msg\\trcdump.c", "Trace records written: ");
+
   genmsg("msg\\nomultpx.c", "Failed to find an available INT 2F multiplex id.\r\nYou may have loaded too many TSRs already.\r\n");
 
   genmsg("msg\\othertsr.c", "EtherDFS cannot be unloaded because another TSR hooked its interrupt handler.\r\n");
@@ -112,12 +148,18 @@ int main(void) {
 
   genmsg("msg\\memfail.c", "Memory alloc error!\r\n");
 
+  genmsg("msg\\bufrdcd.c", "Buffers do not fit in 64 KiB with frames of this size, using /");
+
+  genmsg("msg\\dsegsz.c", "DATASEGSZ is too small for the data and stack of EtherDFS (see globals.h).\r\n");
+
   genmsg("msg\\relfail.c", "DS/SS relocation failed.\r\n");
 
   genmsg("msg\\pktdfail.c", "Packet driver initialization failed.\r\n");
 
   genmsg("msg\\nosrvfnd.c", "No EtherSRV server found on the LAN (not for requested drive at least).\r\n");
 
+  genmsg("msg\\srvnoans.c", "Warning: no answer from server ");
+
   genmsg("msg\\instlled.c", "EtherDFS v" PVER " installed (local MAC ");
 
   genmsg("msg\\pktdrvat.c", ", pktdrvr at INT ");
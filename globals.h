@@ -1,77 +1,286 @@
-/*
- * This file is part of the etherdfs project.
- * http://etherdfs.sourceforge.net
- *
- * Copyright (C) 2017 Mateusz Viste
- *
- * Contains all global variables used by etherdfs.
- */
-
-#ifndef GLOBALS_SENTINEL
-#define GLOBALS_SENTINEL
-
-/* required size (in bytes) of the data segment - this must be bigh enough as
- * to accomodate all "DATA" segments AND the stack, which will be located at
- * the very end of the data segment. packet drivers tend to require a stack
- * of several hundreds bytes at least - 1K should be safe... It is important
- * that DATASEGSZ can contain a stack of AT LEAST the size of the stack used
- * by the transient code, since the transient part of the program will switch
- * to it and expects the stack to not become corrupted in the process */
-#define DATASEGSZ 3500
-
-/* a few globals useful only for debug messages */
-#if DEBUGLEVEL > 0
-static unsigned short dbg_xpos = 0;
-static unsigned short far *dbg_VGA = (unsigned short far *)(0xB8000000l);
-static unsigned char dbg_hexc[16] = "0123456789ABCDEF";
-#define dbg_startoffset 80*16
-#endif
-
-/* whenever the tsrshareddata structure changes, offsets below MUST be
- * adjusted (these are required by assembly routines) */
-#define GLOB_DATOFF_PREV2FHANDLERSEG 0
-#define GLOB_DATOFF_PREV2FHANDLEROFF 2
-#define GLOB_DATOFF_PSPSEG 4
-#define GLOB_DATOFF_PKTHANDLE 6
-#define GLOB_DATOFF_PKTINT 8
-static struct tsrshareddata {
-/*offs*/
-/*  0 */ unsigned short prev_2f_handler_seg; /* seg:off of the previous 2F handler */
-/*  2 */ unsigned short prev_2f_handler_off; /* (so I can call it for all queries  */
-                                            /* that do not relate to my drive     */
-/*  4 */ unsigned short pspseg;    /* segment of the program's PSP block */
-/*  6 */ unsigned short pkthandle; /* handler returned by the packet driver */
-/*  8 */ unsigned char pktint;     /* software interrupt of the packet driver */
-
-         unsigned char ldrv[26]; /* local to remote drives mappings (0=A:, 1=B, etc */
-} glob_data;
-
-/* global variables related to packet driver management and handling frames */
-static unsigned char glob_pktdrv_recvbuff[FRAMESIZE];
-static signed short volatile glob_pktdrv_recvbufflen; /* length of the frame in buffer, 0 means "free", and neg value means "awaiting" */
-static unsigned char glob_pktdrv_sndbuff[FRAMESIZE]; /* this not only is my send-frame buffer, but I also use it to store permanently lmac, rmac, ethertype and PROTOVER at proper places */
-static unsigned long glob_pktdrv_pktcall;     /* vector address of the pktdrv interrupt */
-
-/* a few definitions for data that points to my sending buffer */
-#define GLOB_LMAC (glob_pktdrv_sndbuff + 6) /* local MAC address */
-#define GLOB_RMAC (glob_pktdrv_sndbuff)     /* remote MAC address */
-
-static unsigned char glob_reqdrv;  /* the requested drive, set by the INT 2F *
-                                    * handler and read by process2f()        */
-
-static unsigned short glob_reqstkword; /* WORD saved from the stack (used by SETATTR) */
-static struct sdastruct far *glob_sdaptr; /* pointer to DOS SDA (set by main() at *
-                                           * startup, used later by process2f()   */
-
-/* seg:off addresses of the old (DOS) stack */
-static unsigned short glob_oldstack_seg;
-static unsigned short glob_oldstack_off;
-
-/* the INT 2F "multiplex id" registerd by EtherDFS */
-static unsigned char glob_multiplexid;
-
-/* an INTPACK structure used to store registers as set when INT2F is called */
-static union INTPACK glob_intregs;
-
-
-#endif
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * Contains all global variables used by etherdfs.
+ */
+
+#ifndef GLOBALS_SENTINEL
+#define GLOBALS_SENTINEL
+
+/* required size (in bytes) of the data segment - this must be bigh enough as
+ * to accomodate all "DATA" segments AND the stack, which will be located at
+ * the very end of the data segment. packet drivers tend to require a stack
+ * of several hundreds bytes at least - 1K should be safe... It is important
+ * that DATASEGSZ can contain a stack of AT LEAST the size of the stack used
+ * by the transient code, since the transient part of the program will switch
+ * to it and expects the stack to not become corrupted in the process.
+ * frame buffers are NOT part of it: they are placed right after DATASEGSZ, in
+ * the same segment, once the frame size is known (see main()).
+ * DATASEGSZ is set from the map file: it is the end of DGROUP (that is the
+ * offset of _end in etherdfs.map, the start of the transient stack) plus
+ * STACKMIN, rounded up with a little margin. main() refuses to load if it is
+ * too small, so this must be checked again whenever globals are added */
+#define DATASEGSZ 2304
+#define STACKMIN 1024
+
+/* a few globals useful only for debug messages */
+#if DEBUGLEVEL > 0
+static unsigned short dbg_xpos = 0;
+static unsigned short far *dbg_VGA = (unsigned short far *)(0xB8000000l);
+static unsigned char dbg_hexc[16] = "0123456789ABCDEF";
+#define dbg_startoffset 80*16
+#endif
+
+/* whenever the tsrshareddata structure changes, offsets below MUST be
+ * adjusted (these are required by assembly routines) */
+#define GLOB_DATOFF_PREV2FHANDLERSEG 0
+#define GLOB_DATOFF_PREV2FHANDLEROFF 2
+#define GLOB_DATOFF_PSPSEG 4
+#define GLOB_DATOFF_PKTHANDLE 6
+#define GLOB_DATOFF_PREV28HANDLERSEG 8
+#define GLOB_DATOFF_PREV28HANDLEROFF 10
+#define GLOB_DATOFF_PKTINT 12
+static struct tsrshareddata {
+/*offs*/
+/*  0 */ unsigned short prev_2f_handler_seg; /* seg:off of the previous 2F handler */
+/*  2 */ unsigned short prev_2f_handler_off; /* (so I can call it for all queries  */
+                                            /* that do not relate to my drive     */
+/*  4 */ unsigned short pspseg;    /* segment of the program's PSP block */
+/*  6 */ unsigned short pkthandle; /* handler returned by the packet driver */
+/*  8 */ unsigned short prev_28_handler_seg; /* seg:off of the previous 28h */
+/* 10 */ unsigned short prev_28_handler_off; /* (idle) handler               */
+/* 12 */ unsigned char pktint;     /* software interrupt of the packet driver */
+
+         unsigned char ldrv[26]; /* local to remote drives mappings (0=A:, 1=B, etc */
+} glob_data;
+
+/* global variables related to packet driver management and handling frames */
+static unsigned short glob_framesize; /* size of frame buffers (max frame len I send or accept) */
+static unsigned char *glob_pktdrv_recvbuff; /* buffer of the oldest frame in the receive ring (glob_rxtail) */
+static unsigned char *glob_pktdrv_sndbuff; /* this not only is my send-frame buffer, but I also use it to store permanently lmac, rmac, ethertype and PROTOVER at proper places */
+#ifndef HOSTBUILD
+static unsigned long glob_pktdrv_pktcall;     /* vector address of the pktdrv interrupt */
+#endif
+
+/* the receive ring (see pktdrv_recv()): glob_rxhead is the slot that gets the
+ * next incoming frame, glob_rxtail the slot that holds the oldest frame not
+ * processed yet. slots used are glob_rxslot[0] up to glob_rxend (excluded),
+ * their buffers live past DATASEGSZ. only frames whose seq is within
+ * glob_rxseqlo..glob_seq are kept, and their src mac is not checked as long
+ * as glob_rxanysrc is non-zero. whenever the rxslot structure changes,
+ * offsets below MUST be adjusted (these are required by pktdrv_recv) */
+#define RXSLOT_LEN 0
+#define RXSLOT_BUFF 2
+#define RXSLOT_HIT 4
+#define RXSLOTSZ 6
+static struct rxslot {
+/*offs*/
+/*  0 */ signed short volatile len; /* length of the frame in buffer, 0 means "free", and neg value means "awaiting" */
+/*  2 */ unsigned char *buff; /* glob_framesize bytes */
+/*  4 */ unsigned char volatile hit; /* 1 if the payload went to the direct receive target */
+/*  5 */ unsigned char reserved;
+} glob_rxslot[RXSLOTSMAX];
+static struct rxslot * volatile glob_rxhead;
+static struct rxslot *glob_rxtail;
+static struct rxslot *glob_rxend;
+static unsigned char glob_rxseqlo;
+static unsigned char glob_rxanysrc;
+
+/* read-ahead cache (see AL_READFIL): each entry holds len bytes of the file
+ * fileid on local drive 'drive' (0xff = entry unused), starting at offset
+ * offs, in a buffer of glob_rabufsz bytes that lives past DATASEGSZ. nextpos
+ * is where the last read of the file ended, so sequential reads can be
+ * recognized. entries in use are glob_racache[0] up to glob_raend (excluded) */
+static struct racache {
+  unsigned long offs;
+  unsigned long nextpos;
+  unsigned short fileid;
+  unsigned short len;
+  unsigned short stamp; /* glob_rastamp at last use, the oldest one is recycled first */
+  unsigned char *buff;
+  unsigned char drive;
+} glob_racache[RACACHEMAX];
+static struct racache *glob_raend = glob_racache;
+static unsigned short glob_rabufsz;
+static unsigned short glob_rastamp;
+
+/* write-back buffers (see AL_WRITEFIL): each entry holds len bytes that the
+ * application wrote to the file fileid on local drive 'drive' (0xff = entry
+ * unused) at offset offs, but that have not been sent to the server yet. they
+ * are in a buffer of glob_wbbufsz bytes that lives past DATASEGSZ. err is
+ * the DOS error code of a delayed write that failed, still to be reported to
+ * the application. entries in use are glob_wbcache[0] up to glob_wbend
+ * (excluded) */
+static struct wbcache {
+  unsigned long offs;
+  unsigned short fileid;
+  unsigned short len;
+  unsigned short tick;  /* BIOS tick at the time the buffer got its first byte */
+  unsigned short stamp; /* glob_wbstamp at last use, the oldest one is recycled first */
+  unsigned short err;
+  unsigned char *buff;
+  unsigned char drive;
+} glob_wbcache[WBCACHEMAX];
+static struct wbcache *glob_wbend = glob_wbcache;
+static unsigned short glob_wbbufsz;
+static unsigned short glob_wbstamp;
+static unsigned char glob_wbdirty; /* non-zero if some buffer might hold data */
+
+/* directory cache (see AL_FINDNEXT): entries of the last FINDBATCH answer
+ * that have not been handed to the application yet. count entries (24 bytes
+ * each, as in a FINDFIRST answer) wait at next, and follow the entry
+ * dir_entry of the directory par_clstr on local drive 'drive' (0xff = cache
+ * empty), for a search of srch_tmpl with attributes srch_attr. eod is
+ * non-zero if the server said that nothing comes after them. buff has room
+ * for glob_dirmax entries and lives past DATASEGSZ */
+static struct dircache {
+  unsigned short par_clstr;
+  unsigned short dir_entry;
+  unsigned char *next;
+  unsigned char *buff;
+  unsigned char srch_tmpl[11];
+  unsigned char srch_attr;
+  unsigned char count;
+  unsigned char eod;
+  unsigned char drive;
+} glob_dircache;
+static unsigned char glob_dirmax; /* entries asked per FINDBATCH query (0 = no batches) */
+
+/* metadata cache (see AL_GETATTR, AL_CHDIR and AL_DISKSPACE): recent results
+ * of these queries, reused for glob_mdttl BIOS ticks unless a call that may
+ * change them comes first. entries (MDCACHES of them, or none if the cache is
+ * disabled) are glob_mdcache up to glob_mdend (excluded) and live past
+ * DATASEGSZ */
+static struct mdcache {
+  unsigned short tick;  /* BIOS tick at the time the result has been obtained */
+  unsigned short stamp; /* glob_mdstamp at last use, the oldest one is recycled first */
+  unsigned char drive;  /* local drive, 0xff = entry unused */
+  unsigned char type;   /* AL_GETATTR, AL_CHDIR or AL_DISKSPACE, or MDNEG | AL_xxx for a failure */
+  unsigned char data[9]; /* GETATTR answer, DISKSPACE answer with its AX first, or error code and search attributes of a failure */
+  unsigned char path[MDPATHMAX]; /* as in fn1, without the drive part */
+} *glob_mdcache, *glob_mdend;
+static unsigned short glob_mdttl;
+static unsigned short glob_negttl; /* same, for negative results (MDNEG) */
+static unsigned short glob_mdstamp;
+
+/* hash table of 3-bytes sequences used by lzpack() (256 entries that live
+ * past DATASEGSZ), NULL if compression is disabled */
+static unsigned short *glob_lzhash;
+
+/* round-trip estimators of each server (see rttsample()), and the resulting
+ * retransmission timeouts, all in pit_now() units */
+static unsigned short glob_srtt[SRVMAX];   /* smoothed RTT, x8 (0 = not measured yet) */
+static unsigned short glob_rttvar[SRVMAX]; /* RTT variance, x4 */
+static unsigned short glob_rto[SRVMAX];    /* RTOINIT until measured */
+
+#ifndef HOSTBUILD
+/* last value returned by pit_now() */
+static unsigned short glob_pitlast;
+#endif
+
+/* direct receive target (see pktdrv_recv() and directrecv()): when
+ * glob_directlen is non-zero, a frame made of glob_directhdr bytes of headers
+ * followed by no more than glob_directlen bytes of payload is written by the
+ * packet driver so its payload lands at glob_directseg:glob_directoff. the
+ * hit field of the frame's slot tells whether it went that way */
+static unsigned short glob_directseg;
+static unsigned short glob_directoff;
+static unsigned short glob_directhdr;
+static unsigned short volatile glob_directlen;
+
+/* counters reported through MPX_GETSTATS. whenever the mpxstats structure
+ * (see mplex.h) changes, offsets below MUST be adjusted (these are required
+ * by pktdrv_recv()) */
+#define GLOB_STATOFF_RXFRAMES 200
+#define GLOB_STATOFF_RXIGNORED 212
+#define GLOB_STATOFF_RXBUSY 216
+static struct mpxstats glob_stats;
+
+/* latency histograms of process2f() calls (see MPX_GETHIST), in an array of
+ * 0x2F entries that lives past DATASEGSZ, NULL if not enabled (/l).
+ * glob_netwait sums up the time spent on the network during the current
+ * call, in pit_now() units */
+static struct mpxhist *glob_hist;
+static unsigned short glob_netwait;
+
+/* segment of the trace ring (see MPX_GETTRACE), 0 if not enabled (/t=N) or
+ * if the ring is in XMS */
+static unsigned short glob_traceseg;
+
+/* XMS "move extended memory block" structure (XMS function 0Bh). a handle
+ * of 0 means that the offset is a real-mode seg:off pointer */
+struct xmsmove {
+  unsigned long len;
+  unsigned short srchandle;
+  unsigned long srcoff;
+  unsigned short dsthandle;
+  unsigned long dstoff;
+};
+
+/* trace ring kept in XMS: the ring header and the record of the current call
+ * live past DATASEGSZ, and the record is moved into the XMS block once the
+ * call is over. glob_tracexms is NULL unless the ring is in XMS */
+struct tracexms {
+  struct mpxtracehdr hdr;
+  struct mpxtrace rec;
+  struct xmsmove mv;
+  unsigned long entry; /* entry point of the XMS driver */
+};
+static struct tracexms *glob_tracexms;
+
+/* a few definitions for data that points to my sending buffer */
+#define GLOB_LMAC (glob_pktdrv_sndbuff + 6) /* local MAC address */
+#define GLOB_RMAC (glob_pktdrv_sndbuff)     /* remote MAC address */
+
+/* servers drives are mapped to: local drive x is served by the server whose
+ * MAC address is glob_srvmac[glob_drvsrv[x]]. server 0 is the one given as
+ * SRVMAC (or auto-discovered). the address of the server of the drive being
+ * queried is copied to GLOB_RMAC before sending anything (see selectsrv()) */
+static unsigned char glob_srvmac[SRVMAX][6];
+static unsigned char glob_drvsrv[26];
+
+/* replicas (see srvfailover()): glob_srvnext[x] is the server to fall back to
+ * when server x does not answer (0xff = none), glob_drvpri[x] is the server
+ * local drive x uses normally. glob_drvgen[x] counts the times local drive x
+ * switched servers (see sftstale()). glob_failover is non-zero while some
+ * drive uses a replica, glob_probetick is the BIOS tick of the last
+ * srvprobe() */
+static unsigned char glob_srvnext[SRVMAX];
+static unsigned char glob_drvpri[26];
+static unsigned char glob_drvgen[26];
+static unsigned char glob_failover;
+static unsigned short glob_probetick;
+
+static unsigned char glob_seq; /* seq of the last query sent (incremented for every new query) */
+
+static unsigned short glob_srvcaps; /* protocol extensions supported by the server (CAP_xxx flags) */
+static unsigned char glob_srvunknown; /* servers not asked about their extensions yet (bit x = server x) */
+static unsigned short glob_framedef; /* frame size of servers that do not tell (0 = no limit) */
+
+static unsigned char glob_reqdrv;  /* the requested drive, set by the INT 2F *
+                                    * handler and read by process2f()        */
+
+static unsigned short glob_reqstkword; /* WORD saved from the stack (used by SETATTR) */
+static struct sdastruct far *glob_sdaptr; /* pointer to DOS SDA (set by main() at *
+                                           * startup, used later by process2f()   */
+
+#ifndef HOSTBUILD
+/* seg:off addresses of the old (DOS) stack */
+static unsigned short glob_oldstack_seg;
+static unsigned short glob_oldstack_off;
+#endif
+
+/* non-zero while my stack is in use by inthandler() or idlehandler() */
+static unsigned char glob_busy;
+
+/* the INT 2F "multiplex id" registerd by EtherDFS */
+static unsigned char glob_multiplexid;
+
+/* an INTPACK structure used to store registers as set when INT2F is called */
+static union INTPACK glob_intregs;
+
+
+#endif
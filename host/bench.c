@@ -0,0 +1,502 @@
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * edfbench drives the host build of EtherDFS (see host.h) through a few
+ * typical workloads, and tells how fast EtherDFS gets through them: in real
+ * time (how much CPU the client logic takes) and in simulated time (how long
+ * it would take on the wire, given the latency of the server). Every answer
+ * is checked along the way, so edfbench exits with an error code as soon as
+ * EtherDFS gets something wrong.
+ *
+ * The server is the mock of mockpeer.c by default. With -d, it is the
+ * reference server of refsrv.c instead, serving a local directory that
+ * edfbench fills first with the same files as the mock would serve.
+ *
+ * With -p, frames go through the simulated link of netsim.c, that loses or
+ * damages some of them, and edfbench also tells how each INT 2F subfunction
+ * fared: goodput, retransmissions and latency percentiles.
+ *
+ * With -R, edfbench replays a trace written by 'etherdfs /t=FILE' (see
+ * replay.h) against the reference server instead of running its workloads,
+ * and tells how each INT 2F subfunction fared, too.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host.h"
+#include "mockpeer.h"
+#include "netsim.h"
+#include "refsrv.h"
+#include "replay.h"
+
+/* length of a BIOS tick, in microseconds */
+#define TICKUS 54925lu
+
+static unsigned short blksz = 512;
+static unsigned long errors;
+
+/* answers of the reference server are sent through this */
+static void (*srvsend)(const unsigned char *frame, unsigned short len, unsigned long delay) = host_post;
+
+/* how calls of each subfunction fared (filled only when the link is
+ * simulated or a trace is replayed, see oncall()) */
+static struct {
+  unsigned long calls;
+  unsigned long errors;
+  unsigned long frames;   /* frames sent by EtherDFS */
+  unsigned long rexmit;   /* how many of them were retransmissions */
+  unsigned long bytes;    /* bytes read or written */
+  unsigned long clocks;   /* time spent, in pit_now() units */
+  unsigned long *lat;     /* time spent by each call */
+  unsigned long latsize;
+} subfn[0x30];
+
+
+/* converts microseconds into pit_now() units */
+static unsigned long us2pit(unsigned long us) {
+  return((us * 1024 + TICKUS / 2) / TICKUS);
+}
+
+
+/* reports a DOS error returned by call what */
+static void fail(const char *what, int err) {
+  if (errors++ < 10) fprintf(stderr, "%s failed with error %d\n", what, err);
+}
+
+
+/* hands frames to the reference server */
+static void refpeer(const unsigned char *frame, unsigned short len) {
+  refsrv_query(frame, len, host_clock, srvsend);
+}
+
+
+/* accounts for a call made to EtherDFS (this is the host_oncall) */
+static void oncall(unsigned char al, int err, unsigned long clocks, unsigned short cx) {
+  unsigned long rexmit;
+  if (al >= 0x30) return;
+  subfn[al].frames += netsim_take(&rexmit);
+  subfn[al].rexmit += rexmit;
+  /* running out of directory entries is no failure */
+  if ((err != 0) && ((err != 18) || ((al != 0x1B) && (al != 0x1C)))) subfn[al].errors++;
+  if ((err == 0) && ((al == 0x08) || (al == 0x09))) subfn[al].bytes += cx;
+  subfn[al].clocks += clocks;
+  if (subfn[al].calls == subfn[al].latsize) {
+    unsigned long *lat = realloc(subfn[al].lat, (subfn[al].latsize + 1024) * sizeof(unsigned long));
+    if (lat == NULL) return;
+    subfn[al].lat = lat;
+    subfn[al].latsize += 1024;
+  }
+  subfn[al].lat[subfn[al].calls++] = clocks;
+}
+
+
+static int cmplat(const void *a, const void *b) {
+  unsigned long x = *(const unsigned long *)a, y = *(const unsigned long *)b;
+  return((x > y) - (x < y));
+}
+
+
+/* prints what oncall() gathered, and what the link went through (if link
+ * is set) */
+static void report(int link) {
+  static const char *names[0x30] = {
+    NULL, "RMDIR", NULL, "MKDIR", NULL, "CHDIR", "CLSFIL", "CMMTFIL",
+    "READFIL", "WRITEFIL", "LOCKFIL", "UNLOCKFIL", "DISKSPACE", NULL, "SETATTR", "GETATTR",
+    NULL, "RENAME", NULL, "DELETE", NULL, NULL, "OPEN", "CREATE",
+    NULL, NULL, NULL, "FINDFIRST", "FINDNEXT", NULL, NULL, NULL,
+    NULL, "SKFMEND", NULL, NULL, NULL, NULL, NULL, NULL,
+    NULL, NULL, NULL, NULL, NULL, NULL, "SPOPNFIL", NULL};
+  char name[16];
+  double secs;
+  unsigned long n;
+  int al;
+  printf("\n%-9s %8s %6s %7s %7s %9s %9s %9s %9s %9s\n", "subfn", "calls", "errors",
+         "frm/call", "rexmit", "calls/s", "KiB/s", "p50 us", "p99 us", "max us");
+  for (al = 0; al < 0x30; al++) {
+    n = subfn[al].calls;
+    if (n == 0) continue;
+    if (names[al] != NULL) {
+      strcpy(name, names[al]);
+    } else {
+      sprintf(name, "%02Xh", al);
+    }
+    qsort(subfn[al].lat, n, sizeof(unsigned long), cmplat);
+    secs = (double)subfn[al].clocks * TICKUS / 1024 / 1e6;
+    if (secs <= 0) secs = 1e-9;
+    printf("%-9s %8lu %6lu %8.2f %7lu %9.0f %9.1f %9.0f %9.0f %9.0f\n", name, n, subfn[al].errors,
+           (double)subfn[al].frames / n, subfn[al].rexmit, n / secs, subfn[al].bytes / 1024.0 / secs,
+           (double)subfn[al].lat[(n - 1) / 2] * TICKUS / 1024,
+           (double)subfn[al].lat[(n - 1) * 99 / 100] * TICKUS / 1024,
+           (double)subfn[al].lat[n - 1] * TICKUS / 1024);
+  }
+  if (link == 0) return;
+  printf("\nlink      %8s %8s %8s %8s %8s\n", "frames", "dropped", "dupped", "held", "damaged");
+  for (al = 0; al < 2; al++) {
+    printf("%-9s %8lu %8lu %8lu %8lu %8lu\n", (al == 0)?"to srv":"to client", netsim_stats.frames[al],
+           netsim_stats.dropped[al], netsim_stats.duplicated[al], netsim_stats.reordered[al], netsim_stats.corrupted[al]);
+  }
+}
+
+
+/* fills dir with the files of the mock server, and removes whatever the
+ * write workload left there. returns 0 on success */
+static int populate(const char *dir) {
+  static unsigned char buff[4096];
+  char path[4096];
+  unsigned long pos;
+  unsigned short i;
+  FILE *fd;
+  int n;
+  for (n = 0; n < MOCK_FILES; n++) {
+    sprintf(path, "%.4000s/file%04d.dat", dir, n);
+    fd = fopen(path, "wb");
+    if (fd == NULL) return(-1);
+    for (pos = 0; pos < mock_fsize; pos += i) {
+      for (i = 0; (i < sizeof(buff)) && (pos + i < mock_fsize); i++) buff[i] = MOCK_BYTE(pos + i);
+      fwrite(buff, 1, i, fd);
+    }
+    if (fclose(fd) != 0) return(-1);
+  }
+  sprintf(path, "%.4000s/newfile.dat", dir);
+  remove(path);
+  return(0);
+}
+
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return(ts.tv_sec + (ts.tv_nsec / 1e9));
+}
+
+
+/* open and close a file */
+static unsigned long run_open(void) {
+  int fh, err;
+  err = host_open("\\FILE0000.DAT", 0, &fh);
+  if (err != 0) {
+    fail("open", err);
+    return(1);
+  }
+  err = host_close(fh);
+  if (err != 0) fail("close", err);
+  return(2);
+}
+
+
+/* get attributes of all files of the directory */
+static unsigned long run_stat(void) {
+  char path[16];
+  unsigned short attr;
+  unsigned long size;
+  int i, err;
+  for (i = 0; i < MOCK_FILES; i++) {
+    sprintf(path, "\\FILE%04d.DAT", i);
+    err = host_getattr(path, &attr, &size);
+    if (err != 0) {
+      fail("getattr", err);
+    } else if ((size != mock_fsize) || (attr != 0x20)) {
+      fail("getattr (wrong answer)", 0);
+    }
+  }
+  return(MOCK_FILES);
+}
+
+
+/* list the directory */
+static unsigned long run_dir(void) {
+  struct host_find f;
+  unsigned long calls = 1, count = 0;
+  int err = host_findfirst("\\FILE????.DAT", 0x20, &f);
+  while (err == 0) {
+    count++;
+    calls++;
+    err = host_findnext(&f);
+  }
+  if (err != 18) fail("findnext", err);
+  if (count != MOCK_FILES) fail("findnext (wrong amount of files)", 0);
+  return(calls);
+}
+
+
+/* read a whole file sequentially, blksz bytes at a time */
+static unsigned long run_read(void) {
+  static unsigned char buff[65535];
+  unsigned long pos = 0, calls = 2;
+  unsigned short len, i;
+  int fh, err;
+  err = host_open("\\FILE0000.DAT", 0, &fh);
+  if (err != 0) {
+    fail("open", err);
+    return(1);
+  }
+  for (;;) {
+    calls++;
+    err = host_read(fh, buff, blksz, &len);
+    if (err != 0) {
+      fail("read", err);
+      break;
+    }
+    for (i = 0; i < len; i++) {
+      if (buff[i] != MOCK_BYTE(pos + i)) break;
+    }
+    if (i != len) fail("read (wrong data)", 0);
+    pos += len;
+    if (len < blksz) break;
+  }
+  if (pos != mock_fsize) fail("read (wrong length)", 0);
+  err = host_close(fh);
+  if (err != 0) fail("close", err);
+  return(calls);
+}
+
+
+/* write a file of mock_fsize bytes sequentially, blksz bytes at a time */
+static unsigned long run_write(void) {
+  static unsigned char buff[65535];
+  unsigned long pos, calls = 2;
+  unsigned short len;
+  int fh, err;
+  err = host_create("\\NEWFILE.DAT", 0x20, &fh);
+  if (err != 0) {
+    fail("create", err);
+    return(1);
+  }
+  for (pos = 0; pos < mock_fsize; pos += len) {
+    len = blksz;
+    if (len > mock_fsize - pos) len = mock_fsize - pos;
+    memset(buff, pos & 0xff, len);
+    calls++;
+    err = host_write(fh, buff, len, &len);
+    if (err != 0) {
+      fail("write", err);
+      break;
+    }
+  }
+  err = host_close(fh);
+  if (err != 0) fail("close", err);
+  return(calls);
+}
+
+
+static struct {
+  const char *name;
+  unsigned long (*run)(void);
+  const char *desc;
+} tests[] = {
+  {"open",  run_open,  "open and close a file"},
+  {"stat",  run_stat,  "get attributes of all files"},
+  {"dir",   run_dir,   "list a directory"},
+  {"read",  run_read,  "read a file"},
+  {"write", run_write, "write a file"},
+  {NULL, NULL, NULL}
+};
+
+
+static void help(void) {
+  int i;
+  puts("edfbench - runs EtherDFS through typical workloads, against a simulated server\n"
+       "\n"
+       "Usage: edfbench [options] [workload ...]\n"
+       "\n"
+       "Options:\n"
+       "  -n N   repeat each workload N times (default: 100)\n"
+       "  -l N   answers of the server come N microseconds late (default: 0)\n"
+       "  -d DIR use the reference server, serving DIR (its content is replaced)\n"
+       "  -t N   the reference server spends N microseconds on each query\n"
+       "  -c N   the reference server supports extensions N (default: 31)\n"
+       "  -p P   frames go through a simulated link with profile P, that is a\n"
+       "         profile name and/or settings, eg. \"lossy,dup=1\" (see below)\n"
+       "  -S N   seed of the simulated link (default: 1)\n"
+       "  -s N   read and write N bytes at a time (default: 512)\n"
+       "  -k N   mock files are N KiB long (default: 256)\n"
+       "  -a N   same as the /a=N option of EtherDFS\n"
+       "  -b N   same as the /b=N option of EtherDFS\n"
+       "  -f N   same as the /f=N option of EtherDFS\n"
+       "  -r N   same as the /r=N option of EtherDFS\n"
+       "  -w N   same as the /w=N option of EtherDFS\n"
+       "  -z     same as the /z option of EtherDFS\n"
+       "  -R F   replay the trace F (written by etherdfs /t=F) instead of running\n"
+       "         workloads, against the reference server (-d), once by default.\n"
+       "         Files and directories the trace expects are created in DIR\n"
+       "  -T     keep the time that went by between calls of the trace\n"
+       "\n"
+       "Workloads (all of them by default):");
+  for (i = 0; tests[i].name != NULL; i++) printf("  %-6s %s\n", tests[i].name, tests[i].desc);
+  puts("\n"
+       "Link profiles:");
+  netsim_listprofiles();
+  puts("\n"
+       "Link settings: drop, burst, dup, reorder and corrupt are chances in\n"
+       "percent, delay, jitter and hold are times in microseconds.");
+}
+
+
+int main(int argc, char **argv) {
+  struct host_cfg cfg;
+  struct refsrv_cfg srvcfg;
+  struct netsim_cfg simcfg;
+  struct replay_stats rst;
+  const char *dir = NULL, *profile = NULL, *trace = NULL;
+  host_peerfn server;
+  unsigned long n = 0, iter, calls, clk, frames, latency = 0;
+  double t;
+  int i, argi, selected = 0, faithful = 0;
+  char *sel[16];
+
+  host_defcfg(&cfg);
+  refsrv_defcfg(&srvcfg, NULL);
+  simcfg.seed = 1;
+  mock_fsize = 256 * 1024lu;
+  for (argi = 1; argi < argc; argi++) {
+    char *a = argv[argi];
+    if ((a[0] != '-') || (a[1] == 0) || (a[2] != 0)) {
+      if (selected == 16) {
+        help();
+        return(1);
+      }
+      sel[selected++] = a;
+      continue;
+    }
+    if (a[1] == 'z') {
+      cfg.compress = 1;
+      continue;
+    }
+    if (a[1] == 'T') {
+      faithful = 1;
+      continue;
+    }
+    if ((a[1] == 'h') || (argi + 1 == argc)) {
+      help();
+      return(1);
+    }
+    argi++;
+    switch (a[1]) {
+      case 'n': n = strtoul(argv[argi], NULL, 10); break;
+      case 'l': latency = us2pit(strtoul(argv[argi], NULL, 10)); break;
+      case 'd': dir = argv[argi]; break;
+      case 't': srvcfg.service = us2pit(strtoul(argv[argi], NULL, 10)); break;
+      case 'c': srvcfg.caps = strtoul(argv[argi], NULL, 0); break;
+      case 'p': profile = argv[argi]; break;
+      case 'S': simcfg.seed = strtoul(argv[argi], NULL, 10); break;
+      case 's': blksz = strtoul(argv[argi], NULL, 10); break;
+      case 'k': mock_fsize = strtoul(argv[argi], NULL, 10) * 1024; break;
+      case 'a': cfg.mdttl = atoi(argv[argi]); break;
+      case 'b': cfg.rxslots = atoi(argv[argi]); break;
+      case 'f': cfg.framesize = atoi(argv[argi]); break;
+      case 'r': cfg.racaches = atoi(argv[argi]); break;
+      case 'w': cfg.wbcaches = atoi(argv[argi]); break;
+      case 'R': trace = argv[argi]; break;
+      default:
+        help();
+        return(1);
+    }
+  }
+  if (blksz == 0) blksz = 1;
+  if (n == 0) n = (trace != NULL)?1:100;
+  /* a trace is replayed against the reference server only, serving a
+   * directory that holds what the trace expects */
+  if ((trace != NULL) && ((dir == NULL) || (selected != 0))) {
+    help();
+    return(1);
+  }
+  if ((trace != NULL) && (replay_load(trace) < 0)) {
+    fprintf(stderr, "%s is not a trace file\n", trace);
+    return(1);
+  }
+
+  mock_delay = latency;
+  server = mock_peer;
+  if (dir != NULL) {
+    srvcfg.root = dir;
+    srvcfg.latency = latency;
+    memcpy(srvcfg.mac, cfg.srvmac, 6);
+    srvcfg.drive = cfg.rdrv - 'A';
+    if (((trace == NULL) && (populate(dir) != 0)) || ((trace != NULL) && (replay_prepare(dir) < 0))) {
+      fprintf(stderr, "failed to fill directory %s\n", dir);
+      return(1);
+    }
+    server = refpeer;
+  }
+  host_peer = server;
+  if (profile != NULL) {
+    if (netsim_profile(&simcfg, profile) != 0) {
+      help();
+      return(1);
+    }
+    netsim_init(&simcfg, server);
+    host_peer = netsim_fromclient;
+    host_oncall = oncall;
+    mock_send = netsim_fromserver;
+    srvsend = netsim_fromserver;
+  }
+  if (trace != NULL) {
+    if (refsrv_init(&srvcfg) != 0) {
+      fprintf(stderr, "%s is not a directory\n", dir);
+      return(1);
+    }
+    if (host_init(&cfg) != 0) {
+      fprintf(stderr, "out of memory\n");
+      return(1);
+    }
+    host_oncall = oncall;
+    netsim_take(&calls);
+    memset(&rst, 0, sizeof(rst));
+    clk = host_clock;
+    frames = host_stats.txframes;
+    t = now();
+    for (iter = 0; iter < n; iter++) replay_run(faithful, &rst);
+    t = now() - t;
+    clk = host_clock - clk;
+    frames = host_stats.txframes - frames;
+    if (t <= 0) t = 1e-9;
+    if (rst.calls == 0) rst.calls = 1;
+    printf("%-6s %8lu calls %9.0f calls/s %6.2f frames/call %10.1f us/call simulated\n",
+           "replay", rst.calls, rst.calls / t, (double)frames / rst.calls,
+           (double)(clk - rst.idle) * TICKUS / 1024 / rst.calls);
+    printf("%lu records skipped, %lu calls diverged from the trace, %.3f s simulated (%.3f s between calls)\n",
+           rst.skipped, rst.diverged, (double)clk * TICKUS / 1024 / 1e6, (double)rst.idle * TICKUS / 1024 / 1e6);
+    report(profile != NULL);
+  }
+
+  for (i = 0; (trace == NULL) && (tests[i].name != NULL); i++) {
+    if (selected != 0) {
+      for (argi = 0; (argi < selected) && (strcmp(sel[argi], tests[i].name) != 0); argi++);
+      if (argi == selected) continue;
+    }
+    if ((dir != NULL) && (refsrv_init(&srvcfg) != 0)) {
+      fprintf(stderr, "%s is not a directory\n", dir);
+      return(1);
+    }
+    if (host_init(&cfg) != 0) {
+      fprintf(stderr, "out of memory\n");
+      return(1);
+    }
+    netsim_take(&calls); /* frames of host_init() are none of the workload's */
+    calls = 0;
+    clk = host_clock;
+    frames = host_stats.txframes;
+    t = now();
+    for (iter = 0; iter < n; iter++) calls += tests[i].run();
+    t = now() - t;
+    clk = host_clock - clk;
+    frames = host_stats.txframes - frames;
+    if (t <= 0) t = 1e-9;
+    printf("%-6s %8lu calls %9.0f calls/s %6.2f frames/call %10.1f us/call simulated\n",
+           tests[i].name, calls, calls / t, (double)frames / calls,
+           (double)clk * TICKUS / 1024 / calls);
+  }
+
+  if ((trace == NULL) && (profile != NULL)) report(1);
+
+  if (errors != 0) {
+    fprintf(stderr, "%lu errors\n", errors);
+    return(1);
+  }
+  return(0);
+}
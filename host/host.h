@@ -0,0 +1,131 @@
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * Interface of the host build of EtherDFS: the resident core of etherdfs.c
+ * compiled natively on a development machine, along with a simulated packet
+ * driver and in-memory DOS structures (SDA, SFT, DTA) - see hostcore.c.
+ *
+ * Time is simulated, too: the clock advances by one pit_now() unit (1/1024th
+ * of a BIOS tick, about 54us) every time EtherDFS looks at it, and frames
+ * sent to EtherDFS are delivered once the clock reaches the time they are
+ * due. Nothing depends on the speed of the machine, so a given run always
+ * ends the same way.
+ */
+
+#ifndef HOST_SENTINEL
+#define HOST_SENTINEL
+
+/* amount of files that may be open at the same time */
+#define HOST_FILES 16
+
+/* the simulated packet driver refuses frames bigger than that (MAC headers
+ * included), as would a plain ethernet card */
+#define HOST_MTU 1514
+
+/* configuration of the simulated EtherDFS, ie. what would be given to it on
+ * the command line (see host_defcfg() for default values) */
+struct host_cfg {
+  unsigned char lmac[6];     /* MAC address of the simulated packet driver */
+  unsigned char srvmac[6];   /* MAC address of the server */
+  char ldrv;                 /* local drive letter */
+  char rdrv;                 /* remote drive letter */
+  unsigned short framesize;  /* /f=N (0 = let the server and the MTU decide) */
+  unsigned char rxslots;     /* /b=N */
+  unsigned char racaches;    /* /r=N */
+  unsigned char wbcaches;    /* /w=N */
+  unsigned char mdttl;       /* /a=N */
+  unsigned char compress;    /* /z */
+};
+
+/* a directory entry, as found by host_findfirst() and host_findnext() */
+struct host_find {
+  unsigned char dta[128];    /* DTA of the search, as DOS would keep it */
+  char name[13];             /* name of the file found ("FILE.TXT") */
+  unsigned char attr;
+  unsigned short time;
+  unsigned short date;
+  unsigned long size;
+};
+
+/* frame counters of the simulated packet driver */
+struct host_stats {
+  unsigned long txframes;    /* frames sent by EtherDFS */
+  unsigned long txbytes;
+  unsigned long rxframes;    /* frames that made it to the receive ring */
+  unsigned long rxbytes;
+  unsigned long rxignored;   /* frames pktdrv_recv() would have dropped */
+  unsigned long rxrefused;   /* frames refused because the ring was full */
+};
+
+/* the server side of the simulated network: it is handed every frame that
+ * EtherDFS sends, and answers (if it wants to) through host_post() */
+typedef void (*host_peerfn)(const unsigned char *frame, unsigned short len);
+
+/* called at the end of every call made to EtherDFS, with the subfunction
+ * (AL), the DOS error code returned (0 on success), the time the call took
+ * (in pit_now() units) and CX on return (bytes read or written, for READFIL
+ * and WRITEFIL) */
+typedef void (*host_callfn)(unsigned char al, int err, unsigned long clocks, unsigned short cx);
+
+extern host_peerfn host_peer;
+extern host_callfn host_oncall;   /* NULL if nobody cares */
+extern unsigned long host_clock;  /* current time, in pit_now() units */
+extern struct host_stats host_stats;
+
+/* queues frame for EtherDFS, to be received delay pit_now() units from now.
+ * frames due at the same time are received in the order they were posted */
+void host_post(const unsigned char *frame, unsigned short len, unsigned long delay);
+
+/* same as host_post(), but the frame is handed to 'to' instead of EtherDFS
+ * (this is how frames may be held back on their way to the server) */
+void host_postto(host_peerfn to, const unsigned char *frame, unsigned short len, unsigned long delay);
+
+/* lets time go by for units pit_now() units, receiving frames due meanwhile */
+void host_sleep(unsigned long units);
+
+/* fills cfg with EtherDFS defaults: drive X: mapped to C:, server at
+ * 02:00:00:00:00:01 and packet driver at 02:00:00:00:00:02 */
+void host_defcfg(struct host_cfg *cfg);
+
+/* sets EtherDFS up as its main() would, and negotiates protocol extensions
+ * with the server (host_peer must be set already). any state left by a
+ * previous host_init() is forgotten. returns 0 on success, -1 if memory
+ * cannot be allocated */
+int host_init(const struct host_cfg *cfg);
+
+/* these are the calls DOS makes to the redirector, done the way DOS would do
+ * them. paths are given without the drive letter ("\DIR\FILE.TXT"), and *fh
+ * is a file handle (an index of the SFT). all of them return 0 on success,
+ * or the DOS error code that EtherDFS answered */
+int host_open(const char *path, unsigned short mode, int *fh);
+int host_create(const char *path, unsigned short attr, int *fh);
+int host_spopen(const char *path, unsigned short action, unsigned short mode, unsigned short attr, int *fh, unsigned short *result);
+int host_close(int fh);
+int host_commit(int fh);
+int host_read(int fh, void *buff, unsigned short len, unsigned short *done);
+int host_write(int fh, const void *buff, unsigned short len, unsigned short *done);
+void host_seek(int fh, unsigned long pos);
+int host_seekend(int fh, long offs, unsigned long *pos);
+int host_getattr(const char *path, unsigned short *attr, unsigned long *size);
+int host_setattr(const char *path, unsigned short attr);
+int host_delete(const char *path);
+int host_rename(const char *oldpath, const char *newpath);
+int host_mkdir(const char *path);
+int host_rmdir(const char *path);
+int host_chdir(const char *path);
+int host_diskspace(unsigned long *total, unsigned long *avail);
+int host_findfirst(const char *path, unsigned char attr, struct host_find *f);
+int host_findnext(struct host_find *f);
+
+/* asks for a server-side copy of len bytes (see MPX_SRVCOPY in mplex.h),
+ * *len is set to the amount of bytes copied. returns the AX value of the
+ * multiplex call */
+int host_srvcopy(int src, int dst, unsigned long *len);
+
+/* does what EtherDFS does when DOS is idle (see idlehandler()) */
+void host_idle(void);
+
+#endif
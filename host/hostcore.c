@@ -0,0 +1,636 @@
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * Host build of EtherDFS: the resident part of etherdfs.c is compiled here as
+ * it is (with HOSTBUILD defined), and whatever it would normally get from the
+ * hardware, the packet driver or DOS is simulated - see host.h.
+ *
+ * etherdfs.c is written for a 16-bit compiler, so a few things need to be
+ * arranged before it can be compiled by a 32/64-bit one: far pointers become
+ * plain pointers, 'long' is made 32 bits, and far addresses built out of a
+ * segment and an offset (ES:DI) point into a table of host_seg[] buffers.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#define HOSTBUILD
+#define far
+#define __far
+#define __interrupt
+#define __declspec(x)
+
+/* ES:DI pointers given to EtherDFS refer to one of these buffers (ES is the
+ * index in host_seg[], DI the offset in the buffer). EtherDFS never learns
+ * the real segment of a host pointer (which has none), so its direct receive
+ * path always gives up, and all data goes through the receive ring */
+#define HOST_SEGMAX 4
+static unsigned char *host_seg[HOST_SEGMAX];
+#define MK_FP(s, o) ((void *)(host_seg[(s) & (HOST_SEGMAX - 1)] + (o)))
+#define FP_SEG(p) ((void)(p), 0)
+#define FP_OFF(p) 0xFFFFu
+
+/* registers of an interrupt call, laid out as with Open Watcom (i86.h) */
+#define INTR_CF 0x0001
+union INTPACK {
+  struct {
+    unsigned short gs, fs, es, ds, di, si, bp, sp, bx, dx, cx, ax, ip, cs, flags;
+  } w, x;
+  struct {
+    unsigned char rfu[16];
+    unsigned char bl, bh, dl, dh, cl, ch, al, ah;
+  } h;
+};
+
+/* the simulated counterparts of asm routines of etherdfs.c */
+static unsigned short pit_now(void);
+static void pktdrv_send(unsigned short frmlen);
+static unsigned short biostick(void);
+static void copybytes(void *d, const void *s, unsigned int l);
+static unsigned short mystrlen(const void *s);
+static void tracexmsput(void);
+
+#define long int
+#include "../etherdfs.c"
+#undef long
+#pragma pack()
+
+#include "host.h"
+
+/* frames on their way, to EtherDFS or to whoever host_postto() says */
+#define HOST_WIREMAX 256
+static struct {
+  unsigned long due;   /* host_clock at which the frame is received */
+  unsigned long order; /* frames due at the same time go in this order */
+  host_peerfn to;      /* receiver of the frame */
+  unsigned short len;  /* 0 = entry unused */
+  unsigned char frame[FRAMESIZEMAX];
+} host_wire[HOST_WIREMAX];
+static unsigned long host_wireorder;
+static unsigned short host_wirecount;   /* frames waiting in host_wire[] */
+static unsigned long host_wirenext;     /* due time of the first of them */
+
+host_peerfn host_peer;
+host_callfn host_oncall;
+unsigned long host_clock;
+struct host_stats host_stats;
+
+/* in-memory DOS structures */
+static struct sdastruct host_sda;
+static struct sftstruct host_sft[HOST_FILES];
+static unsigned char host_cds[67];
+static unsigned char *host_arena; /* what would live past DATASEGSZ */
+
+/* host_seg[] indexes */
+#define HOST_SEGSFT 1
+#define HOST_SEGDTA 2
+#define HOST_SEGMPX 3
+
+
+/* the C counterpart of pktdrv_recv(): frame lands in the receive ring if
+ * there is room, and if it is an answer to one of the pending queries */
+static void host_recv(const unsigned char *frame, unsigned short len) {
+  struct rxslot *slot = glob_rxhead;
+  if ((len > glob_framesize) || (slot->len != 0)) {
+    host_stats.rxrefused++;
+    glob_stats.rxbusy++;
+    return;
+  }
+  if ((len < 60) || (frame[12] != 0xED) || (frame[13] != 0xF5)
+   || ((unsigned char)(frame[57] - glob_rxseqlo) > (unsigned char)(glob_seq - glob_rxseqlo))
+   || (memcmp(frame, GLOB_LMAC, 6) != 0)
+   || ((glob_rxanysrc == 0) && (memcmp(frame + 6, GLOB_RMAC, 6) != 0))) {
+    host_stats.rxignored++;
+    glob_stats.rxignored++;
+    return;
+  }
+  memcpy(slot->buff, frame, len);
+  slot->hit = 0;
+  slot->len = len;
+  host_stats.rxframes++;
+  host_stats.rxbytes += len;
+  glob_stats.rxframes++;
+  glob_rxhead = (slot + 1 == glob_rxend)?glob_rxslot:(slot + 1);
+}
+
+
+/* receives all frames that are due by now, oldest first */
+static void host_pump(void) {
+  int i, next;
+  while ((host_wirecount != 0) && (host_wirenext <= host_clock)) {
+    next = -1;
+    for (i = 0; i < HOST_WIREMAX; i++) {
+      if (host_wire[i].len == 0) continue;
+      if ((next < 0) || (host_wire[i].due < host_wire[next].due)
+       || ((host_wire[i].due == host_wire[next].due) && (host_wire[i].order < host_wire[next].order))) next = i;
+    }
+    host_wirenext = host_wire[next].due;
+    if (host_wirenext > host_clock) return;
+    /* the entry is released only after the receiver is done with it, as
+     * the receiver may post frames of its own */
+    host_wire[next].to(host_wire[next].frame, host_wire[next].len);
+    host_wire[next].len = 0;
+    host_wirecount--;
+  }
+}
+
+
+void host_postto(host_peerfn to, const unsigned char *frame, unsigned short len, unsigned long delay) {
+  int i;
+  if ((len == 0) || (len > FRAMESIZEMAX)) return;
+  for (i = 0; (i < HOST_WIREMAX) && (host_wire[i].len != 0); i++);
+  if (i == HOST_WIREMAX) { /* the wire is full, the frame is lost */
+    host_stats.rxrefused++;
+    return;
+  }
+  memcpy(host_wire[i].frame, frame, len);
+  host_wire[i].to = to;
+  host_wire[i].len = len;
+  host_wire[i].due = host_clock + delay;
+  host_wire[i].order = host_wireorder++;
+  if ((host_wirecount == 0) || (host_wire[i].due < host_wirenext)) host_wirenext = host_wire[i].due;
+  host_wirecount++;
+}
+
+
+void host_post(const unsigned char *frame, unsigned short len, unsigned long delay) {
+  host_postto(host_recv, frame, len, delay);
+}
+
+
+void host_sleep(unsigned long units) {
+  host_clock += units;
+  host_pump();
+}
+
+
+static unsigned short pit_now(void) {
+  host_clock++;
+  host_pump();
+  return((unsigned short)host_clock);
+}
+
+
+static unsigned short biostick(void) {
+  return((unsigned short)(host_clock >> 10));
+}
+
+
+static void copybytes(void *d, const void *s, unsigned int l) {
+  memcpy(d, s, l);
+}
+
+
+static unsigned short mystrlen(const void *s) {
+  return(strlen(s));
+}
+
+
+static void tracexmsput(void) {
+  /* there is no XMS in the host build */
+}
+
+
+static void pktdrv_send(unsigned short frmlen) {
+  host_stats.txframes++;
+  host_stats.txbytes += frmlen;
+  glob_stats.txframes++;
+  if (host_peer != NULL) host_peer(glob_pktdrv_sndbuff, frmlen);
+}
+
+
+void host_defcfg(struct host_cfg *cfg) {
+  static const unsigned char lmac[6] = {2, 0, 0, 0, 0, 2};
+  static const unsigned char srvmac[6] = {2, 0, 0, 0, 0, 1};
+  memset(cfg, 0, sizeof(*cfg));
+  memcpy(cfg->lmac, lmac, 6);
+  memcpy(cfg->srvmac, srvmac, 6);
+  cfg->ldrv = 'X';
+  cfg->rdrv = 'C';
+  cfg->rxslots = RXSLOTS;
+  cfg->racaches = RACACHES;
+  cfg->wbcaches = WBCACHES;
+  cfg->mdttl = MDTTL;
+}
+
+
+int host_init(const struct host_cfg *cfg) {
+  unsigned char hdr[60];
+  unsigned short room, bufsz, wbarea, dirarea, mdarea, lzarea, n;
+  unsigned char drv, rxslots, racaches, wbcaches;
+  int i;
+
+  /* forget everything about the previous run */
+  free(host_arena);
+  host_arena = malloc(DATASEGMAX - DATASEGSZ);
+  if (host_arena == NULL) return(-1);
+  memset(host_arena, 0, DATASEGMAX - DATASEGSZ);
+  memset(host_wire, 0, sizeof(host_wire));
+  host_wirecount = 0;
+  memset(&host_stats, 0, sizeof(host_stats));
+  memset(&glob_stats, 0, sizeof(glob_stats));
+  memset(&host_sda, 0, sizeof(host_sda));
+  memset(host_sft, 0, sizeof(host_sft));
+  memset(glob_rxslot, 0, sizeof(glob_rxslot));
+  memset(glob_racache, 0, sizeof(glob_racache));
+  memset(glob_wbcache, 0, sizeof(glob_wbcache));
+  memset(&glob_dircache, 0, sizeof(glob_dircache));
+  memset(glob_data.ldrv, 0xff, sizeof(glob_data.ldrv));
+  memset(glob_drvsrv, 0, sizeof(glob_drvsrv));
+  memset(glob_drvpri, 0, sizeof(glob_drvpri));
+  memset(glob_drvgen, 0, sizeof(glob_drvgen));
+  memset(glob_srvnext, 0xff, sizeof(glob_srvnext));
+  glob_raend = glob_racache;
+  glob_wbend = glob_wbcache;
+  glob_mdcache = glob_mdend = NULL;
+  glob_lzhash = NULL;
+  glob_dirmax = 0;
+  glob_rastamp = glob_wbstamp = glob_mdstamp = 0;
+  glob_wbdirty = glob_failover = 0;
+  glob_probetick = 0;
+  memset(glob_srtt, 0, sizeof(glob_srtt));
+  memset(glob_rttvar, 0, sizeof(glob_rttvar));
+  for (i = 0; i < SRVMAX; i++) glob_rto[i] = RTOINIT;
+  glob_seq = 0;
+  glob_directlen = 0;
+  glob_busy = 0;
+  glob_sdaptr = &host_sda;
+
+  drv = DRIVETONUM(cfg->ldrv);
+  glob_data.ldrv[drv] = DRIVETONUM(cfg->rdrv);
+  memcpy(glob_srvmac[0], cfg->srvmac, 6);
+
+  /* a single receive slot and the send buffer, until the frame size is known
+   * (the frame size can't be any bigger than the MTU) */
+  glob_framesize = (cfg->framesize != 0)?cfg->framesize:HOST_MTU;
+  glob_rxslot[0].buff = host_arena;
+  glob_rxhead = glob_rxtail = glob_rxslot;
+  glob_rxend = glob_rxslot + 1;
+  glob_pktdrv_recvbuff = glob_rxslot[0].buff;
+  glob_pktdrv_sndbuff = glob_pktdrv_recvbuff + glob_framesize;
+  glob_pktdrv_sndbuff[12] = 0xED;
+  glob_pktdrv_sndbuff[13] = 0xF5;
+  glob_pktdrv_sndbuff[56] = PROTOVER;
+  memcpy(GLOB_LMAC, cfg->lmac, 6);
+
+  /* negotiate protocol extensions and the frame size, as main() does */
+  glob_srvcaps = CAP_WRITESTREAM | CAP_READBULK | CAP_FINDBATCH | CAP_SRVCOPY;
+  if (cfg->compress != 0) glob_srvcaps |= CAP_COMPRESS;
+  glob_framedef = (cfg->framesize == 0)?FRAMESIZE:0;
+  glob_srvunknown = 1;
+  srvgetcaps(drv);
+
+  /* lay out buffers the way main() does (and within the same limits) */
+  rxslots = cfg->rxslots;
+  racaches = cfg->racaches;
+  wbcaches = cfg->wbcaches;
+  if (rxslots > RXSLOTSMAX) rxslots = RXSLOTSMAX;
+  if (rxslots < 1) rxslots = 1;
+  if (racaches > RACACHEMAX) racaches = RACACHEMAX;
+  if (wbcaches > WBCACHEMAX) wbcaches = WBCACHEMAX;
+  room = DATASEGMAX - DATASEGSZ;
+  if ((glob_srvcaps & CAP_FINDBATCH) != 0) {
+    n = (glob_framesize - 61) / 24;
+    if (n > DIRBATCHMAX) n = DIRBATCHMAX;
+    glob_dirmax = n;
+    room -= glob_dirmax * 24;
+  }
+  glob_mdttl = (cfg->mdttl * 91) / 5;
+  glob_negttl = (glob_mdttl < NEGTTL)?glob_mdttl:NEGTTL;
+  if (glob_mdttl != 0) room -= MDCACHES * sizeof(struct mdcache);
+  if ((glob_srvcaps & CAP_COMPRESS) != 0) room -= 256 * 2;
+  if (rxslots > (room / glob_framesize) - 1) rxslots = (room / glob_framesize) - 1;
+  bufsz = (rxslots + 1) * glob_framesize;
+  room -= bufsz;
+  glob_rabufsz = RAFRAMES * (glob_framesize - 60);
+  if (racaches > room / glob_rabufsz) racaches = room / glob_rabufsz;
+  for (i = 0; i < racaches; i++) {
+    glob_racache[i].drive = 0xff;
+    glob_racache[i].buff = host_arena + bufsz + (i * glob_rabufsz);
+  }
+  glob_raend = glob_racache + racaches;
+  if (racaches == 0) glob_rabufsz = 0;
+  wbarea = bufsz + (racaches * glob_rabufsz);
+  room -= racaches * glob_rabufsz;
+  glob_wbbufsz = WBFRAMES * (glob_framesize - 69);
+  if (wbcaches > room / glob_wbbufsz) wbcaches = room / glob_wbbufsz;
+  for (i = 0; i < wbcaches; i++) {
+    glob_wbcache[i].drive = 0xff;
+    glob_wbcache[i].buff = host_arena + wbarea + (i * glob_wbbufsz);
+  }
+  glob_wbend = glob_wbcache + wbcaches;
+  if (wbcaches == 0) glob_wbbufsz = 0;
+  dirarea = wbarea + (wbcaches * glob_wbbufsz);
+  glob_dircache.drive = 0xff;
+  glob_dircache.buff = host_arena + dirarea;
+  mdarea = dirarea + (glob_dirmax * 24);
+  glob_mdcache = (struct mdcache *)(host_arena + mdarea);
+  glob_mdend = glob_mdcache;
+  if (glob_mdttl != 0) {
+    glob_mdend = glob_mdcache + MDCACHES;
+    for (i = 0; i < MDCACHES; i++) glob_mdcache[i].drive = 0xff;
+  }
+  lzarea = mdarea + ((glob_mdend - glob_mdcache) * sizeof(struct mdcache));
+  if ((glob_srvcaps & CAP_COMPRESS) != 0) {
+    glob_lzhash = (unsigned short *)(host_arena + lzarea);
+  }
+  memcpy(hdr, glob_pktdrv_sndbuff, 60);
+  for (i = 0; i < rxslots; i++) {
+    glob_rxslot[i].len = 0;
+    glob_rxslot[i].buff = host_arena + (i * glob_framesize);
+  }
+  glob_rxhead = glob_rxtail = glob_rxslot;
+  glob_rxend = glob_rxslot + rxslots;
+  glob_pktdrv_recvbuff = glob_rxslot[0].buff;
+  glob_pktdrv_sndbuff = host_arena + (rxslots * glob_framesize);
+  memcpy(glob_pktdrv_sndbuff, hdr, 60);
+
+  /* the drive's CDS, its current directory being the root */
+  host_cds[0] = cfg->ldrv;
+  host_cds[1] = ':';
+  host_cds[2] = '\\';
+  host_cds[3] = 0;
+  host_sda.drive_cdsptr = host_cds;
+  host_seg[HOST_SEGSFT] = (unsigned char *)host_sft;
+  return(0);
+}
+
+
+/* sets fn1 (and fcb_fn1) of the SDA to path, on my drive */
+static void host_setfn1(const char *path) {
+  unsigned char *p;
+  int i;
+  host_sda.fn1[0] = host_cds[0];
+  host_sda.fn1[1] = ':';
+  for (i = 0; (path[i] != 0) && (i < 125); i++) host_sda.fn1[i + 2] = path[i];
+  host_sda.fn1[i + 2] = 0;
+  /* the FCB-style name of the last path component, as inthandler() does */
+  p = host_sda.fn1;
+  for (i = 0; host_sda.fn1[i] != 0; i++) {
+    if (host_sda.fn1[i] == '\\') p = host_sda.fn1 + i + 1;
+  }
+  memset(host_sda.fcb_fn1, ' ', 11);
+  for (i = 0; (*p != 0) && (i < 11); p++) {
+    if (*p == '.') {
+      i = 8;
+    } else {
+      host_sda.fcb_fn1[i++] = *p;
+    }
+  }
+}
+
+
+/* calls process2f() for the redirector subfunction al on my drive, the way
+ * inthandler() would, with ES:DI pointing at offset di of host_seg[es] and
+ * CX:DX set to cx and dx. registers set by EtherDFS are left in glob_intregs.
+ * returns 0 on success, the DOS error code otherwise */
+static int host_call(unsigned char al, unsigned short es, unsigned short di, unsigned short cx, unsigned short dx) {
+  unsigned long start = host_clock;
+  int err = 0;
+  if ((al > 0x2E) || (supportedfunctions[al] == AL_UNKNOWN)) return(1);
+  memset(&glob_intregs, 0, sizeof(glob_intregs));
+  glob_intregs.h.ah = 0x11;
+  glob_intregs.h.al = al;
+  glob_intregs.x.es = es;
+  glob_intregs.x.di = di;
+  glob_intregs.x.cx = cx;
+  glob_intregs.x.dx = dx;
+  glob_reqdrv = DRIVETONUM(host_cds[0]);
+  glob_busy = 1;
+  process2f();
+  glob_busy = 0;
+  if ((glob_intregs.w.flags & INTR_CF) != 0) err = glob_intregs.w.ax;
+  if (host_oncall != NULL) host_oncall(al, err, host_clock - start, glob_intregs.w.cx);
+  return(err);
+}
+
+
+/* returns non-zero if fh is the handle of an open file */
+static int host_isopen(int fh) {
+  return((fh >= 0) && (fh < HOST_FILES) && (host_sft[fh].handle_count != 0));
+}
+
+
+/* same as host_call(), for a call that relates to the open file fh */
+static int host_filecall(unsigned char al, int fh, unsigned short cx, unsigned short dx) {
+  if (host_isopen(fh) == 0) return(6); /* "invalid handle" */
+  return(host_call(al, HOST_SEGSFT, fh * sizeof(struct sftstruct), cx, dx));
+}
+
+
+/* same as host_call(), for a call that takes path as fn1 */
+static int host_pathcall(unsigned char al, const char *path) {
+  host_setfn1(path);
+  return(host_call(al, 0, 0, 0, 0));
+}
+
+
+/* opens or creates path through subfunction al, in a free SFT entry */
+static int host_opencall(unsigned char al, const char *path, unsigned short stkword, unsigned short mode, int *fh) {
+  int i, err;
+  for (i = 0; (i < HOST_FILES) && (host_sft[i].handle_count != 0); i++);
+  if (i == HOST_FILES) return(4); /* "too many open files" */
+  memset(&host_sft[i], 0, sizeof(struct sftstruct));
+  host_sft[i].open_mode = mode;
+  host_setfn1(path);
+  glob_reqstkword = stkword;
+  err = host_call(al, HOST_SEGSFT, i * sizeof(struct sftstruct), 0, 0);
+  if (err != 0) return(err);
+  host_sft[i].handle_count = 1; /* DOS does that */
+  *fh = i;
+  return(0);
+}
+
+
+int host_open(const char *path, unsigned short mode, int *fh) {
+  return(host_opencall(AL_OPEN, path, mode, mode, fh));
+}
+
+
+int host_create(const char *path, unsigned short attr, int *fh) {
+  return(host_opencall(AL_CREATE, path, attr, 2, fh));
+}
+
+
+int host_spopen(const char *path, unsigned short action, unsigned short mode, unsigned short attr, int *fh, unsigned short *result) {
+  int err;
+  host_sda.spop_act = action;
+  host_sda.spop_mode = mode;
+  err = host_opencall(AL_SPOPNFIL, path, attr, mode & 0x7f, fh);
+  if (err == 0) *result = glob_intregs.w.cx;
+  return(err);
+}
+
+
+int host_close(int fh) {
+  int err = host_filecall(AL_CLSFIL, fh, 0, 0);
+  if (host_isopen(fh) != 0) host_sft[fh].handle_count = 0; /* DOS forgets the file anyway */
+  return(err);
+}
+
+
+int host_commit(int fh) {
+  return(host_filecall(AL_CMMTFIL, fh, 0, 0));
+}
+
+
+int host_read(int fh, void *buff, unsigned short len, unsigned short *done) {
+  int err;
+  host_sda.curr_dta = buff;
+  err = host_filecall(AL_READFIL, fh, len, 0);
+  *done = (err == 0)?glob_intregs.x.cx:0;
+  return(err);
+}
+
+
+int host_write(int fh, const void *buff, unsigned short len, unsigned short *done) {
+  int err;
+  host_sda.curr_dta = (unsigned char *)buff;
+  err = host_filecall(AL_WRITEFIL, fh, len, 0);
+  *done = glob_intregs.x.cx;
+  return(err);
+}
+
+
+void host_seek(int fh, unsigned long pos) {
+  if (host_isopen(fh) != 0) host_sft[fh].file_pos = pos;
+}
+
+
+int host_seekend(int fh, long offs, unsigned long *pos) {
+  int err = host_filecall(AL_SKFMEND, fh, (unsigned long)offs >> 16, offs & 0xFFFFu);
+  if (err != 0) return(err);
+  *pos = ((unsigned long)glob_intregs.w.dx << 16) | glob_intregs.w.ax;
+  host_sft[fh].file_pos = *pos; /* DOS does that */
+  return(0);
+}
+
+
+int host_getattr(const char *path, unsigned short *attr, unsigned long *size) {
+  int err = host_pathcall(AL_GETATTR, path);
+  if (err != 0) return(err);
+  *attr = glob_intregs.w.ax;
+  *size = ((unsigned long)glob_intregs.w.bx << 16) | glob_intregs.w.di;
+  return(0);
+}
+
+
+int host_setattr(const char *path, unsigned short attr) {
+  glob_reqstkword = attr;
+  return(host_pathcall(AL_SETATTR, path));
+}
+
+
+int host_delete(const char *path) {
+  return(host_pathcall(AL_DELETE, path));
+}
+
+
+int host_rename(const char *oldpath, const char *newpath) {
+  int i;
+  host_sda.fn2[0] = host_cds[0];
+  host_sda.fn2[1] = ':';
+  for (i = 0; (newpath[i] != 0) && (i < 125); i++) host_sda.fn2[i + 2] = newpath[i];
+  host_sda.fn2[i + 2] = 0;
+  return(host_pathcall(AL_RENAME, oldpath));
+}
+
+
+int host_mkdir(const char *path) {
+  return(host_pathcall(AL_MKDIR, path));
+}
+
+
+int host_rmdir(const char *path) {
+  return(host_pathcall(AL_RMDIR, path));
+}
+
+
+int host_chdir(const char *path) {
+  int err = host_pathcall(AL_CHDIR, path);
+  /* DOS updates the CDS once the redirector said that the directory exists */
+  if (err == 0) memcpy(host_cds, host_sda.fn1, sizeof(host_cds) - 1);
+  return(err);
+}
+
+
+int host_diskspace(unsigned long *total, unsigned long *avail) {
+  unsigned long clustsz;
+  int err = host_call(AL_DISKSPACE, 0, 0, 0, 0);
+  if (err != 0) return(err);
+  clustsz = (unsigned long)glob_intregs.w.ax * glob_intregs.w.cx;
+  *total = clustsz * glob_intregs.w.bx;
+  *avail = clustsz * glob_intregs.w.dx;
+  return(0);
+}
+
+
+/* fills f with the directory entry found by the last FINDFIRST/FINDNEXT */
+static void host_found(struct host_find *f) {
+  struct foundfilestruct *ff = &host_sda.found_file;
+  int i, n = 0;
+  for (i = 0; (i < 8) && (ff->fname[i] != ' '); i++) f->name[n++] = ff->fname[i];
+  if (ff->fname[8] != ' ') {
+    f->name[n++] = '.';
+    for (i = 8; (i < 11) && (ff->fname[i] != ' '); i++) f->name[n++] = ff->fname[i];
+  }
+  f->name[n] = 0;
+  f->attr = ff->fattr;
+  f->time = ff->time_lstupd;
+  f->date = ff->date_lstupd;
+  f->size = ff->fsize;
+}
+
+
+int host_findfirst(const char *path, unsigned char attr, struct host_find *f) {
+  int err;
+  memset(f, 0, sizeof(*f));
+  host_sda.curr_dta = f->dta;
+  host_sda.srch_attr = attr;
+  err = host_pathcall(AL_FINDFIRST, path);
+  if (err == 0) host_found(f);
+  return(err);
+}
+
+
+int host_findnext(struct host_find *f) {
+  int err;
+  /* DOS keeps the search data block of the DTA in the SDA, too */
+  memcpy(&host_sda.sdb, f->dta, sizeof(host_sda.sdb));
+  host_seg[HOST_SEGDTA] = f->dta;
+  err = host_call(AL_FINDNEXT, HOST_SEGDTA, 0, 0, 0);
+  if (err == 0) host_found(f);
+  return(err);
+}
+
+
+int host_srvcopy(int src, int dst, unsigned long *len) {
+  struct mpxcopy p;
+  if ((host_isopen(src) == 0) || (host_isopen(dst) == 0)) return(6);
+  p.src = &host_sft[src];
+  p.dst = &host_sft[dst];
+  p.len = *len;
+  host_seg[HOST_SEGMPX] = (unsigned char *)&p;
+  memset(&glob_intregs, 0, sizeof(glob_intregs));
+  glob_intregs.h.ah = glob_multiplexid;
+  glob_intregs.h.al = MPX_SRVCOPY;
+  glob_intregs.x.cx = MPXSIG;
+  glob_intregs.x.es = HOST_SEGMPX;
+  glob_busy = 1;
+  srvcopy();
+  glob_busy = 0;
+  *len = p.len;
+  return(glob_intregs.w.ax);
+}
+
+
+void host_idle(void) {
+  if (((glob_wbdirty | glob_failover) == 0) || (glob_busy != 0)) return;
+  glob_busy = 1;
+  if (glob_wbdirty != 0) wbflushall(1);
+  if (glob_failover != 0) srvprobe();
+  glob_busy = 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * A mock EDF5 server for the host build: it answers every query right away
+ * with made up (but consistent) data and does not touch any file system, so
+ * whatever time is measured is spent by EtherDFS itself. It speaks only the
+ * basic protocol (GETCAPS is answered with an error, as an older server
+ * would do).
+ *
+ * The remote drive holds MOCK_FILES files named FILE0000.DAT and so on, each
+ * of them mock_fsize bytes long. The byte at offset x of any file is
+ * MOCK_BYTE(x), and data written is accepted and forgotten.
+ */
+
+#include <string.h>
+#include "host.h"
+#include "mockpeer.h"
+
+unsigned long mock_fsize = 1048576lu;
+unsigned long mock_delay;
+void (*mock_send)(const unsigned char *frame, unsigned short len, unsigned long delay) = host_post;
+
+
+/* sets the headers of answer to these of query (seq included), from the
+ * server to the client, with AX = ax */
+static void mock_hdr(unsigned char *answer, const unsigned char *query, unsigned short ax) {
+  memcpy(answer, query + 6, 6);
+  memcpy(answer + 6, query, 6);
+  memcpy(answer + 12, query + 12, 48);
+  answer[58] = ax & 0xff;
+  answer[59] = ax >> 8;
+}
+
+
+/* puts the 16-bit value v at p (the protocol is little-endian) */
+static void mock_put16(unsigned char *p, unsigned short v) {
+  p[0] = v & 0xff;
+  p[1] = v >> 8;
+}
+
+
+static void mock_put32(unsigned char *p, unsigned long v) {
+  mock_put16(p, v & 0xffff);
+  mock_put16(p + 2, v >> 16);
+}
+
+
+static unsigned long mock_get32(const unsigned char *p) {
+  return(p[0] | (p[1] << 8) | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24));
+}
+
+
+/* writes the directory entry of file n (in the format of a FINDFIRST answer,
+ * 24 bytes) at p */
+static void mock_dirent(unsigned char *p, unsigned short n) {
+  p[0] = 0x20; /* archive */
+  memcpy(p + 1, "FILE0000DAT", 11);
+  p[5] = '0' + ((n / 1000) % 10);
+  p[6] = '0' + ((n / 100) % 10);
+  p[7] = '0' + ((n / 10) % 10);
+  p[8] = '0' + (n % 10);
+  mock_put32(p + 12, 0x4a210000lu); /* 2017-01-01 00:00 */
+  mock_put32(p + 16, mock_fsize);
+  mock_put16(p + 20, 1);            /* parent cluster */
+  mock_put16(p + 22, n);            /* entry number */
+}
+
+
+void mock_peer(const unsigned char *frame, unsigned short len) {
+  static unsigned char answer[9216];
+  unsigned short alen, ax = 0, i;
+  unsigned long offs;
+  const unsigned char *q = frame + 60;
+  unsigned short qlen = len - 60;
+  if (len < 60) return;
+  alen = 60;
+  switch (frame[59]) {
+    case 0x08: /* READFIL: OOOOSSLL */
+      if (qlen < 8) {
+        ax = 5;
+        break;
+      }
+      offs = mock_get32(q);
+      i = q[6] | (q[7] << 8);
+      if (offs >= mock_fsize) i = 0;
+      if (offs + i > mock_fsize) i = mock_fsize - offs;
+      if (i > sizeof(answer) - 60) i = sizeof(answer) - 60;
+      for (; i != 0; i--, offs++) answer[alen++] = MOCK_BYTE(offs);
+      break;
+    case 0x09: /* WRITEFIL: OOOOSSddd... */
+      mock_put16(answer + 60, (qlen >= 6)?(qlen - 6):0);
+      alen += 2;
+      break;
+    case 0x0C: /* DISKSPACE: AX = sectors per cluster, BBCCDD */
+      ax = 64;
+      mock_put16(answer + 60, 32768u); /* total clusters */
+      mock_put16(answer + 62, 512);    /* bytes per sector */
+      mock_put16(answer + 64, 16384);  /* available clusters */
+      alen += 6;
+      break;
+    case 0x0F: /* GETATTR: TTDDSSSSA */
+      mock_put32(answer + 60, 0x4a210000lu);
+      mock_put32(answer + 64, mock_fsize);
+      answer[68] = 0x20;
+      alen += 9;
+      break;
+    case 0x16: /* OPEN */
+    case 0x17: /* CREATE */
+    case 0x2E: /* SPOPNFIL */
+      mock_dirent(answer + 60, 0);
+      mock_put16(answer + 80, 0x1234); /* start sector (file id) */
+      mock_put16(answer + 82, 1);      /* SPOP result: file opened */
+      if (qlen < 6) {
+        ax = 2;
+        break;
+      }
+      /* open mode is in the stack word of OPEN, and in the SPOP mode of
+       * SPOPNFIL. a created file is always open read-write, and empty */
+      answer[84] = ((frame[59] == 0x16)?q[0]:q[4]) & 0x7f;
+      if (frame[59] == 0x17) {
+        answer[84] = 2;
+        mock_put32(answer + 76, 0);
+      }
+      alen += 25;
+      break;
+    case 0x1B: /* FINDFIRST */
+      mock_dirent(answer + 60, 0);
+      alen += 24;
+      break;
+    case 0x1C: /* FINDNEXT: CCEEAttttttttttt (parent cluster, entry...) */
+      i = (qlen >= 4)?(q[2] | (q[3] << 8)):MOCK_FILES;
+      if (i + 1 >= MOCK_FILES) {
+        ax = 18; /* "no more files" */
+        break;
+      }
+      mock_dirent(answer + 60, i + 1);
+      alen += 24;
+      break;
+    case 0x21: /* SKFMEND: DDCCSS -> new position */
+      mock_put32(answer + 60, mock_fsize + mock_get32(q)); /* offset is signed */
+      alen += 4;
+      break;
+    case 0x01: /* RMDIR */
+    case 0x03: /* MKDIR */
+    case 0x05: /* CHDIR */
+    case 0x06: /* CLSFIL */
+    case 0x0E: /* SETATTR */
+    case 0x11: /* RENAME */
+    case 0x13: /* DELETE */
+      break;
+    default: /* anything else is an extension I do not know about */
+      ax = 1;
+      break;
+  }
+  mock_hdr(answer, frame, ax);
+  mock_send(answer, alen, mock_delay);
+}
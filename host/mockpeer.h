@@ -0,0 +1,28 @@
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * A mock EDF5 server for the host build (see mockpeer.c).
+ */
+
+#ifndef MOCKPEER_SENTINEL
+#define MOCKPEER_SENTINEL
+
+/* amount of files in the root directory of the mock drive */
+#define MOCK_FILES 100
+
+/* the content of all mock files, at offset x */
+#define MOCK_BYTE(x) ((unsigned char)(((x) * 7) ^ ((x) >> 8)))
+
+extern unsigned long mock_fsize; /* size of all mock files */
+extern unsigned long mock_delay; /* delay of all answers, in pit_now() units */
+
+/* answers are sent through this, host_post() by default */
+extern void (*mock_send)(const unsigned char *frame, unsigned short len, unsigned long delay);
+
+/* the mock server (to be set as host_peer) */
+void mock_peer(const unsigned char *frame, unsigned short len);
+
+#endif
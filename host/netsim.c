@@ -0,0 +1,223 @@
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * A simulated network link for the host build (see netsim.h).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "netsim.h"
+
+/* length of a BIOS tick, in microseconds */
+#define TICKUS 54925lu
+
+/* biggest frame the link carries */
+#define FRAMEMAX 9216
+
+/* how long a burst of losses may last, in pit_now() units (one BIOS tick) */
+#define BURSTSPAN 1024
+
+/* frames of the current call remembered for spotting retransmissions */
+#define SEENMAX 4096
+
+struct netsim_stats netsim_stats;
+
+static struct netsim_cfg sim;
+static host_peerfn sim_server;
+static unsigned long long sim_rng;
+static unsigned char sim_lost[2];  /* last frame of each direction was lost */
+static unsigned long sim_lostat[2];  /* when it was lost */
+static unsigned long sim_lastdue[2];  /* when the last frame of each direction arrives */
+static unsigned long sim_seen[SEENMAX];
+static unsigned long sim_seencount;
+static unsigned long sim_frames;
+static unsigned long sim_rexmit;
+
+static const struct {
+  const char *name;
+  const char *spec;
+  const char *desc;
+} profiles[] = {
+  {"clean",   "", "a perfect link, no delay"},
+  {"lan",     "delay=100,jitter=50", "a quiet LAN"},
+  {"lossy",   "lan,drop=2", "a LAN that loses 2% of frames"},
+  {"bursty",  "lan,drop=1,burst=50", "a LAN that loses frames in bursts"},
+  {"dup",     "lan,dup=5", "a LAN that duplicates 5% of frames"},
+  {"reorder", "lan,reorder=10,hold=500", "a LAN that holds back 10% of frames"},
+  {"corrupt", "lan,corrupt=1", "a LAN that damages 1% of frames"},
+  {"wan",     "delay=10000,jitter=2000,drop=0.5", "a remote link"},
+  {"hostile", "delay=300,jitter=300,drop=3,burst=30,dup=3,reorder=5,hold=1000,corrupt=1", "all of the above at once"},
+  {NULL, NULL, NULL}
+};
+
+
+/* returns a pseudo-random number in [0;1) (xorshift64*) */
+static double rnd(void) {
+  sim_rng ^= sim_rng >> 12;
+  sim_rng ^= sim_rng << 25;
+  sim_rng ^= sim_rng >> 27;
+  return((double)((sim_rng * 2685821657736338717llu) >> 11) / 9007199254740992.0);
+}
+
+
+/* applies the settings of spec to cfg, returns 0 on success */
+static int apply(struct netsim_cfg *cfg, const char *spec) {
+  char tok[64], *eq, *end;
+  double v;
+  size_t n;
+  int i;
+  while (*spec != 0) {
+    n = strcspn(spec, ",");
+    if (n >= sizeof(tok)) return(-1);
+    memcpy(tok, spec, n);
+    tok[n] = 0;
+    spec += n;
+    if (*spec == ',') spec++;
+    if (n == 0) continue;
+    eq = strchr(tok, '=');
+    if (eq == NULL) { /* name of a profile */
+      for (i = 0; (profiles[i].name != NULL) && (strcmp(profiles[i].name, tok) != 0); i++);
+      if ((profiles[i].name == NULL) || (apply(cfg, profiles[i].spec) != 0)) return(-1);
+      continue;
+    }
+    *eq = 0;
+    v = strtod(eq + 1, &end);
+    if ((*end != 0) || (end == eq + 1) || (v < 0)) return(-1);
+    if (strcmp(tok, "seed") == 0) {
+      cfg->seed = v;
+    } else if ((strcmp(tok, "delay") == 0) || (strcmp(tok, "jitter") == 0) || (strcmp(tok, "hold") == 0)) {
+      unsigned long t = (v * 1024 + TICKUS / 2) / TICKUS;
+      if (tok[0] == 'd') cfg->delay = t;
+      if (tok[0] == 'j') cfg->jitter = t;
+      if (tok[0] == 'h') cfg->hold = t;
+    } else {
+      if (v > 100) return(-1);
+      v /= 100;
+      if (strcmp(tok, "drop") == 0) {
+        cfg->drop = v;
+      } else if (strcmp(tok, "burst") == 0) {
+        cfg->burst = v;
+      } else if (strcmp(tok, "dup") == 0) {
+        cfg->dup = v;
+      } else if (strcmp(tok, "reorder") == 0) {
+        cfg->reorder = v;
+      } else if (strcmp(tok, "corrupt") == 0) {
+        cfg->corrupt = v;
+      } else {
+        return(-1);
+      }
+    }
+  }
+  return(0);
+}
+
+
+int netsim_profile(struct netsim_cfg *cfg, const char *spec) {
+  unsigned long seed = cfg->seed;
+  memset(cfg, 0, sizeof(*cfg));
+  cfg->seed = seed;
+  return(apply(cfg, spec));
+}
+
+
+void netsim_listprofiles(void) {
+  int i;
+  for (i = 0; profiles[i].name != NULL; i++) printf("  %-8s %s\n", profiles[i].name, profiles[i].desc);
+}
+
+
+void netsim_init(const struct netsim_cfg *cfg, host_peerfn server) {
+  memcpy(&sim, cfg, sizeof(sim));
+  sim_server = server;
+  sim_rng = (cfg->seed ^ 0x9E3779B97F4A7C15llu) | 1;
+  memset(sim_lost, 0, sizeof(sim_lost));
+  memset(sim_lostat, 0, sizeof(sim_lostat));
+  memset(sim_lastdue, 0, sizeof(sim_lastdue));
+  memset(&netsim_stats, 0, sizeof(netsim_stats));
+  sim_seencount = 0;
+  sim_frames = 0;
+  sim_rexmit = 0;
+}
+
+
+/* puts frame on the link in direction dir (0 = to the server, 1 = to
+ * EtherDFS), delay pit_now() units from now. frames arrive in the order
+ * they have been sent, unless reordered on purpose. A damaged frame fails
+ * the FCS check of the receiving NIC, so it is never delivered */
+static void transmit(int dir, const unsigned char *frame, unsigned short len, unsigned long delay) {
+  unsigned long d;
+  int copies = 1;
+  if (len > FRAMEMAX) return;
+  netsim_stats.frames[dir]++;
+  /* a burst goes on only as long as frames follow each other closely */
+  if ((sim_lost[dir] != 0) && (host_clock - sim_lostat[dir] >= BURSTSPAN)) sim_lost[dir] = 0;
+  if (rnd() < ((sim_lost[dir] != 0)?sim.burst:sim.drop)) {
+    netsim_stats.dropped[dir]++;
+    sim_lost[dir] = 1;
+    sim_lostat[dir] = host_clock;
+    return;
+  }
+  sim_lost[dir] = 0;
+  if (rnd() < sim.dup) {
+    netsim_stats.duplicated[dir]++;
+    copies = 2;
+  }
+  for (; copies != 0; copies--) {
+    d = delay + sim.delay;
+    if (sim.jitter != 0) d += (unsigned long)(rnd() * (sim.jitter + 1));
+    if (rnd() < sim.reorder) {
+      netsim_stats.reordered[dir]++;
+      d += sim.hold;
+    } else {
+      /* jitter alone does not let a frame overtake the one before it */
+      if ((long)(sim_lastdue[dir] - (host_clock + d)) > 0) d = sim_lastdue[dir] - host_clock;
+      sim_lastdue[dir] = host_clock + d;
+    }
+    if (rnd() < sim.corrupt) {
+      netsim_stats.corrupted[dir]++;
+      continue;
+    }
+    if (dir == 0) {
+      host_postto(sim_server, frame, len, d);
+    } else {
+      host_post(frame, len, d);
+    }
+  }
+}
+
+
+void netsim_fromclient(const unsigned char *frame, unsigned short len) {
+  unsigned long h = 2166136261lu, i;
+  /* a frame that is the same as one sent before during this call (but for
+   * its sequence) is a retransmission */
+  for (i = 0; i < len; i++) {
+    if (i != 57) h = ((h ^ frame[i]) * 16777619lu) & 0xffffffffu;
+  }
+  for (i = 0; (i < sim_seencount) && (sim_seen[i] != h); i++);
+  if (i < sim_seencount) {
+    sim_rexmit++;
+  } else if (sim_seencount < SEENMAX) {
+    sim_seen[sim_seencount++] = h;
+  }
+  sim_frames++;
+  transmit(0, frame, len, 0);
+}
+
+
+void netsim_fromserver(const unsigned char *frame, unsigned short len, unsigned long delay) {
+  transmit(1, frame, len, delay);
+}
+
+
+unsigned long netsim_take(unsigned long *rexmit) {
+  unsigned long frames = sim_frames;
+  *rexmit = sim_rexmit;
+  sim_frames = 0;
+  sim_rexmit = 0;
+  sim_seencount = 0;
+  return(frames);
+}
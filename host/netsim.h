@@ -0,0 +1,68 @@
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * A simulated network link for the host build, to be put between EtherDFS
+ * and its server: frames going either way may be dropped, duplicated,
+ * delayed, reordered or corrupted, as a profile says. All of it is driven by
+ * a seeded pseudo-random generator and by the simulated clock of host.h, so
+ * a given seed and profile always lead to the same run.
+ */
+
+#ifndef NETSIM_SENTINEL
+#define NETSIM_SENTINEL
+
+#include "host.h"
+
+/* what the link does to frames (chances are between 0 and 1, times are in
+ * pit_now() units and apply to each direction) */
+struct netsim_cfg {
+  unsigned long seed;
+  double drop;           /* chance of a frame being lost */
+  double burst;          /* same, for a frame that follows a lost one closely */
+  double dup;            /* chance of a frame arriving twice */
+  double reorder;        /* chance of a frame being held back by 'hold' */
+  double corrupt;        /* chance of a frame getting damaged (and dropped by the NIC) */
+  unsigned long delay;   /* time every frame spends on the wire */
+  unsigned long jitter;  /* random extra time, up to that much */
+  unsigned long hold;    /* extra time of reordered frames */
+};
+
+/* counters of the link, for each direction (0 = to the server, 1 = back) */
+struct netsim_stats {
+  unsigned long frames[2];
+  unsigned long dropped[2];
+  unsigned long duplicated[2];
+  unsigned long reordered[2];
+  unsigned long corrupted[2];
+};
+
+extern struct netsim_stats netsim_stats;
+
+/* sets cfg according to spec, which is the name of a profile, a list of
+ * key=value settings, or both ("lossy,dup=1"). Keys are the fields of
+ * struct netsim_cfg, chances are given in percent and times in
+ * microseconds. returns 0 on success, -1 if spec makes no sense */
+int netsim_profile(struct netsim_cfg *cfg, const char *spec);
+
+/* prints the list of profiles known to netsim_profile() */
+void netsim_listprofiles(void);
+
+/* sets the link up, forgetting about any previous state. frames sent by
+ * EtherDFS end up (if they make it) at server */
+void netsim_init(const struct netsim_cfg *cfg, host_peerfn server);
+
+/* EtherDFS sends frames here (this is meant to be the host_peer) */
+void netsim_fromclient(const unsigned char *frame, unsigned short len);
+
+/* the server sends its answers here instead of to host_post() */
+void netsim_fromserver(const unsigned char *frame, unsigned short len, unsigned long delay);
+
+/* returns the amount of frames EtherDFS sent since the last call, and sets
+ * *rexmit to how many of them repeated a frame sent before (sequence
+ * aside), ie. were retransmissions */
+unsigned long netsim_take(unsigned long *rexmit);
+
+#endif
@@ -0,0 +1,1086 @@
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * A reference EDF5 server, serving a local directory (see refsrv.h).
+ *
+ * Files and directories are identified on the wire by 16-bit values (the
+ * "start sector" of files, the "cluster" of directories). The server hands
+ * them out as indexes of a hash table of local paths, so that an identifier
+ * remains valid for as long as the server runs. Local names are looked up
+ * without regard to case, and only these that fit in the 8.3 format are
+ * visible to the client. Files are opened for the duration of a single query
+ * only, hence the server keeps no state about open files (but WRITESTREAM
+ * windows).
+ */
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <time.h>
+#include <unistd.h>
+#include <utime.h>
+#include "../version.h"
+#include "refsrv.h"
+
+#define IDSLOTS 4096  /* file and directory identifiers (0 is never used) */
+#define CLIENTS 8     /* clients whose last answer is kept for retransmissions */
+#define STREAMS 8     /* WRITESTREAM windows tracked at the same time */
+#define DATAMAX 65536 /* biggest amount of data handled by a single query */
+
+/* flags in the drive byte of queries */
+#define DFLAG_ZDATA   0x80
+#define DFLAG_ZANSWER 0x40
+
+/* a directory entry, as listed by listdir() */
+struct srv_ent {
+  char fcb[11];
+  char name[256];
+};
+
+static struct refsrv_cfg srv;
+static unsigned long srv_busy;  /* time the server is done with queries it has got so far */
+static char *srv_ids[IDSLOTS];  /* local path of each identifier */
+static unsigned char srv_ans[REFSRV_FRAMEMAX];
+static unsigned char srv_data[DATAMAX];
+
+/* the last answer sent to each client, sent again as-is if the client repeats
+ * its query (so a retransmitted RENAME, DELETE, etc does not fail) */
+static struct {
+  unsigned char mac[6];
+  unsigned char seq;
+  unsigned char al;
+  unsigned short len;  /* 0 = no answer kept */
+  unsigned char frame[REFSRV_FRAMEMAX];
+} srv_last[CLIENTS];
+static unsigned char srv_lastnext;
+
+/* WRITESTREAM windows: frames written so far and where they went */
+static struct {
+  unsigned short fileid;  /* 0 = slot unused */
+  unsigned char winid;
+  unsigned short mask;
+  unsigned short err;
+  unsigned long offs[16];
+  unsigned short len[16];
+} srv_streams[STREAMS];
+static unsigned char srv_streamnext;
+
+/* listing of the last directory searched through */
+static struct {
+  unsigned short id;  /* 0 = no listing */
+  int count;
+  int size;
+  struct srv_ent *e;
+} srv_list;
+
+
+static unsigned short get16(const unsigned char *p) {
+  return(p[0] | (p[1] << 8));
+}
+
+
+static unsigned long get32(const unsigned char *p) {
+  return(get16(p) | ((unsigned long)get16(p + 2) << 16));
+}
+
+
+static void put16(unsigned char *p, unsigned short v) {
+  p[0] = v & 0xff;
+  p[1] = v >> 8;
+}
+
+
+static void put32(unsigned char *p, unsigned long v) {
+  put16(p, v & 0xffff);
+  put16(p + 2, v >> 16);
+}
+
+
+/* translates errno into a DOS error code */
+static unsigned short doserr(int e) {
+  switch (e) {
+    case ENOENT: return(2);
+    case ENOTDIR: return(3);
+    case EEXIST: return(80);
+    case ENOSPC: return(39);
+    default: return(5);
+  }
+}
+
+
+/* returns the identifier of path, 0 if the table is full */
+static unsigned short pathid(const char *path) {
+  unsigned long h = 5381;
+  unsigned short i, n;
+  const char *p;
+  for (p = path; *p != 0; p++) h = (h * 33) ^ (unsigned char)*p;
+  i = h % IDSLOTS;
+  for (n = 0; n < IDSLOTS; n++, i = (i + 1) % IDSLOTS) {
+    if (i == 0) continue;
+    if (srv_ids[i] == NULL) {
+      srv_ids[i] = strdup(path);
+      return((srv_ids[i] == NULL)?0:i);
+    }
+    if (strcmp(srv_ids[i], path) == 0) return(i);
+  }
+  return(0);
+}
+
+
+/* returns the local path of identifier id, NULL if id is unknown */
+static const char *idpath(unsigned short id) {
+  if (id >= IDSLOTS) return(NULL);
+  return(srv_ids[id]);
+}
+
+
+/* opens the file identified by id, returns a descriptor or -1 (errno set) */
+static int openid(unsigned short id, int flags) {
+  const char *path = idpath(id);
+  if (path == NULL) {
+    errno = ENOENT;
+    return(-1);
+  }
+  return(open(path, flags));
+}
+
+
+/* returns the DOS attributes of a file */
+static unsigned char dosattr(const struct stat *st) {
+  unsigned char attr = S_ISDIR(st->st_mode)?0x10:0x20;
+  if ((st->st_mode & S_IWUSR) == 0) attr |= 0x01; /* read-only */
+  return(attr);
+}
+
+
+/* returns the DOS time (low word) and date (high word) of t */
+static unsigned long dostime(time_t t) {
+  struct tm *tm = localtime(&t);
+  if ((tm == NULL) || (tm->tm_year < 80)) return(0x00210000lu); /* 1980-01-01 */
+  if (tm->tm_year > 207) return(0xff9fbf7dlu); /* 2107-12-31 23:59:58 */
+  return((tm->tm_hour << 11) | (tm->tm_min << 5) | (tm->tm_sec / 2)
+         | ((unsigned long)(((tm->tm_year - 80) << 9) | ((tm->tm_mon + 1) << 5) | tm->tm_mday) << 16));
+}
+
+
+/* tells whether c may be part of a DOS file name */
+static int fcbchar(char c) {
+  if ((c <= 0x20) || (c >= 0x7f)) return(0);
+  return(strchr("\"*+,./:;<=>?[\\]|", c) == NULL);
+}
+
+
+/* converts the file name name into FCB format ("FILE    TXT") at fcb.
+ * returns 0, or -1 if name does not fit in the 8.3 format */
+static int tofcb(char *fcb, const char *name) {
+  int i, j;
+  memset(fcb, ' ', 11);
+  if ((strcmp(name, ".") == 0) || (strcmp(name, "..") == 0)) {
+    memcpy(fcb, name, strlen(name));
+    return(0);
+  }
+  for (i = 0; (name[i] != 0) && (name[i] != '.'); i++) {
+    if ((i == 8) || (!fcbchar(name[i]))) return(-1);
+    fcb[i] = toupper((unsigned char)name[i]);
+  }
+  if (i == 0) return(-1);
+  if (name[i] == 0) return(0);
+  name += i + 1;
+  for (j = 0; name[j] != 0; j++) {
+    if ((j == 3) || (!fcbchar(name[j]))) return(-1);
+    fcb[8 + j] = toupper((unsigned char)name[j]);
+  }
+  return((j == 0)?-1:0);
+}
+
+
+/* converts the DOS file mask of len bytes at mask ("FILE*.T?T") into an
+ * 11-bytes search template at tmpl ("FILE????T?T") */
+static void totmpl(char *tmpl, const unsigned char *mask, unsigned short len) {
+  unsigned short i = 0, j = 0;
+  memset(tmpl, ' ', 11);
+  for (; (i < len) && (mask[i] != '.'); i++) {
+    if (mask[i] == '*') {
+      while (j < 8) tmpl[j++] = '?';
+    } else if (j < 8) {
+      tmpl[j++] = toupper(mask[i]);
+    }
+  }
+  for (i++, j = 8; i < len; i++) {
+    if (mask[i] == '*') {
+      while (j < 11) tmpl[j++] = '?';
+    } else if (j < 11) {
+      tmpl[j++] = toupper(mask[i]);
+    }
+  }
+}
+
+
+static int tmplmatch(const char *tmpl, const char *fcb) {
+  int i;
+  for (i = 0; i < 11; i++) {
+    if ((tmpl[i] != '?') && (tmpl[i] != fcb[i])) return(0);
+  }
+  return(1);
+}
+
+
+/* copies the last component of the DOS path of len bytes at dos into name
+ * (13 bytes). returns -1 if it is too long to be a DOS file name */
+static int lastcomp(char *name, const unsigned char *dos, unsigned short len) {
+  unsigned short i = len;
+  while ((i > 0) && (dos[i - 1] != '\\')) i--;
+  if (len - i > 12) return(-1);
+  memcpy(name, dos + i, len - i);
+  name[len - i] = 0;
+  return(0);
+}
+
+
+/* tells whether the last component of the DOS path of len bytes at dos is
+ * a valid DOS file name */
+static int validname(const unsigned char *dos, unsigned short len) {
+  char name[13], fcb[11];
+  if (lastcomp(name, dos, len) != 0) return(0);
+  return(tofcb(fcb, name) == 0);
+}
+
+
+/* out ends with a lower-case file name, appended after its first olen bytes.
+ * if no such file exists, looks for one with the same name in another case
+ * and fixes out accordingly. returns 0 if the file exists, -1 otherwise */
+static int lookup(char *out, size_t olen) {
+  struct stat st;
+  struct dirent *de;
+  DIR *d;
+  int res = -1;
+  if (stat(out, &st) == 0) return(0);
+  out[olen] = 0;
+  d = opendir(out);
+  out[olen] = '/';
+  if (d == NULL) return(-1);
+  while ((de = readdir(d)) != NULL) {
+    if (strcasecmp(de->d_name, out + olen + 1) != 0) continue;
+    strcpy(out + olen + 1, de->d_name);
+    res = 0;
+    break;
+  }
+  closedir(d);
+  return(res);
+}
+
+
+/* translates the DOS path of len bytes at dos ("\DIR\FILE.TXT") into a
+ * local path at out (PATH_MAX bytes). returns 0 if the path exists, 2 if
+ * all of it but its last component exists (out ends with this component in
+ * lower case then), 3 otherwise */
+static int resolve(char *out, const unsigned char *dos, unsigned short len) {
+  struct stat st;
+  unsigned short pos = 0;
+  size_t olen;
+  int clen;
+  strcpy(out, srv.root);
+  for (;;) {
+    while ((pos < len) && (dos[pos] == '\\')) pos++;
+    if (pos == len) return(0);
+    olen = strlen(out);
+    if (olen + 14 >= PATH_MAX) return(3);
+    out[olen] = '/';
+    for (clen = 0; (pos < len) && (dos[pos] != '\\'); pos++) {
+      if ((clen == 12) || (dos[pos] == '/') || (dos[pos] == 0)) return(3);
+      out[olen + 1 + clen++] = tolower(dos[pos]);
+    }
+    out[olen + 1 + clen] = 0;
+    /* never let the client out of the root directory */
+    if ((strcmp(out + olen + 1, ".") == 0) || (strcmp(out + olen + 1, "..") == 0)) return(3);
+    while ((pos < len) && (dos[pos] == '\\')) pos++;
+    if (lookup(out, olen) != 0) return((pos == len)?2:3);
+    if ((pos < len) && ((stat(out, &st) != 0) || (!S_ISDIR(st.st_mode)))) return(3);
+  }
+}
+
+
+static int cmpent(const void *a, const void *b) {
+  return(memcmp(((const struct srv_ent *)a)->fcb, ((const struct srv_ent *)b)->fcb, 11));
+}
+
+
+/* adds an entry to srv_list, returns it or NULL if out of memory */
+static struct srv_ent *newent(void) {
+  if (srv_list.count == srv_list.size) {
+    struct srv_ent *e = realloc(srv_list.e, (srv_list.size + 256) * sizeof(struct srv_ent));
+    if (e == NULL) return(NULL);
+    srv_list.e = e;
+    srv_list.size += 256;
+  }
+  return(&srv_list.e[srv_list.count++]);
+}
+
+
+/* loads the listing of directory id into srv_list, unless it is there
+ * already: "." and ".." first (but in the root directory), then all the
+ * entries in the order of their FCB names. returns 0, or -1 if the directory
+ * cannot be read */
+static int listdir(unsigned short id) {
+  const char *path = idpath(id);
+  struct dirent *de;
+  struct srv_ent *e;
+  DIR *d;
+  int first = 0;
+  if ((id != 0) && (srv_list.id == id)) return(0);
+  srv_list.id = 0;
+  srv_list.count = 0;
+  if (path == NULL) return(-1);
+  d = opendir(path);
+  if (d == NULL) return(-1);
+  if (strcmp(path, srv.root) != 0) {
+    for (first = 0; first < 2; first++) {
+      e = newent();
+      if (e == NULL) break;
+      strcpy(e->name, (first == 0)?".":"..");
+      tofcb(e->fcb, e->name);
+    }
+  }
+  while ((de = readdir(d)) != NULL) {
+    if ((strcmp(de->d_name, ".") == 0) || (strcmp(de->d_name, "..") == 0)) continue;
+    e = newent();
+    if (e == NULL) break;
+    if ((strlen(de->d_name) >= sizeof(e->name)) || (tofcb(e->fcb, de->d_name) != 0)) {
+      srv_list.count--;
+      continue;
+    }
+    strcpy(e->name, de->d_name);
+  }
+  closedir(d);
+  qsort(srv_list.e + first, srv_list.count - first, sizeof(struct srv_ent), cmpent);
+  srv_list.id = id;
+  return(0);
+}
+
+
+/* finds the first entry of directory id after position pos (-1 to start from
+ * the beginning) that matches tmpl and attr, and writes it at out (in the
+ * format of a FINDFIRST answer, 24 bytes). returns its position, -1 if none */
+static int findfrom(unsigned short id, int pos, const char *tmpl, unsigned char attr, unsigned char *out) {
+  char path[PATH_MAX];
+  struct stat st;
+  unsigned char fattr;
+  if (attr == 0x08) return(-1); /* no volume label here */
+  if (listdir(id) != 0) return(-1);
+  for (pos++; pos < srv_list.count; pos++) {
+    if (!tmplmatch(tmpl, srv_list.e[pos].fcb)) continue;
+    if (strlen(idpath(id)) + strlen(srv_list.e[pos].name) + 2 > sizeof(path)) continue;
+    strcpy(path, idpath(id));
+    strcat(path, "/");
+    strcat(path, srv_list.e[pos].name);
+    if (stat(path, &st) != 0) continue;
+    fattr = dosattr(&st);
+    /* directories (and hidden or system files) only when asked for */
+    if ((fattr & 0x16 & ~attr) != 0) continue;
+    out[0] = fattr;
+    memcpy(out + 1, srv_list.e[pos].fcb, 11);
+    put32(out + 12, dostime(st.st_mtime));
+    put32(out + 16, S_ISDIR(st.st_mode)?0:st.st_size);
+    put16(out + 20, id);
+    put16(out + 22, pos);
+    return(pos);
+  }
+  return(-1);
+}
+
+
+/* answers a FINDFIRST (next == 0) or FINDNEXT query of qlen bytes at q
+ * with up to max entries written at out. returns the amount of entries, or
+ * 0 with *ax set to the DOS error code */
+static int search(const unsigned char *q, unsigned short qlen, int next, unsigned char *out, int max, unsigned short *ax) {
+  char path[PATH_MAX], tmpl[11];
+  struct stat st;
+  unsigned short id, dirlen;
+  unsigned char attr;
+  int pos = -1, count;
+  if (next == 0) { /* Affff... */
+    if (qlen < 1) {
+      *ax = 3;
+      return(0);
+    }
+    attr = q[0];
+    for (dirlen = qlen - 1; (dirlen > 0) && (q[dirlen] != '\\'); dirlen--);
+    totmpl(tmpl, q + 1 + dirlen, qlen - 1 - dirlen);
+    if ((resolve(path, q + 1, dirlen) != 0) || (stat(path, &st) != 0) || (!S_ISDIR(st.st_mode))) {
+      *ax = 3;
+      return(0);
+    }
+    id = pathid(path);
+    if (id == 0) {
+      *ax = 4; /* "too many open files" */
+      return(0);
+    }
+  } else { /* CCppAttttttttttt */
+    if (qlen < 16) {
+      *ax = 18;
+      return(0);
+    }
+    id = get16(q);
+    pos = get16(q + 2);
+    attr = q[4];
+    memcpy(tmpl, q + 5, 11);
+  }
+  for (count = 0; count < max; count++) {
+    pos = findfrom(id, pos, tmpl, attr, out + (count * 24));
+    if (pos < 0) break;
+  }
+  /* a FINDFIRST without wildcards is looking for a file that is not there */
+  if (count == 0) *ax = ((next == 0) && (memchr(tmpl, '?', 11) == NULL))?2:18;
+  return(count);
+}
+
+
+/* decompresses the srclen bytes of LZ data at src into dst (see protocol.txt
+ * for the format). returns the length of decompressed data, or -1 if src is
+ * malformed or would not fit in dstlen bytes */
+static long lzunpack(unsigned char *dst, const unsigned char *src, unsigned short srclen, unsigned long dstlen) {
+  const unsigned char *end = src + srclen;
+  unsigned long out = 0, n, back;
+  while (src != end) {
+    if (*src < 0x80) {
+      n = *src + 1;
+      src++;
+      if ((n > (unsigned long)(end - src)) || (n > dstlen - out)) return(-1);
+      memcpy(dst + out, src, n);
+      src += n;
+      out += n;
+    } else {
+      if (end - src < 3) return(-1);
+      n = (*src & 0x7F) + 3;
+      back = get16(src + 1);
+      src += 3;
+      if ((back == 0) || (back > out) || (n > dstlen - out)) return(-1);
+      for (; n != 0; n--, out++) dst[out] = dst[out - back];
+    }
+  }
+  return(out);
+}
+
+
+/* compresses len bytes from src into dst (see protocol.txt for the format).
+ * returns the length of compressed data, or 0 if it would not be shorter than
+ * len. This is the same greedy scheme EtherDFS uses, only with a bigger hash
+ * table */
+static unsigned short lzpack(unsigned char *dst, const unsigned char *src, unsigned short len) {
+  static unsigned short hash[4096];
+  unsigned short pos = 0, out = 0, lit = 0, mlen, cand, h;
+  memset(hash, 0xff, sizeof(hash));
+  for (;;) {
+    mlen = 0;
+    if (len - pos >= 3) {
+      h = ((src[pos] << 4) ^ (src[pos + 1] << 2) ^ src[pos + 2] ^ (src[pos + 2] << 8)) & 4095;
+      cand = hash[h];
+      hash[h] = pos;
+      if (cand < pos) {
+        while ((pos + mlen < len) && (mlen < 130) && (src[cand + mlen] == src[pos + mlen])) mlen++;
+      }
+    }
+    if ((lit != 0) && ((mlen >= 3) || (pos == len) || (lit == 128))) {
+      if (out + lit + 1 >= len) return(0);
+      dst[out++] = lit - 1;
+      memcpy(dst + out, src + pos - lit, lit);
+      out += lit;
+      lit = 0;
+    }
+    if (pos == len) break;
+    if (mlen < 3) {
+      lit++;
+      pos++;
+      continue;
+    }
+    if (out + 3 >= len) return(0);
+    dst[out++] = 0x80 | (mlen - 3);
+    put16(dst + out, pos - cand);
+    out += 2;
+    pos += mlen;
+  }
+  return(out);
+}
+
+
+/* returns the data carried by a WRITEFIL or WRITESTREAM query (len bytes at
+ * data), decompressed into srv_data if need be. returns its length, or -1
+ * if it does not decompress */
+static long querydata(const unsigned char **data, unsigned short len, unsigned char dflags) {
+  long l;
+  if ((dflags & DFLAG_ZDATA) == 0) return(len);
+  l = lzunpack(srv_data, *data, len, sizeof(srv_data));
+  *data = srv_data;
+  return(l);
+}
+
+
+/* writes len bytes of data at offset offs of file id. returns the amount of
+ * bytes written, or -1 with *ax set to the DOS error code. writing 0 bytes
+ * truncates the file at offs, as DOS does */
+static long writeid(unsigned short id, unsigned long offs, const unsigned char *data, unsigned long len, unsigned short *ax) {
+  unsigned long done = 0;
+  ssize_t l;
+  int fd = openid(id, O_WRONLY);
+  if (fd < 0) {
+    *ax = doserr(errno);
+    return(-1);
+  }
+  if (len == 0) {
+    if (ftruncate(fd, offs) != 0) *ax = doserr(errno);
+  }
+  while (done < len) {
+    l = pwrite(fd, data + done, len - done, offs + done);
+    if (l <= 0) {
+      if (done == 0) *ax = doserr(errno);
+      break;
+    }
+    done += l;
+  }
+  close(fd);
+  return(((done == 0) && (*ax != 0))?-1:(long)done);
+}
+
+
+/* reads up to len bytes at offset offs of file id into dst. returns the
+ * amount of bytes read, or -1 with *ax set to the DOS error code */
+static long readid(unsigned short id, unsigned long offs, unsigned char *dst, unsigned long len, unsigned short *ax) {
+  unsigned long done = 0;
+  ssize_t l;
+  int fd = openid(id, O_RDONLY);
+  if (fd < 0) {
+    *ax = doserr(errno);
+    return(-1);
+  }
+  while (done < len) {
+    l = pread(fd, dst + done, len - done, offs + done);
+    if (l < 0) {
+      *ax = 30; /* "read fault" */
+      done = 0;
+      break;
+    }
+    if (l == 0) break;
+    done += l;
+  }
+  close(fd);
+  return((*ax != 0)?-1:(long)done);
+}
+
+
+/* OPEN, CREATE and SPOPNFIL: SSCCMMfff... -> AfffffffffffttddssssCCRRo */
+static int openfile(unsigned char al, const unsigned char *q, unsigned short qlen, unsigned char *a, unsigned short *ax) {
+  char path[PATH_MAX], name[13];
+  struct stat st;
+  unsigned short stk, action, mode, res = 1;
+  int exists, fd, trunc = 0;
+  if (qlen < 6) {
+    *ax = 2;
+    return(0);
+  }
+  stk = get16(q);
+  action = get16(q + 2);
+  mode = get16(q + 4);
+  exists = resolve(path, q + 6, qlen - 6);
+  if ((exists == 3) || (lastcomp(name, q + 6, qlen - 6) != 0) || (tofcb((char *)a + 1, name) != 0)) {
+    *ax = 3;
+    return(0);
+  }
+  exists = (exists == 0);
+  if (exists) {
+    if (stat(path, &st) != 0) {
+      *ax = doserr(errno);
+      return(0);
+    }
+    if (S_ISDIR(st.st_mode)) {
+      *ax = 5;
+      return(0);
+    }
+  }
+  switch (al) {
+    case 0x16: /* OPEN: open mode is in the stack word */
+      if (!exists) {
+        *ax = 2;
+        return(0);
+      }
+      mode = stk & 0x7f;
+      break;
+    case 0x17: /* CREATE: attributes are in the stack word */
+      res = exists?3:2;
+      trunc = 1;
+      mode = 2;
+      break;
+    default:   /* SPOPNFIL: action code tells what to do */
+      mode &= 0x7f;
+      if (exists) {
+        if ((action & 0x0F) == 1) {
+          res = 1;
+        } else if ((action & 0x0F) == 2) {
+          res = 3;
+          trunc = 1;
+        } else {
+          *ax = 80; /* "file exists" */
+          return(0);
+        }
+      } else if ((action & 0xF0) == 0x10) {
+        res = 2;
+        trunc = 1;
+      } else {
+        *ax = 2;
+        return(0);
+      }
+      break;
+  }
+  /* a read-only file may be neither written to nor truncated */
+  if (exists && ((st.st_mode & S_IWUSR) == 0) && (trunc || ((mode & 3) != 0))) {
+    *ax = 5;
+    return(0);
+  }
+  if (trunc) {
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      *ax = doserr(errno);
+      return(0);
+    }
+    close(fd);
+    if ((!exists) && ((stk & 1) != 0)) chmod(path, 0444);
+    srv_list.id = 0;
+  }
+  if (stat(path, &st) != 0) {
+    *ax = doserr(errno);
+    return(0);
+  }
+  a[0] = dosattr(&st);
+  put32(a + 12, dostime(st.st_mtime));
+  put32(a + 16, st.st_size);
+  put16(a + 20, pathid(path));
+  put16(a + 22, res);
+  a[24] = mode;
+  if (get16(a + 20) == 0) *ax = 4; /* "too many open files" */
+  return(25);
+}
+
+
+/* WRITESTREAM: OOOOSSWIFddd... -> MMLLLL (only if F asks for it) */
+static int writestream(const unsigned char *q, unsigned short qlen, unsigned char dflags, unsigned char *a, unsigned short *ax) {
+  const unsigned char *data = q + 9;
+  unsigned long offs, end;
+  unsigned short id;
+  unsigned char idx;
+  long len;
+  int i;
+  if (qlen < 9) {
+    *ax = 1;
+    return(0);
+  }
+  offs = get32(q);
+  id = get16(q + 4);
+  idx = q[7] & 15;
+  len = querydata(&data, qlen - 9, dflags);
+  if (len < 0) return(-1); /* corrupted, the client will resend it */
+  /* find the window of the file, start a new one if need be */
+  for (i = 0; (i < STREAMS) && (srv_streams[i].fileid != id); i++);
+  if (i == STREAMS) {
+    i = srv_streamnext;
+    srv_streamnext = (srv_streamnext + 1) % STREAMS;
+    srv_streams[i].fileid = id;
+    srv_streams[i].winid = q[6] + 1;
+  }
+  if (srv_streams[i].winid != q[6]) {
+    srv_streams[i].winid = q[6];
+    srv_streams[i].mask = 0;
+    srv_streams[i].err = 0;
+  }
+  /* an empty frame would truncate the file, which is not what a stream is about */
+  if (len != 0) len = writeid(id, offs, data, len, &(srv_streams[i].err));
+  if (len >= 0) {
+    srv_streams[i].offs[idx] = offs;
+    srv_streams[i].len[idx] = len;
+    srv_streams[i].mask |= 1 << idx;
+  }
+  if ((q[8] & 1) == 0) return(-1);
+  /* contiguous data written since frame 0 of the window */
+  end = srv_streams[i].offs[0] + srv_streams[i].len[0];
+  for (idx = 1; (idx < 16) && ((srv_streams[i].mask & (1 << idx)) != 0) && (srv_streams[i].offs[idx] == end); idx++) {
+    end += srv_streams[i].len[idx];
+  }
+  put16(a, srv_streams[i].mask);
+  put32(a + 2, end);
+  *ax = srv_streams[i].err;
+  return(6);
+}
+
+
+/* READBULK: OOOOSSLLFFMMMMMMMM -> INddd... (for every fragment asked for),
+ * sent straight away. returns -1, or 0 with *ax set on error */
+static int readbulk(const unsigned char *q, unsigned short qlen, unsigned char *frame, unsigned long delay, refsrv_sendfn send, unsigned short *ax) {
+  unsigned short fragsz, fraglen, i, n;
+  long len;
+  if (qlen < 18) {
+    *ax = 1;
+    return(0);
+  }
+  fragsz = get16(q + 8);
+  if ((fragsz == 0) || (fragsz > REFSRV_FRAMEMAX - 62)) {
+    *ax = 1;
+    return(0);
+  }
+  len = readid(get16(q + 4), get32(q), srv_data, get16(q + 6), ax);
+  if (len < 0) return(0);
+  n = (len == 0)?1:((len - 1) / fragsz) + 1;
+  if (n > 64) n = 64;
+  for (i = 0; i < n; i++) {
+    if ((q[10 + (i >> 3)] & (1 << (i & 7))) == 0) continue;
+    fraglen = (len - (long)i * fragsz > fragsz)?fragsz:(len - (long)i * fragsz);
+    frame[60] = i;
+    frame[61] = n;
+    memcpy(frame + 62, srv_data + (unsigned long)i * fragsz, fraglen);
+    send(frame, 62 + fraglen, delay);
+  }
+  return(-1);
+}
+
+
+/* SRVCOPY: SSOOOOssooooLLLL -> LLLL. copies 64 KiB at most */
+static int srvcopy(const unsigned char *q, unsigned short qlen, unsigned char *a, unsigned short *ax) {
+  unsigned long len;
+  long l;
+  if (qlen < 16) {
+    *ax = 1;
+    return(0);
+  }
+  len = get32(q + 12);
+  if (len > sizeof(srv_data)) len = sizeof(srv_data);
+  l = readid(get16(q), get32(q + 2), srv_data, len, ax);
+  if ((l > 0) && (writeid(get16(q + 6), get32(q + 8), srv_data, l, ax) != l)) *ax = 29; /* "write fault" */
+  if (l < 0) return(0);
+  put32(a, l);
+  return(4);
+}
+
+
+/* DELETE: fff... (may contain wildcards). read-only files and directories
+ * are left alone */
+static void delfiles(const unsigned char *q, unsigned short qlen, unsigned short *ax) {
+  char path[PATH_MAX], tmpl[11];
+  struct stat st;
+  unsigned short dirlen, id;
+  size_t plen;
+  int pos, found = 0;
+  for (dirlen = qlen; (dirlen > 0) && (q[dirlen - 1] != '\\'); dirlen--);
+  totmpl(tmpl, q + dirlen, qlen - dirlen);
+  if ((resolve(path, q, dirlen) != 0) || ((id = pathid(path)) == 0) || (listdir(id) != 0)) {
+    *ax = 3;
+    return;
+  }
+  plen = strlen(path);
+  for (pos = 0; pos < srv_list.count; pos++) {
+    if (!tmplmatch(tmpl, srv_list.e[pos].fcb)) continue;
+    if (plen + strlen(srv_list.e[pos].name) + 2 > sizeof(path)) continue;
+    path[plen] = '/';
+    strcpy(path + plen + 1, srv_list.e[pos].name);
+    if ((stat(path, &st) != 0) || (S_ISDIR(st.st_mode))) continue;
+    found = 1;
+    if ((st.st_mode & S_IWUSR) == 0) {
+      *ax = 5;
+      continue;
+    }
+    if (unlink(path) != 0) *ax = doserr(errno);
+  }
+  if (found == 0) *ax = 2;
+  srv_list.id = 0;
+}
+
+
+/* processes query q of qlen bytes (AL = al) and writes its answer at a.
+ * returns the length of the answer (AX being set in *ax), or -1 if no
+ * answer must be sent (or it has been sent already) */
+static int process(const unsigned char *frame, unsigned char al, const unsigned char *q, unsigned short qlen, unsigned char *a, unsigned long delay, refsrv_sendfn send, unsigned short *ax) {
+  char path[PATH_MAX], path2[PATH_MAX];
+  struct stat st;
+  struct statvfs vfs;
+  struct utimbuf ut;
+  unsigned long long total, avail;
+  unsigned short len;
+  int r;
+  long l;
+  switch (al) {
+    case 0x01: /* RMDIR */
+      if ((resolve(path, q, qlen) != 0) || (stat(path, &st) != 0) || (!S_ISDIR(st.st_mode))) {
+        *ax = 3;
+      } else if ((strcmp(path, srv.root) == 0) || (rmdir(path) != 0)) {
+        *ax = 5; /* root, not empty, current directory... */
+      }
+      srv_list.id = 0;
+      return(0);
+    case 0x03: /* MKDIR */
+      r = resolve(path, q, qlen);
+      if (r == 0) {
+        *ax = 5;
+      } else if ((r == 3) || (!validname(q, qlen))) {
+        *ax = 3;
+      } else if (mkdir(path, 0755) != 0) {
+        *ax = doserr(errno);
+      }
+      srv_list.id = 0;
+      return(0);
+    case 0x05: /* CHDIR */
+      if ((resolve(path, q, qlen) != 0) || (stat(path, &st) != 0) || (!S_ISDIR(st.st_mode))) *ax = 3;
+      return(0);
+    case 0x06: /* CLSFIL: SS - forget about WRITESTREAM windows of the file */
+      if (qlen < 2) return(0);
+      for (r = 0; r < STREAMS; r++) {
+        if (srv_streams[r].fileid == get16(q)) srv_streams[r].fileid = 0;
+      }
+      return(0);
+    case 0x08: /* READFIL: OOOOSSLL -> ddd... (or Fddd... if F is welcome) */
+      if (qlen < 8) {
+        *ax = 1;
+        return(0);
+      }
+      len = get16(q + 6);
+      if (len > REFSRV_FRAMEMAX - 61) len = REFSRV_FRAMEMAX - 61;
+      if ((frame[58] & DFLAG_ZANSWER) == 0) {
+        l = readid(get16(q + 4), get32(q), a, len, ax);
+        return((l < 0)?0:l);
+      }
+      l = readid(get16(q + 4), get32(q), srv_data, len, ax);
+      if (l < 0) return(0);
+      len = ((srv.caps & REFSRV_CAP_COMPRESS) != 0)?lzpack(a + 1, srv_data, l):0;
+      a[0] = (len != 0)?1:0;
+      if (len != 0) return(1 + len);
+      memcpy(a + 1, srv_data, l);
+      return(1 + l);
+    case 0x09: /* WRITEFIL: OOOOSSddd... -> LL */
+      if (qlen < 6) {
+        *ax = 1;
+        return(0);
+      }
+      q += 6;
+      l = querydata(&q, qlen - 6, frame[58]);
+      if (l < 0) return(-1); /* corrupted, the client will resend it */
+      l = writeid(get16(frame + 64), get32(frame + 60), q, l, ax);
+      put16(a, (l < 0)?0:l);
+      return(2);
+    case 0x0C: /* DISKSPACE -> AX = sectors per cluster, BBCCDD. clusters are
+                * 32 KiB long, and there are no more than 65535 of them */
+      if (statvfs(srv.root, &vfs) != 0) {
+        *ax = 5;
+        return(0);
+      }
+      total = ((unsigned long long)vfs.f_blocks * vfs.f_frsize) >> 15;
+      avail = ((unsigned long long)vfs.f_bavail * vfs.f_frsize) >> 15;
+      if (total > 0xffff) total = 0xffff;
+      if (avail > total) avail = total;
+      *ax = 64;
+      put16(a, total);
+      put16(a + 2, 512);
+      put16(a + 4, avail);
+      return(6);
+    case 0x0E: /* SETATTR: Afff... (only read-only makes sense here) */
+      if (qlen < 1) {
+        *ax = 2;
+        return(0);
+      }
+      r = resolve(path, q + 1, qlen - 1);
+      if (r != 0) {
+        *ax = r;
+      } else if ((stat(path, &st) != 0) || (chmod(path, ((q[0] & 1) != 0)?(st.st_mode & ~0222):(st.st_mode | S_IWUSR)) != 0)) {
+        *ax = doserr(errno);
+      }
+      return(0);
+    case 0x0F: /* GETATTR: fff... -> ttddssssA */
+      r = resolve(path, q, qlen);
+      if (r != 0) {
+        *ax = r;
+        return(0);
+      }
+      if (stat(path, &st) != 0) {
+        *ax = doserr(errno);
+        return(0);
+      }
+      put32(a, dostime(st.st_mtime));
+      put32(a + 4, S_ISDIR(st.st_mode)?0:st.st_size);
+      a[8] = dosattr(&st);
+      return(9);
+    case 0x11: /* RENAME: LSSS...DDD... */
+      if ((qlen < 1) || (q[0] > qlen - 1)) {
+        *ax = 2;
+        return(0);
+      }
+      r = resolve(path, q + 1, q[0]);
+      if (r != 0) {
+        *ax = r;
+        return(0);
+      }
+      r = resolve(path2, q + 1 + q[0], qlen - 1 - q[0]);
+      if ((r == 2) && (!validname(q + 1 + q[0], qlen - 1 - q[0]))) r = 3;
+      if (r != 2) {
+        *ax = (r == 0)?5:3; /* DOS does not rename over an existing file */
+      } else if (rename(path, path2) != 0) {
+        *ax = doserr(errno);
+      }
+      srv_list.id = 0;
+      return(0);
+    case 0x13: /* DELETE */
+      delfiles(q, qlen, ax);
+      return(0);
+    case 0x16: /* OPEN */
+    case 0x17: /* CREATE */
+    case 0x2E: /* SPOPNFIL */
+      return(openfile(al, q, qlen, a, ax));
+    case 0x1B: /* FINDFIRST */
+    case 0x1C: /* FINDNEXT */
+      return(search(q, qlen, al == 0x1C, a, 1, ax) * 24);
+    case 0x21: /* SKFMEND: ooooSS -> oooo */
+      if (qlen < 6) {
+        *ax = 1;
+        return(0);
+      }
+      r = openid(get16(q + 4), O_RDONLY);
+      if ((r < 0) || (fstat(r, &st) != 0)) {
+        *ax = doserr(errno);
+        if (r >= 0) close(r);
+        return(0);
+      }
+      close(r);
+      l = (long)st.st_size + (long)(int)get32(q); /* offset is signed */
+      put32(a, (l < 0)?0:l);
+      return(4);
+    case 0x24: /* SETFILETIMESTAMP: ttddSS */
+      if ((qlen < 6) || (idpath(get16(q + 4)) == NULL)) {
+        *ax = 6; /* "invalid handle" */
+        return(0);
+      }
+      {
+        struct tm tm;
+        memset(&tm, 0, sizeof(tm));
+        tm.tm_sec = (q[0] & 31) * 2;
+        tm.tm_min = (get16(q) >> 5) & 63;
+        tm.tm_hour = q[1] >> 3;
+        tm.tm_mday = q[2] & 31;
+        tm.tm_mon = ((get16(q + 2) >> 5) & 15) - 1;
+        tm.tm_year = (q[3] >> 1) + 80;
+        tm.tm_isdst = -1;
+        ut.actime = ut.modtime = mktime(&tm);
+      }
+      if (utime(idpath(get16(q + 4)), &ut) != 0) *ax = doserr(errno);
+      return(0);
+    case 0x40: /* GETCAPS: CCMM -> CCMM */
+      put16(a, srv.caps);
+      put16(a + 2, srv.framesize);
+      return(4);
+    case 0x41: /* WRITESTREAM */
+      if ((srv.caps & REFSRV_CAP_WRITESTREAM) == 0) break;
+      return(writestream(q, qlen, frame[58], a, ax));
+    case 0x42: /* READBULK */
+      if ((srv.caps & REFSRV_CAP_READBULK) == 0) break;
+      return(readbulk(q, qlen, a - 60, delay, send, ax));
+    case 0x43: /* FINDBATCH: NFxxx... -> Neee... */
+      if ((srv.caps & REFSRV_CAP_FINDBATCH) == 0) break;
+      if (qlen < 2) {
+        *ax = 1;
+        return(0);
+      }
+      r = q[0];
+      if (r > (REFSRV_FRAMEMAX - 61) / 24) r = (REFSRV_FRAMEMAX - 61) / 24;
+      a[0] = search(q + 2, qlen - 2, q[1], a + 1, r, ax);
+      return((a[0] == 0)?0:(1 + a[0] * 24));
+    case 0x44: /* SRVCOPY */
+      if ((srv.caps & REFSRV_CAP_SRVCOPY) == 0) break;
+      return(srvcopy(q, qlen, a, ax));
+  }
+  *ax = 1; /* "invalid function" */
+  return(0);
+}
+
+
+void refsrv_defcfg(struct refsrv_cfg *cfg, const char *root) {
+  static const unsigned char mac[6] = {2, 0, 0, 0, 0, 1};
+  memset(cfg, 0, sizeof(*cfg));
+  cfg->root = root;
+  memcpy(cfg->mac, mac, 6);
+  cfg->drive = 2;
+  cfg->caps = REFSRV_CAP_ALL;
+  cfg->framesize = 1514;
+}
+
+
+int refsrv_init(const struct refsrv_cfg *cfg) {
+  struct stat st;
+  int i;
+  if ((stat(cfg->root, &st) != 0) || (!S_ISDIR(st.st_mode))) return(-1);
+  for (i = 0; i < IDSLOTS; i++) {
+    free(srv_ids[i]);
+    srv_ids[i] = NULL;
+  }
+  memcpy(&srv, cfg, sizeof(srv));
+  if (srv.framesize > REFSRV_FRAMEMAX) srv.framesize = REFSRV_FRAMEMAX;
+  pathid(srv.root); /* the root directory gets its identifier first */
+  memset(srv_last, 0, sizeof(srv_last));
+  memset(srv_streams, 0, sizeof(srv_streams));
+  srv_list.id = 0;
+  srv_busy = 0;
+  return(0);
+}
+
+
+void refsrv_query(const unsigned char *frame, unsigned short len, unsigned long now, refsrv_sendfn send) {
+  static const unsigned char bcast[6] = {0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
+  unsigned short ax = 0;
+  unsigned long delay;
+  int alen, c;
+
+  /* is it an EDF5 query for me? */
+  if ((len < 60) || (frame[12] != 0xED) || (frame[13] != 0xF5) || (frame[56] != PROTOVER)) return;
+  if ((memcmp(frame, srv.mac, 6) != 0) && (memcmp(frame, bcast, 6) != 0)) return;
+
+  /* queries are served one after another, each taking srv.service */
+  if ((long)(now - srv_busy) > 0) srv_busy = now;
+  srv_busy += srv.service;
+  delay = srv_busy - now + srv.latency;
+
+  /* a query I answered last already is repeated because my answer got lost */
+  for (c = 0; (c < CLIENTS) && ((srv_last[c].len == 0) || (memcmp(srv_last[c].mac, frame + 6, 6) != 0)); c++);
+  if ((c < CLIENTS) && (srv_last[c].seq == frame[57]) && (srv_last[c].al == frame[59])) {
+    send(srv_last[c].frame, srv_last[c].len, delay);
+    return;
+  }
+
+  /* headers of the answer are these of the query, from me to the client */
+  memcpy(srv_ans, frame + 6, 6);
+  memcpy(srv_ans + 6, srv.mac, 6);
+  memcpy(srv_ans + 12, frame + 12, 46);
+
+  if ((frame[58] & 0x1F) != srv.drive) {
+    ax = 15; /* "invalid drive" */
+    alen = 0;
+  } else {
+    alen = process(frame, frame[59], frame + 60, len - 60, srv_ans + 60, delay, send, &ax);
+    if (alen < 0) return;
+  }
+  srv_ans[58] = ax & 0xff;
+  srv_ans[59] = ax >> 8;
+  send(srv_ans, 60 + alen, delay);
+
+  /* keep the answer in case the query comes again */
+  if (c == CLIENTS) {
+    c = srv_lastnext;
+    srv_lastnext = (srv_lastnext + 1) % CLIENTS;
+    memcpy(srv_last[c].mac, frame + 6, 6);
+  }
+  srv_last[c].seq = frame[57];
+  srv_last[c].al = frame[59];
+  srv_last[c].len = 60 + alen;
+  memcpy(srv_last[c].frame, srv_ans, 60 + alen);
+}
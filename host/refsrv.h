@@ -0,0 +1,63 @@
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * A reference EDF5 server, serving a directory of the local file system. It
+ * knows every query of protocol.txt (extensions included), and does not care
+ * about how frames travel: queries are handed to refsrv_query() along with a
+ * function that sends the answers. This makes it usable both in-process, as
+ * the host_peer of the host build (see bench.c), and over a TAP device (see
+ * tapsrv.c).
+ *
+ * The time it takes the server to answer is part of its configuration: every
+ * query keeps the server busy for a given service time, queries that arrive
+ * while the server is busy wait for their turn, and every answer spends a
+ * given latency on the wire. Real time spent on file system calls is not
+ * accounted for, so that results do not depend on the machine.
+ */
+
+#ifndef REFSRV_SENTINEL
+#define REFSRV_SENTINEL
+
+/* capability bits, as exchanged through GETCAPS (see protocol.txt) */
+#define REFSRV_CAP_WRITESTREAM 0x0001u
+#define REFSRV_CAP_READBULK    0x0002u
+#define REFSRV_CAP_FINDBATCH   0x0004u
+#define REFSRV_CAP_COMPRESS    0x0008u
+#define REFSRV_CAP_SRVCOPY     0x0010u
+#define REFSRV_CAP_ALL         0x001Fu
+
+/* biggest frame the server can handle (MAC headers included) */
+#define REFSRV_FRAMEMAX 9216
+
+struct refsrv_cfg {
+  const char *root;          /* local directory served */
+  unsigned char mac[6];      /* MAC address of the server */
+  unsigned char drive;       /* drive served (A=0, B=1, C=2...) */
+  unsigned short caps;       /* extensions announced through GETCAPS */
+  unsigned short framesize;  /* biggest frame announced through GETCAPS */
+  unsigned long service;     /* time spent on each query, in pit_now() units */
+  unsigned long latency;     /* time each answer spends on the wire */
+};
+
+/* sends the answer frame of len bytes (MAC headers included) delay pit_now()
+ * units from now. frames sent with the same delay must arrive in order */
+typedef void (*refsrv_sendfn)(const unsigned char *frame, unsigned short len, unsigned long delay);
+
+/* fills cfg with defaults: serves root as drive C:, at MAC address
+ * 02:00:00:00:00:01, with all extensions, 1514-bytes frames and no delays */
+void refsrv_defcfg(struct refsrv_cfg *cfg, const char *root);
+
+/* sets the server up (cfg is copied). forgets about every file and
+ * directory identifier given out before. returns 0 on success, -1 if root
+ * is not a directory */
+int refsrv_init(const struct refsrv_cfg *cfg);
+
+/* processes the frame of len bytes received at time now (in pit_now()
+ * units), answering through send. frames that are not EDF5 queries meant
+ * for this server are ignored */
+void refsrv_query(const unsigned char *frame, unsigned short len, unsigned long now, refsrv_sendfn send);
+
+#endif
@@ -0,0 +1,381 @@
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * Replays a trace of INT 2F calls through the host build of EtherDFS (see
+ * replay.h).
+ */
+
+#include <ctype.h>
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include "host.h"
+#include "replay.h"
+
+/* subfunctions known to replay_run() */
+#define AL_RMDIR     0x01
+#define AL_MKDIR     0x03
+#define AL_CHDIR     0x05
+#define AL_CLSFIL    0x06
+#define AL_CMMTFIL   0x07
+#define AL_READFIL   0x08
+#define AL_WRITEFIL  0x09
+#define AL_DISKSPACE 0x0C
+#define AL_SETATTR   0x0E
+#define AL_GETATTR   0x0F
+#define AL_DELETE    0x13
+#define AL_OPEN      0x16
+#define AL_CREATE    0x17
+#define AL_FINDFIRST 0x1B
+#define AL_FINDNEXT  0x1C
+#define AL_SKFMEND   0x21
+#define AL_SPOPNFIL  0x2E
+
+/* record flags (see trace.txt) */
+#define TRC_FAIL  1
+#define TRC_TRUNC 2
+
+#define TRC_HDRSZ 16
+#define TRC_RECSZ 64
+#define TRC_PATH  38
+
+struct rec {
+  unsigned char al;
+  unsigned char flags;
+  unsigned short cx;
+  unsigned short ax;
+  unsigned short file;
+  unsigned long pos;
+  unsigned short arg[3];
+  unsigned long gap;  /* time between the end of the previous call and this one */
+  char path[TRC_PATH + 1];
+};
+
+static struct rec *trc;
+static unsigned long trccount;
+
+/* files opened by the replay: identifier of each file in the trace (-1 if
+ * the handle is not in use), and when it was opened */
+static struct {
+  long id;
+  unsigned long seq;
+} fmap[HOST_FILES];
+static unsigned long fseq;
+
+
+static unsigned short get16(const unsigned char *p) {
+  return(p[0] | (p[1] << 8));
+}
+
+
+static unsigned long get32(const unsigned char *p) {
+  return(get16(p) | ((unsigned long)get16(p + 2) << 16));
+}
+
+
+/* returns the time between two records that began at BIOS ticks t1 and t2
+ * and at pit_now() times s1 and s2. pit_now() wraps every 64 ticks, so the
+ * ticks tell how many times it wrapped in between */
+static unsigned long elapsed(unsigned short t1, unsigned short s1, unsigned short t2, unsigned short s2) {
+  long long approx = (long long)(unsigned short)(t2 - t1) * 1024;
+  long long d = (unsigned short)(s2 - s1);
+  d += ((approx - d + 32768) >> 16) << 16;
+  return((d < 0)?0:d);
+}
+
+
+long replay_load(const char *fname) {
+  unsigned char hdr[TRC_HDRSZ], r[TRC_RECSZ];
+  unsigned short ptick = 0, pstart = 0, ptime = 0;
+  unsigned long i, d;
+  FILE *fd;
+  fd = fopen(fname, "rb");
+  if (fd == NULL) return(-1);
+  if ((fread(hdr, 1, TRC_HDRSZ, fd) != TRC_HDRSZ) || (memcmp(hdr, "EDFTRC", 6) != 0) || (hdr[6] != 1) || (hdr[7] != TRC_RECSZ)) {
+    fclose(fd);
+    return(-1);
+  }
+  free(trc);
+  trccount = get32(hdr + 8);
+  trc = calloc(trccount + 1, sizeof(struct rec));
+  if (trc == NULL) {
+    fclose(fd);
+    return(-1);
+  }
+  for (i = 0; i < trccount; i++) {
+    if (fread(r, 1, TRC_RECSZ, fd) != TRC_RECSZ) break;
+    trc[i].al = r[0];
+    trc[i].flags = r[2];
+    trc[i].cx = get16(r + 10);
+    trc[i].ax = get16(r + 12);
+    trc[i].file = get16(r + 14);
+    trc[i].pos = get32(r + 16);
+    trc[i].arg[0] = get16(r + 20);
+    trc[i].arg[1] = get16(r + 22);
+    trc[i].arg[2] = get16(r + 24);
+    memcpy(trc[i].path, r + 26, TRC_PATH);
+    if (i != 0) {
+      d = elapsed(ptick, pstart, get16(r + 4), get16(r + 6));
+      trc[i].gap = (d > ptime)?(d - ptime):0;
+    }
+    ptick = get16(r + 4);
+    pstart = get16(r + 6);
+    ptime = get16(r + 8);
+  }
+  fclose(fd);
+  trccount = i;
+  return(trccount);
+}
+
+
+/* translates the DOS path dos ("\DIR\FILE.TXT") into a local path within
+ * dir at out (PATH_MAX bytes), matching existing names without regard to
+ * case. missing directories along the way are created if mkdirs is set.
+ * returns 0 if the path exists, 1 if all of it but its last component
+ * exists (out ends with this component in lower case then), -1 otherwise */
+static int localpath(char *out, const char *dir, const char *dos, int mkdirs, unsigned long *created) {
+  struct dirent *de;
+  struct stat st;
+  size_t olen;
+  int clen, found;
+  DIR *d;
+  if (strlen(dir) + 1 >= PATH_MAX) return(-1);
+  strcpy(out, dir);
+  for (;;) {
+    while (*dos == '\\') dos++;
+    if (*dos == 0) return(0);
+    olen = strlen(out);
+    if (olen + 14 >= PATH_MAX) return(-1);
+    out[olen] = '/';
+    for (clen = 0; (*dos != 0) && (*dos != '\\'); dos++) {
+      if (clen == 12) return(-1);
+      out[olen + 1 + clen++] = tolower(*dos);
+    }
+    out[olen + 1 + clen] = 0;
+    while (*dos == '\\') dos++;
+    found = (stat(out, &st) == 0);
+    if (!found) {
+      out[olen] = 0;
+      d = opendir(out);
+      out[olen] = '/';
+      if (d == NULL) return(-1);
+      while ((de = readdir(d)) != NULL) {
+        if (strcasecmp(de->d_name, out + olen + 1) != 0) continue;
+        strcpy(out + olen + 1, de->d_name);
+        found = 1;
+        break;
+      }
+      closedir(d);
+    }
+    if (*dos == 0) return(found?0:1);
+    if (!found) {
+      if ((mkdirs == 0) || (mkdir(out, 0777) != 0)) return(-1);
+      (*created)++;
+    }
+  }
+}
+
+
+long replay_prepare(const char *dir) {
+  static char path[PATH_MAX];
+  unsigned long i, j, *extent, created = 0;
+  long *opened; /* record that opened each file identifier */
+  FILE *fd;
+  int res, err = 0;
+  extent = calloc(trccount + 1, sizeof(unsigned long));
+  opened = malloc(65536 * sizeof(long));
+  if ((extent == NULL) || (opened == NULL)) {
+    free(extent);
+    free(opened);
+    return(-1);
+  }
+  for (i = 0; i < 65536; i++) opened[i] = -1;
+  /* how far into each opened file the trace reads */
+  for (i = 0; i < trccount; i++) {
+    if ((trc[i].flags & TRC_FAIL) != 0) continue;
+    if ((trc[i].al == AL_OPEN) || (trc[i].al == AL_SPOPNFIL) || (trc[i].al == AL_CREATE)) {
+      opened[trc[i].file] = (trc[i].al == AL_CREATE)?-1:(long)i;
+    } else if ((trc[i].al == AL_READFIL) && (opened[trc[i].file] >= 0)) {
+      j = opened[trc[i].file];
+      if (trc[i].pos + trc[i].cx > extent[j]) extent[j] = trc[i].pos + trc[i].cx;
+    }
+  }
+  for (i = 0; (i < trccount) && (err == 0); i++) {
+    if ((trc[i].flags & (TRC_FAIL | TRC_TRUNC)) != 0) continue;
+    switch (trc[i].al) {
+      case AL_OPEN:
+      case AL_SPOPNFIL:
+      case AL_GETATTR:
+      case AL_CHDIR:
+        break;
+      default:
+        continue;
+    }
+    res = localpath(path, dir, trc[i].path, 1, &created);
+    if (res != 1) {
+      if (res < 0) err = -1;
+      continue;
+    }
+    created++;
+    /* CHDIR and GETATTR (with the directory attribute) found a directory */
+    if ((trc[i].al == AL_CHDIR) || ((trc[i].al == AL_GETATTR) && ((trc[i].ax & 0x10) != 0))) {
+      if (mkdir(path, 0777) != 0) err = -1;
+      continue;
+    }
+    fd = fopen(path, "wb");
+    if (fd == NULL) {
+      err = -1;
+      continue;
+    }
+    if ((extent[i] != 0) && ((fseek(fd, extent[i] - 1, SEEK_SET) != 0) || (fputc(0, fd) == EOF))) err = -1;
+    if (fclose(fd) != 0) err = -1;
+  }
+  free(extent);
+  free(opened);
+  return((err != 0)?-1:(long)created);
+}
+
+
+/* returns the handle of the file known in the trace as id (the latest one
+ * opened, if there are several), or -1 */
+static int fhof(unsigned short id) {
+  int fh, res = -1;
+  for (fh = 0; fh < HOST_FILES; fh++) {
+    if (fmap[fh].id != id) continue;
+    if ((res < 0) || (fmap[fh].seq > fmap[res].seq)) res = fh;
+  }
+  return(res);
+}
+
+
+/* remembers that fh is the file known in the trace as id */
+static void fhset(int fh, unsigned short id) {
+  if ((fh < 0) || (fh >= HOST_FILES)) return;
+  fmap[fh].id = id;
+  fmap[fh].seq = fseq++;
+}
+
+
+void replay_run(int faithful, struct replay_stats *st) {
+  static unsigned char buff[65535];
+  struct host_find f;
+  host_callfn oncall;
+  unsigned long i, size;
+  unsigned short w;
+  int fh, err, searching = 0;
+  struct rec *r;
+
+  for (fh = 0; fh < HOST_FILES; fh++) fmap[fh].id = -1;
+  for (i = 0; i < sizeof(buff); i++) buff[i] = i & 0xff;
+
+  for (i = 0; i < trccount; i++) {
+    r = trc + i;
+    if (faithful != 0) {
+      host_sleep(r->gap);
+      st->idle += r->gap;
+    }
+    /* calls on open files need a file that the replay opened */
+    fh = -1;
+    if (((r->al >= AL_CLSFIL) && (r->al <= AL_WRITEFIL)) || (r->al == AL_SKFMEND)) {
+      fh = fhof(r->file);
+      if (fh < 0) {
+        st->skipped++;
+        continue;
+      }
+      host_seek(fh, r->pos);
+    } else if ((r->flags & TRC_TRUNC) != 0) {
+      st->skipped++;
+      continue;
+    }
+    switch (r->al) {
+      case AL_RMDIR:
+        err = host_rmdir(r->path);
+        break;
+      case AL_MKDIR:
+        err = host_mkdir(r->path);
+        break;
+      case AL_CHDIR:
+        err = host_chdir(r->path);
+        break;
+      case AL_CLSFIL:
+        err = host_close(fh);
+        fmap[fh].id = -1;
+        break;
+      case AL_CMMTFIL:
+        err = host_commit(fh);
+        break;
+      case AL_READFIL:
+        err = host_read(fh, buff, r->cx, &w);
+        break;
+      case AL_WRITEFIL:
+        err = host_write(fh, buff, r->cx, &w);
+        break;
+      case AL_DISKSPACE:
+        err = host_diskspace(&size, &size);
+        break;
+      case AL_SETATTR:
+        err = host_setattr(r->path, r->arg[0]);
+        break;
+      case AL_GETATTR:
+        err = host_getattr(r->path, &w, &size);
+        break;
+      case AL_DELETE:
+        err = host_delete(r->path);
+        break;
+      case AL_OPEN:
+      case AL_CREATE:
+      case AL_SPOPNFIL:
+        if (r->al == AL_OPEN) {
+          err = host_open(r->path, r->arg[0], &fh);
+        } else if (r->al == AL_CREATE) {
+          err = host_create(r->path, r->arg[0], &fh);
+        } else {
+          err = host_spopen(r->path, r->arg[1], r->arg[2], r->arg[0], &fh, &w);
+        }
+        if (err != 0) break;
+        if ((r->flags & TRC_FAIL) == 0) {
+          fhset(fh, r->file);
+        } else { /* nothing in the trace will ever close it */
+          oncall = host_oncall;
+          host_oncall = NULL;
+          host_close(fh);
+          host_oncall = oncall;
+        }
+        break;
+      case AL_FINDFIRST:
+        err = host_findfirst(r->path, r->arg[0], &f);
+        searching = 1;
+        break;
+      case AL_FINDNEXT:
+        if (searching == 0) {
+          st->skipped++;
+          continue;
+        }
+        err = host_findnext(&f);
+        break;
+      case AL_SKFMEND:
+        err = host_seekend(fh, ((long)r->cx << 16) | r->arg[0], &size);
+        break;
+      default: /* RENAME, LOCKFIL, UNLOCKFIL... */
+        st->skipped++;
+        continue;
+    }
+    st->calls++;
+    if ((err != 0) != ((r->flags & TRC_FAIL) != 0)) st->diverged++;
+  }
+
+  /* close files that the trace left open, without accounting for it */
+  oncall = host_oncall;
+  host_oncall = NULL;
+  for (fh = 0; fh < HOST_FILES; fh++) {
+    if (fmap[fh].id >= 0) host_close(fh);
+  }
+  host_oncall = oncall;
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * Replays a trace of INT 2F calls, as written by 'etherdfs /t=FILE' (see
+ * trace.txt), through the host build of EtherDFS. Every call of the trace is
+ * made again through the host_*() calls of host.h, so queries are built by
+ * process2f() itself, the way the traced EtherDFS built them.
+ *
+ * A trace does not hold everything a call needs: data written is made up,
+ * the new name of RENAME is not known, and paths may be truncated. Records
+ * that cannot be replayed (RENAME, LOCKFIL, UNLOCKFIL, truncated paths,
+ * calls on files opened before the trace began...) are skipped. All calls
+ * are made on the one drive of the host build, whatever drive they were
+ * made on.
+ */
+
+#ifndef REPLAY_SENTINEL
+#define REPLAY_SENTINEL
+
+/* what replay_run() went through */
+struct replay_stats {
+  unsigned long calls;     /* calls made to EtherDFS */
+  unsigned long skipped;   /* records that could not be replayed */
+  unsigned long diverged;  /* calls that failed while they succeeded in the trace, or the other way around */
+  unsigned long idle;      /* time spent between calls, in pit_now() units */
+};
+
+/* loads the trace file fname. returns the amount of records loaded, or -1
+ * if fname cannot be read or is not a trace file */
+long replay_load(const char *fname);
+
+/* makes sure that the local directory dir holds what the trace expects to
+ * find: files opened by the trace are created if they do not exist (big
+ * enough for what the trace reads from them), and so are directories the
+ * trace found. returns the amount of files and directories created, or -1
+ * on error */
+long replay_prepare(const char *dir);
+
+/* makes the calls of the trace once, in order. if faithful is set, the time
+ * that went by between the end of a call and the beginning of the next one
+ * in the trace goes by again (through host_sleep()), otherwise calls are
+ * made back to back. files the trace leaves open are closed at the end.
+ * adds what happened to *st */
+void replay_run(int faithful, struct replay_stats *st);
+
+#endif
@@ -0,0 +1,191 @@
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * tapsrv runs the reference server of refsrv.c on a Linux TAP device, so a
+ * real EtherDFS (in a virtual machine bridged to the TAP device, typically)
+ * can be served from a local directory. Answers are held back for as long
+ * as the latency and service time of the server say, in real time.
+ */
+
+#define _GNU_SOURCE /* for ppoll() */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+#include "refsrv.h"
+
+/* length of a BIOS tick, in microseconds */
+#define TICKUS 54925lu
+
+/* answers waiting for their time to leave */
+#define PENDMAX 256
+
+static struct {
+  unsigned long long due;  /* in microseconds */
+  unsigned short len;
+  unsigned char frame[REFSRV_FRAMEMAX];
+} pend[PENDMAX];
+static int pendcount;
+static int tapfd;
+
+
+static unsigned long long now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return((unsigned long long)ts.tv_sec * 1000000 + (ts.tv_nsec / 1000));
+}
+
+
+/* sends frames whose time has come, in the order they were queued */
+static void flush(void) {
+  unsigned long long t = now_us();
+  int i, j;
+  for (i = 0; i < pendcount;) {
+    if (pend[i].due > t) {
+      i++;
+      continue;
+    }
+    if (write(tapfd, pend[i].frame, pend[i].len) < 0) perror("write");
+    for (j = i + 1; j < pendcount; j++) pend[j - 1] = pend[j];
+    pendcount--;
+  }
+}
+
+
+static void tapsend(const unsigned char *frame, unsigned short len, unsigned long delay) {
+  if (pendcount == PENDMAX) flush();
+  if (pendcount == PENDMAX) return; /* lost, the client will ask again */
+  pend[pendcount].due = now_us() + ((unsigned long long)delay * TICKUS / 1024);
+  pend[pendcount].len = len;
+  memcpy(pend[pendcount].frame, frame, len);
+  pendcount++;
+  flush();
+}
+
+
+/* opens the TAP device name, returns a descriptor or -1 */
+static int tapopen(const char *name) {
+  struct ifreq ifr;
+  int fd = open("/dev/net/tun", O_RDWR);
+  if (fd < 0) return(-1);
+  memset(&ifr, 0, sizeof(ifr));
+  ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+  strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+  if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+    close(fd);
+    return(-1);
+  }
+  return(fd);
+}
+
+
+/* converts microseconds into pit_now() units */
+static unsigned long us2pit(unsigned long us) {
+  return((us * 1024 + TICKUS / 2) / TICKUS);
+}
+
+
+/* reads a MAC address in the xx:xx:xx:xx:xx:xx format, returns 0 on success */
+static int readmac(unsigned char *mac, const char *s) {
+  unsigned int b[6];
+  int i;
+  if (sscanf(s, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) return(-1);
+  for (i = 0; i < 6; i++) mac[i] = b[i];
+  return(0);
+}
+
+
+static void help(void) {
+  puts("tapsrv - serves a directory to EtherDFS over a TAP device\n"
+       "\n"
+       "Usage: tapsrv [options] tapdev dir\n"
+       "\n"
+       "Options:\n"
+       "  -m MAC MAC address of the server (default: 02:00:00:00:00:01)\n"
+       "  -r X   serve dir as drive X (default: C)\n"
+       "  -f N   frames up to N bytes (default: 1514)\n"
+       "  -c N   support extensions N (default: 31)\n"
+       "  -l N   answers come N microseconds late (default: 0)\n"
+       "  -t N   spend N microseconds on each query (default: 0)\n"
+       "\n"
+       "The TAP device is created if it does not exist, and must be brought up\n"
+       "(and bridged to the network of the client) separately.");
+}
+
+
+int main(int argc, char **argv) {
+  static unsigned char frame[REFSRV_FRAMEMAX];
+  struct refsrv_cfg cfg;
+  struct pollfd pfd;
+  struct timespec ts;
+  unsigned long long t, next;
+  int argi;
+  ssize_t len;
+
+  refsrv_defcfg(&cfg, NULL);
+  for (argi = 1; (argi + 1 < argc) && (argv[argi][0] == '-'); argi += 2) {
+    char *v = argv[argi + 1];
+    if ((argv[argi][1] == 0) || (argv[argi][2] != 0)) break;
+    switch (argv[argi][1]) {
+      case 'm':
+        if (readmac(cfg.mac, v) != 0) argi = argc;
+        break;
+      case 'r': cfg.drive = (v[0] & 0xDF) - 'A'; break;
+      case 'f': cfg.framesize = atoi(v); break;
+      case 'c': cfg.caps = strtoul(v, NULL, 0); break;
+      case 'l': cfg.latency = us2pit(strtoul(v, NULL, 10)); break;
+      case 't': cfg.service = us2pit(strtoul(v, NULL, 10)); break;
+      default: argi = argc; break;
+    }
+  }
+  if (argi + 2 != argc) {
+    help();
+    return(1);
+  }
+  cfg.root = argv[argi + 1];
+  if (refsrv_init(&cfg) != 0) {
+    fprintf(stderr, "%s is not a directory\n", cfg.root);
+    return(1);
+  }
+  tapfd = tapopen(argv[argi]);
+  if (tapfd < 0) {
+    fprintf(stderr, "cannot open TAP device %s: %s\n", argv[argi], strerror(errno));
+    return(1);
+  }
+
+  for (;;) {
+    /* wait for a frame, or for the next answer to be due */
+    if (pendcount != 0) {
+      next = pend[0].due;
+      for (argi = 1; argi < pendcount; argi++) {
+        if (pend[argi].due < next) next = pend[argi].due;
+      }
+      t = now_us();
+      if (next < t) next = t;
+      ts.tv_sec = (next - t) / 1000000;
+      ts.tv_nsec = ((next - t) % 1000000) * 1000;
+    }
+    pfd.fd = tapfd;
+    pfd.events = POLLIN;
+    if ((ppoll(&pfd, 1, (pendcount != 0)?&ts:NULL, NULL) > 0) && ((pfd.revents & POLLIN) != 0)) {
+      len = read(tapfd, frame, sizeof(frame));
+      if (len < 0) {
+        if (errno == EINTR) continue;
+        perror("read");
+        return(1);
+      }
+      refsrv_query(frame, len, us2pit(now_us()), tapsend);
+    }
+    flush();
+  }
+}
@@ -0,0 +1,112 @@
+/*
+ * This file is part of the etherdfs project.
+ * http://etherdfs.sourceforge.net
+ *
+ * Copyright (C) 2017 Mateusz Viste
+ *
+ * Contains definitions of the EtherDFS multiplex interface, ie. calls that
+ * applications can make through INT 2Fh, AH = the multiplex id of EtherDFS.
+ * Every call but the install check (AL=0) expects CX to be set to MPXSIG.
+ */
+
+#ifndef MPLEX_SENTINEL
+#define MPLEX_SENTINEL
+
+/* signature returned in BX by the install check, and expected in CX by all
+ * other calls */
+#define MPXSIG 0x4d86
+
+/* multiplex calls (value of AL) */
+#define MPX_INSTALLCHK 0 /* returns AL=FFh, BX=MPXSIG, CX=year */
+#define MPX_GETDATA    1 /* returns AX=0, BX:CX = TSR's shared data (for unloading) */
+#define MPX_SRVCOPY    2 /* server-side copy, ES:DI -> struct mpxcopy */
+#define MPX_GETSTATS   3 /* returns AX=0, BX:CX = TSR's counters (struct mpxstats) */
+#define MPX_GETHIST    4 /* returns AX=0, BX:CX = latency histograms (struct mpxhist[0x2F]), or AX=1 */
+#define MPX_GETTRACE   5 /* returns AX=0, BX:CX = trace ring (struct mpxtracehdr), or AX=1 */
+
+/* parameters of MPX_SRVCOPY: copies len bytes from the current position of
+ * the file src into the current position of the file dst (both being SFT
+ * entries of files open on the same EtherDFS drive) without the data going
+ * through the network. Positions of both files are updated. On return, AX is
+ * 0 on success, a DOS error code otherwise (1 if the copy cannot be done
+ * by the server, so the caller should copy the file by itself), and len is
+ * set to the amount of bytes actually copied (less than asked at the end of
+ * the source file) */
+struct mpxcopy {
+  void far *src;     /* SFT entry of the source file */
+  void far *dst;     /* SFT entry of the destination file */
+  unsigned long len; /* amount of bytes to copy (updated with the amount copied) */
+};
+
+/* counters of the resident part, as pointed at by MPX_GETSTATS. They count
+ * everything since EtherDFS has been loaded and are updated in place (also
+ * from within the packet driver's receive call), so two successive reads
+ * may be compared to see what happened in between */
+struct mpxstats {
+  unsigned long calls[0x2F]; /* redirector calls handled, per subfunction (AL) */
+  unsigned long rdbytes;     /* bytes read by applications */
+  unsigned long wrbytes;     /* bytes written by applications */
+  unsigned long txframes;    /* frames sent */
+  unsigned long rxframes;    /* frames received that answer a pending query */
+  unsigned long rexmits;     /* timeouts after which a query has been sent again */
+  unsigned long timeouts;    /* queries given up because a server did not answer */
+  unsigned long rxignored;   /* frames dropped: not EDF5, wrong MAC or seq */
+  unsigned long rxbusy;      /* frames refused: receive buffers busy (or too small) */
+};
+
+/* latency histograms of redirector calls, one per subfunction (AL), as
+ * pointed at by MPX_GETHIST. They are kept only if EtherDFS has been loaded
+ * with /l (MPX_GETHIST returns AX=1 otherwise). The time of each call is
+ * split between the network (sending queries and waiting for the answers,
+ * including the handling of data frames as they arrive) and the rest, which
+ * is local processing. Times are measured in units of 1/1024th of a BIOS
+ * tick (about 54us): bucket 0 counts calls that took less than one unit,
+ * bucket n (1..14) those that took 2^(n-1) to 2^n - 1 units, and bucket 15
+ * all longer ones */
+#define MPXHISTBUCKETS 16
+struct mpxhist {
+  unsigned long net[MPXHISTBUCKETS];   /* time spent on the network */
+  unsigned long local[MPXHISTBUCKETS]; /* time spent locally */
+};
+
+/* trace ring of redirector calls, kept only if EtherDFS has been loaded with
+ * /t=N (MPX_GETTRACE returns AX=1 otherwise). If xms is 0, the ring lives in
+ * a segment of its own: the header below is at offset 0, and is followed by
+ * max records. Otherwise the records are in the XMS block of handle xms
+ * (record n at offset n * sizeof(struct mpxtrace)), and the header is in the
+ * data segment of EtherDFS. Records are written in turn, wrapping around to
+ * the first one once the last one has been written. Setting paused makes
+ * EtherDFS stop recording calls, which is what a reader should do while it
+ * looks at the ring */
+struct mpxtracehdr {
+  unsigned short max;     /* amount of records the ring holds */
+  unsigned short next;    /* record to be written next */
+  unsigned long total;    /* records written since EtherDFS has been loaded */
+  unsigned char paused;   /* non-zero: calls are not recorded */
+  unsigned char reserved1;
+  unsigned short xms;     /* XMS handle of the records, 0 if they follow the header */
+  unsigned char reserved2[4];
+};
+
+/* a record of the trace ring (64 bytes, also the format of trace files -
+ * see trace.txt). Times are in units of 1/1024th of a BIOS tick */
+#define MPXTRACEPATH 38
+#define MPXTRACE_FAIL 1  /* the call failed (CF set, ax is the error code) */
+#define MPXTRACE_TRUNC 2 /* path was too long to be recorded entirely */
+struct mpxtrace {
+  unsigned char al;       /* subfunction */
+  unsigned char drive;    /* local drive (A=0, B=1...) */
+  unsigned char flags;    /* MPXTRACE_xxx */
+  unsigned char reserved;
+  unsigned short tick;    /* BIOS tick counter (low word) when the call began */
+  unsigned short start;   /* pit_now() when the call began */
+  unsigned short time;    /* time the call took */
+  unsigned short cx;      /* CX on entry (bytes to read or write...) */
+  unsigned short ax;      /* AX on return */
+  unsigned short file;    /* server's id of the file (SFT-based and open calls), FFFFh otherwise */
+  unsigned long pos;      /* position of the file on entry (SFT-based calls) */
+  unsigned short arg[3];  /* extra arguments, see trace.txt */
+  char path[MPXTRACEPATH]; /* fn1 without its drive letter (path-based calls), zero-padded */
+};
+
+#endif
@@ -0,0 +1,20 @@
+/* msg\bufrdcd.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 66,117,102,102,101,114,115,32,100,111,32,110,111,116,32,102
+  S001 db 105,116,32,105,110,32,54,52,32,75,105,66,32,119,105,116
+  S002 db 104,32,102,114,97,109,101,115,32,111,102,32,116,104,105,115
+  S003 db 32,115,105,122,101,44,32,117,115,105,110,103,32,47,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
@@ -0,0 +1,21 @@
+/* msg\dsegsz.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 68,65,84,65,83,69,71,83,90,32,105,115,32,116,111,111
+  S001 db 32,115,109,97,108,108,32,102,111,114,32,116,104,101,32,100
+  S002 db 97,116,97,32,97,110,100,32,115,116,97,99,107,32,111,102
+  S003 db 32,69,116,104,101,114,68,70,83,32,40,115,101,101,32,103
+  S004 db 108,111,98,97,108,115,46,104,41,46,13,10,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
@@ -1,48 +1,99 @@
-/* msg\help.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
-_asm {
-  push ds
-  push dx
-  push ax
-  call getip
-  S000 db 69,116,104,101,114,68,70,83,32,118,48,46,56,32,47,32
-  S001 db 67,111,112,121,114,105,103,104,116,32,40,67,41,32,50,48
-  S002 db 49,55,32,77,97,116,101,117,115,122,32,86,105,115,116,101
-  S003 db 13,10,65,32,110,101,116,119,111,114,107,32,100,114,105,118
-  S004 db 101,32,102,111,114,32,68,79,83,44,32,114,117,110,110,105
-  S005 db 110,103,32,111,118,101,114,32,114,97,119,32,101,116,104,101
-  S006 db 114,110,101,116,13,10,13,10,85,115,97,103,101,58,32,101
-  S007 db 116,104,101,114,100,102,115,32,83,82,86,77,65,67,32,114
-  S008 db 100,114,118,45,108,100,114,118,32,91,114,100,114,118,50,45
-  S009 db 108,100,114,118,50,32,46,46,46,93,32,91,111,112,116,105
-  S00A db 111,110,115,93,13,10,32,32,32,32,32,32,32,101,116,104
-  S00B db 101,114,100,102,115,32,47,117,13,10,13,10,79,112,116,105
-  S00C db 111,110,115,58,13,10,32,32,47,112,61,88,88,32,32,32
-  S00D db 117,115,101,32,112,97,99,107,101,116,32,100,114,105,118,101
-  S00E db 114,32,97,116,32,105,110,116,101,114,114,117,112,116,32,88
-  S00F db 88,32,40,97,117,116,111,100,101,116,101,99,116,32,111,116
-  S010 db 104,101,114,119,105,115,101,41,13,10,32,32,47,113,32,32
-  S011 db 32,32,32,32,113,117,105,101,116,32,109,111,100,101,32,40
-  S012 db 112,114,105,110,116,32,110,111,116,104,105,110,103,32,105,102
-  S013 db 32,108,111,97,100,101,100,32,115,117,99,99,101,115,115,102
-  S014 db 117,108,108,121,41,13,10,32,32,47,117,32,32,32,32,32
-  S015 db 32,117,110,108,111,97,100,32,69,116,104,101,114,68,70,83
-  S016 db 32,102,114,111,109,32,109,101,109,111,114,121,13,10,13,10
-  S017 db 85,115,101,32,39,58,58,39,32,97,115,32,83,82,86,77
-  S018 db 65,67,32,102,111,114,32,115,101,114,118,101,114,32,97,117
-  S019 db 116,111,45,100,105,115,99,111,118,101,114,121,46,13,10,13
-  S01A db 10,69,120,97,109,112,108,101,115,58,32,32,101,116,104,101
-  S01B db 114,100,102,115,32,54,100,58,52,102,58,52,97,58,52,100
-  S01C db 58,52,57,58,53,50,32,67,45,70,32,47,113,13,10,32
-  S01D db 32,32,32,32,32,32,32,32,32,32,101,116,104,101,114,100
-  S01E db 102,115,32,58,58,32,67,45,88,32,68,45,89,32,69,45
-  S01F db 90,32,47,112,61,54,70,13,10,'$'
- getip:
-  pop dx
-  push cs
-  pop ds
-  mov ah,9h
-  int 21h
-  pop ax
-  pop dx
-  pop ds
-};
+/* msg\help.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 69,116,104,101,114,68,70,83,32,118,48,46,56,32,47,32
+  S001 db 67,111,112,121,114,105,103,104,116,32,40,67,41,32,50,48
+  S002 db 49,55,32,77,97,116,101,117,115,122,32,86,105,115,116,101
+  S003 db 13,10,65,32,110,101,116,119,111,114,107,32,100,114,105,118
+  S004 db 101,32,102,111,114,32,68,79,83,44,32,114,117,110,110,105
+  S005 db 110,103,32,111,118,101,114,32,114,97,119,32,101,116,104,101
+  S006 db 114,110,101,116,13,10,13,10,85,115,97,103,101,58,32,101
+  S007 db 116,104,101,114,100,102,115,32,83,82,86,77,65,67,32,91
+  S008 db 77,65,67,47,93,114,100,114,118,45,108,100,114,118,32,91
+  S009 db 91,77,65,67,47,93,114,100,114,118,50,45,108,100,114,118
+  S00A db 50,32,46,46,46,93,32,91,111,112,116,105,111,110,115,93
+  S00B db 13,10,32,32,32,32,32,32,32,101,116,104,101,114,100,102
+  S00C db 115,32,47,117,13,10,32,32,32,32,32,32,32,101,116,104
+  S00D db 101,114,100,102,115,32,47,115,13,10,32,32,32,32,32,32
+  S00E db 32,101,116,104,101,114,100,102,115,32,47,108,13,10,32,32
+  S00F db 32,32,32,32,32,101,116,104,101,114,100,102,115,32,47,116
+  S010 db 61,70,73,76,69,13,10,13,10,79,112,116,105,111,110,115
+  S011 db 58,13,10,32,32,47,97,61,78,32,32,32,32,107,101,101
+  S012 db 112,32,102,105,108,101,32,97,116,116,114,105,98,117,116,101
+  S013 db 115,32,105,110,32,99,97,99,104,101,32,102,111,114,32,78
+  S014 db 32,115,101,99,111,110,100,115,44,32,48,46,46,54,48,32
+  S015 db 40,100,101,102,97,117,108,116,58,32,50,41,13,10,32,32
+  S016 db 47,98,61,78,32,32,32,32,117,115,101,32,78,32,114,101
+  S017 db 99,101,105,118,101,32,98,117,102,102,101,114,115,44,32,49
+  S018 db 46,46,56,32,40,100,101,102,97,117,108,116,58,32,52,41
+  S019 db 13,10,32,32,47,99,32,32,32,32,32,32,107,101,101,112
+  S01A db 32,69,116,104,101,114,68,70,83,32,105,110,32,99,111,110
+  S01B db 118,101,110,116,105,111,110,97,108,32,109,101,109,111,114,121
+  S01C db 32,40,110,111,32,85,77,66,44,32,110,111,32,88,77,83
+  S01D db 41,13,10,32,32,47,102,61,78,32,32,32,32,109,97,120
+  S01E db 32,102,114,97,109,101,32,115,105,122,101,32,105,110,32,98
+  S01F db 121,116,101,115,44,32,53,55,54,46,46,57,50,49,54,32
+  S020 db 40,97,117,116,111,100,101,116,101,99,116,32,111,116,104,101
+  S021 db 114,119,105,115,101,41,13,10,32,32,47,108,32,32,32,32
+  S022 db 32,32,107,101,101,112,32,108,97,116,101,110,99,121,32,104
+  S023 db 105,115,116,111,103,114,97,109,115,32,40,112,114,105,110,116
+  S024 db 32,116,104,101,109,32,119,105,116,104,32,39,101,116,104,101
+  S025 db 114,100,102,115,32,47,108,39,41,13,10,32,32,47,112,61
+  S026 db 88,88,32,32,32,117,115,101,32,112,97,99,107,101,116,32
+  S027 db 100,114,105,118,101,114,32,97,116,32,105,110,116,101,114,114
+  S028 db 117,112,116,32,88,88,32,40,97,117,116,111,100,101,116,101
+  S029 db 99,116,32,111,116,104,101,114,119,105,115,101,41,13,10,32
+  S02A db 32,47,113,32,32,32,32,32,32,113,117,105,101,116,32,109
+  S02B db 111,100,101,32,40,112,114,105,110,116,32,110,111,116,104,105
+  S02C db 110,103,32,105,102,32,108,111,97,100,101,100,32,115,117,99
+  S02D db 99,101,115,115,102,117,108,108,121,41,13,10,32,32,47,114
+  S02E db 61,78,32,32,32,32,117,115,101,32,78,32,114,101,97,100
+  S02F db 45,97,104,101,97,100,32,98,117,102,102,101,114,115,44,32
+  S030 db 48,46,46,52,32,40,100,101,102,97,117,108,116,58,32,50
+  S031 db 41,13,10,32,32,47,115,32,32,32,32,32,32,112,114,105
+  S032 db 110,116,32,115,116,97,116,105,115,116,105,99,115,32,111,102
+  S033 db 32,116,104,101,32,108,111,97,100,101,100,32,69,116,104,101
+  S034 db 114,68,70,83,13,10,32,32,47,116,61,78,32,32,32,32
+  S035 db 116,114,97,99,101,32,116,104,101,32,108,97,115,116,32,78
+  S036 db 32,99,97,108,108,115,44,32,49,46,46,49,48,48,48,32
+  S037 db 40,100,117,109,112,32,116,104,101,109,32,119,105,116,104,32
+  S038 db 39,101,116,104,101,114,100,102,115,32,47,116,61,70,73,76
+  S039 db 69,39,41,13,10,32,32,47,117,32,32,32,32,32,32,117
+  S03A db 110,108,111,97,100,32,69,116,104,101,114,68,70,83,32,102
+  S03B db 114,111,109,32,109,101,109,111,114,121,13,10,32,32,47,119
+  S03C db 61,78,32,32,32,32,117,115,101,32,78,32,119,114,105,116
+  S03D db 101,45,98,97,99,107,32,98,117,102,102,101,114,115,44,32
+  S03E db 48,46,46,52,32,40,100,101,102,97,117,108,116,58,32,49
+  S03F db 41,13,10,32,32,47,122,32,32,32,32,32,32,99,111,109
+  S040 db 112,114,101,115,115,32,102,105,108,101,32,100,97,116,97,32
+  S041 db 40,105,102,32,116,104,101,32,115,101,114,118,101,114,32,115
+  S042 db 117,112,112,111,114,116,115,32,105,116,41,13,10,13,10,85
+  S043 db 115,101,32,39,58,58,39,32,97,115,32,83,82,86,77,65
+  S044 db 67,32,102,111,114,32,115,101,114,118,101,114,32,97,117,116
+  S045 db 111,45,100,105,115,99,111,118,101,114,121,46,32,77,65,67
+  S046 db 47,32,109,97,112,115,32,97,32,100,114,105,118,101,32,102
+  S047 db 114,111,109,32,97,110,111,116,104,101,114,13,10,115,101,114
+  S048 db 118,101,114,32,116,104,97,110,32,83,82,86,77,65,67,44
+  S049 db 32,77,65,67,49,43,77,65,67,50,47,32,102,114,111,109
+  S04A db 32,97,32,115,101,114,118,101,114,32,119,105,116,104,32,97
+  S04B db 32,114,101,112,108,105,99,97,32,116,111,32,102,97,105,108
+  S04C db 32,111,118,101,114,32,116,111,46,13,10,13,10,69,120,97
+  S04D db 109,112,108,101,115,58,32,32,101,116,104,101,114,100,102,115
+  S04E db 32,54,100,58,52,102,58,52,97,58,52,100,58,52,57,58
+  S04F db 53,50,32,67,45,70,32,47,113,13,10,32,32,32,32,32
+  S050 db 32,32,32,32,32,32,101,116,104,101,114,100,102,115,32,58
+  S051 db 58,32,67,45,88,32,68,45,89,32,69,45,90,32,47,112
+  S052 db 61,54,70,13,10,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
@@ -0,0 +1,22 @@
+/* msg\histhdr.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 67,97,108,108,115,32,112,101,114,32,100,117,114,97,116,105
+  S001 db 111,110,44,32,115,112,101,110,116,32,111,110,32,116,104,101
+  S002 db 32,110,101,116,119,111,114,107,32,97,110,100,32,108,111,99
+  S003 db 97,108,108,121,58,13,10,65,76,32,32,32,116,105,109,101
+  S004 db 32,40,117,115,41,32,32,32,32,110,101,116,119,111,114,107
+  S005 db 32,32,32,32,32,32,108,111,99,97,108,13,10,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
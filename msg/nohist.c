@@ -0,0 +1,20 @@
+/* msg\nohist.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 76,97,116,101,110,99,121,32,104,105,115,116,111,103,114,97
+  S001 db 109,115,32,97,114,101,32,110,111,116,32,101,110,97,98,108
+  S002 db 101,100,32,40,108,111,97,100,32,69,116,104,101,114,68,70
+  S003 db 83,32,119,105,116,104,32,47,108,41,46,13,10,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
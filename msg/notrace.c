@@ -0,0 +1,20 @@
+/* msg\notrace.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 84,114,97,99,105,110,103,32,105,115,32,110,111,116,32,101
+  S001 db 110,97,98,108,101,100,32,40,108,111,97,100,32,69,116,104
+  S002 db 101,114,68,70,83,32,119,105,116,104,32,47,116,61,78,41
+  S003 db 46,13,10,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
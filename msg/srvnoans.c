@@ -0,0 +1,18 @@
+/* msg\srvnoans.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 87,97,114,110,105,110,103,58,32,110,111,32,97,110,115,119
+  S001 db 101,114,32,102,114,111,109,32,115,101,114,118,101,114,32,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
@@ -0,0 +1,19 @@
+/* msg\statcall.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 82,101,100,105,114,101,99,116,111,114,32,99,97,108,108,115
+  S001 db 32,40,115,117,98,102,117,110,99,116,105,111,110,58,32,99
+  S002 db 111,117,110,116,41,58,13,10,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
@@ -0,0 +1,18 @@
+/* msg\statign.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 70,114,97,109,101,115,32,105,103,110,111,114,101,100,58,32
+  S001 db 32,32,32,32,32,32,32,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
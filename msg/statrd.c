@@ -0,0 +1,18 @@
+/* msg\statrd.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 66,121,116,101,115,32,114,101,97,100,58,32,32,32,32,32
+  S001 db 32,32,32,32,32,32,32,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
@@ -0,0 +1,18 @@
+/* msg\statrexm.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 82,101,116,114,97,110,115,109,105,115,115,105,111,110,115,58
+  S001 db 32,32,32,32,32,32,32,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
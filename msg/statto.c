@@ -0,0 +1,18 @@
+/* msg\statto.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 81,117,101,114,105,101,115,32,116,105,109,101,100,32,111,117
+  S001 db 116,58,32,32,32,32,32,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
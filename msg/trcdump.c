@@ -0,0 +1,18 @@
+/* msg\trcdump.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 84,114,97,99,101,32,114,101,99,111,114,100,115,32,119,114
+  S001 db 105,116,116,101,110,58,32,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
@@ -0,0 +1,19 @@
+/* msg\trcfail.c: THIS FILE IS AUTO-GENERATED BY GENMSG.C -- DO NOT MODIFY! */
+_asm {
+  push ds
+  push dx
+  push ax
+  call getip
+  S000 db 70,97,105,108,101,100,32,116,111,32,119,114,105,116,101,32
+  S001 db 116,104,101,32,116,114,97,99,101,32,102,105,108,101,46,13
+  S002 db 10,'$'
+ getip:
+  pop dx
+  push cs
+  pop ds
+  mov ah,9h
+  int 21h
+  pop ax
+  pop dx
+  pop ds
+};
@@ -1,6 +1,6 @@
-/* program version and date */
-#define PVER "0.8"
-#define PDATE "2017"
-
-/* protocol version */
-#define PROTOVER 2
+/* program version and date */
+#define PVER "0.8"
+#define PDATE "2017"
+
+/* protocol version */
+#define PROTOVER 2